@@ -0,0 +1,233 @@
+#include "page_codec.h"
+#include "dberror.h"
+#include <stdint.h>
+#include <string.h>
+
+/* LZ codec - Begin */
+
+/*
+ * The LZ codec writes a sequence of tokens. A token byte holds the number of literals in its high
+ * nibble and the match length minus LZ_MIN_MATCH in its low nibble, a nibble of 15 continues in
+ * extra bytes of 255 that end with a smaller byte. The literals follow the token, then the two byte
+ * little endian distance of the match. The last token has no match and ends with the input.
+ */
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_DISTANCE 0xFFFF
+#define LZ_HASH_BITS 12
+
+/**
+ * Method to store a length that did not fit into its nibble. Returns the new output position or -1.
+ **/
+static int lzPutLength(unsigned char *out, int outPos, int capacity, int length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        if (outPos >= capacity)
+        {
+            return -1;
+        }
+        out[outPos++] = 255;
+    }
+    if (outPos >= capacity)
+    {
+        return -1;
+    }
+    out[outPos++] = (unsigned char)length;
+    return outPos;
+}
+
+/**
+ * Method to read the extra bytes of a length. Returns the new input position or -1 at the end of the input.
+ **/
+static int lzGetLength(const unsigned char *in, int inPos, int inLength, int *length)
+{
+    unsigned char byte;
+    do
+    {
+        if (inPos >= inLength)
+        {
+            return -1;
+        }
+        byte = in[inPos++];
+        *length += byte;
+    } while (byte == 255);
+    return inPos;
+}
+
+/**
+ * Method to write a token with its literals and, if matchLength is not 0, its match.
+ * Returns the new output position or -1 when the output is full.
+ **/
+static int lzEmit(unsigned char *out, int outPos, int capacity, const unsigned char *literals, int literalLength, int distance, int matchLength)
+{
+    int matchCode = (matchLength > 0) ? matchLength - LZ_MIN_MATCH : 0;
+    if (outPos >= capacity)
+    {
+        return -1;
+    }
+    out[outPos++] = (unsigned char)(((literalLength < 15) ? literalLength : 15) << 4 | ((matchCode < 15) ? matchCode : 15));
+    if (literalLength >= 15 && (outPos = lzPutLength(out, outPos, capacity, literalLength - 15)) < 0)
+    {
+        return -1;
+    }
+    if (outPos + literalLength > capacity)
+    {
+        return -1;
+    }
+    memcpy(out + outPos, literals, literalLength);
+    outPos += literalLength;
+
+    if (matchLength > 0)
+    {
+        if (outPos + 2 > capacity)
+        {
+            return -1;
+        }
+        out[outPos++] = (unsigned char)(distance & 0xFF);
+        out[outPos++] = (unsigned char)(distance >> 8);
+        if (matchCode >= 15 && (outPos = lzPutLength(out, outPos, capacity, matchCode - 15)) < 0)
+        {
+            return -1;
+        }
+    }
+    return outPos;
+}
+
+/**
+ * Method to compress with the LZ codec. Matches are found through a hash table of the last position of
+ * every four byte sequence, which is fast and finds the long runs of repeated text in record pages.
+ **/
+static int lzCompress(const char *src, int srcLength, char *dst, int dstCapacity)
+{
+    const unsigned char *in = (const unsigned char *)src;
+    unsigned char *out = (unsigned char *)dst;
+    int table[1 << LZ_HASH_BITS];
+    int pos = 0;
+    int anchor = 0; // first byte not yet written
+    int outPos = 0;
+
+    for (int i = 0; i < (1 << LZ_HASH_BITS); i++)
+    {
+        table[i] = -1;
+    }
+
+    while (pos + LZ_MIN_MATCH <= srcLength)
+    {
+        uint32_t sequence;
+        memcpy(&sequence, in + pos, sizeof(sequence));
+        int hash = (int)((sequence * 2654435761u) >> (32 - LZ_HASH_BITS));
+        int candidate = table[hash];
+        table[hash] = pos;
+        if (candidate < 0 || pos - candidate > LZ_MAX_DISTANCE || memcmp(in + candidate, in + pos, LZ_MIN_MATCH) != 0)
+        {
+            pos++;
+            continue;
+        }
+
+        int matchLength = LZ_MIN_MATCH;
+        while (pos + matchLength < srcLength && in[candidate + matchLength] == in[pos + matchLength])
+        {
+            matchLength++;
+        }
+        outPos = lzEmit(out, outPos, dstCapacity, in + anchor, pos - anchor, pos - candidate, matchLength);
+        if (outPos < 0)
+        {
+            return -1;
+        }
+        pos += matchLength;
+        anchor = pos;
+    }
+    return lzEmit(out, outPos, dstCapacity, in + anchor, srcLength - anchor, 0, 0); // the remaining literals
+}
+
+/**
+ * Method to decompress with the LZ codec, every length and distance is checked against the buffers.
+ **/
+static int lzDecompress(const char *src, int srcLength, char *dst, int dstCapacity)
+{
+    const unsigned char *in = (const unsigned char *)src;
+    unsigned char *out = (unsigned char *)dst;
+    int inPos = 0;
+    int outPos = 0;
+
+    while (inPos < srcLength)
+    {
+        int token = in[inPos++];
+        int literalLength = token >> 4;
+        if (literalLength == 15 && (inPos = lzGetLength(in, inPos, srcLength, &literalLength)) < 0)
+        {
+            return -1;
+        }
+        if (inPos + literalLength > srcLength || outPos + literalLength > dstCapacity)
+        {
+            return -1;
+        }
+        memcpy(out + outPos, in + inPos, literalLength);
+        inPos += literalLength;
+        outPos += literalLength;
+        if (inPos == srcLength) // the last token has no match
+        {
+            break;
+        }
+
+        if (inPos + 2 > srcLength)
+        {
+            return -1;
+        }
+        int distance = in[inPos] | (in[inPos + 1] << 8);
+        inPos += 2;
+        int matchLength = token & 15;
+        if (matchLength == 15 && (inPos = lzGetLength(in, inPos, srcLength, &matchLength)) < 0)
+        {
+            return -1;
+        }
+        matchLength += LZ_MIN_MATCH;
+        if (distance == 0 || distance > outPos || outPos + matchLength > dstCapacity)
+        {
+            return -1;
+        }
+        for (int i = 0; i < matchLength; i++) // byte by byte, a match may overlap the bytes it produces
+        {
+            out[outPos] = out[outPos - distance];
+            outPos++;
+        }
+    }
+    return outPos;
+}
+
+/* LZ codec - End */
+
+/* codec registry - Begin */
+
+static const SM_PageCodec lzCodec = {SM_CODEC_LZ, "lz", lzCompress, lzDecompress};
+
+static const SM_PageCodec *codecs[SM_MAX_CODECS] = {NULL, &lzCodec};
+
+/**
+ * Method to make a codec available to page files. The id must be unused.
+ **/
+RC registerPageCodec(const SM_PageCodec *codec)
+{
+    if (codec == NULL || codec->id <= SM_CODEC_NONE || codec->id >= SM_MAX_CODECS || codecs[codec->id] != NULL ||
+        codec->compress == NULL || codec->decompress == NULL)
+    {
+        printError(RC_INVALID_PARAMETER);
+        return RC_INVALID_PARAMETER;
+    }
+    codecs[codec->id] = codec;
+    return RC_OK;
+}
+
+/**
+ * Method to look up the codec with the given id. Returns NULL for SM_CODEC_NONE and unknown ids.
+ **/
+const SM_PageCodec *findPageCodec(int id)
+{
+    if (id <= SM_CODEC_NONE || id >= SM_MAX_CODECS)
+    {
+        return NULL;
+    }
+    return codecs[id];
+}
+
+/* codec registry - End */
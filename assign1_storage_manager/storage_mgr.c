@@ -1,326 +1,3418 @@
+#define _GNU_SOURCE // preadv/pwritev, IOV_MAX, fallocate, O_DIRECT
+#define _FILE_OFFSET_BITS 64 // off_t is 64 bits wide on 32 bit systems as well
 #include "storage_mgr.h"
+#include "page_codec.h"
+#include "log_mgr.h"
 #include "dberror.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <limits.h>
+#include <time.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define HAVE_IO_URING 1
+#endif
+#endif
 
 int curPagePos;
 
-/* manipulating page files - Begin */
+/* I/O statistics helpers - Begin */
 
-/*
-Initialize storage manager
-*/
-void initStorageManager(void)
+/**
+ * Method to add n to a statistics counter, counters are also updated by the asynchronous workers.
+ **/
+static void addStat(long long *counter, long long n)
 {
-    printf("Begin Execution");
+    __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
 }
 
 /**
- * Method to create new page fileName. The initial file size is one page and fills the
- * single page with ’\0’ bytes.
+ * Method to read the monotonic clock in nanoseconds.
  **/
-RC createPageFile(char *fileName)
+static long long nowNanos(void)
 {
-    FILE *fPtr; // pointer for the file
-
-    fPtr = fopen(fileName, "r"); // Open the file in read mode
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
 
-    if (fPtr == NULL) // Condition to check if file exists
-    {
-        fPtr = fopen(fileName, "w");        // Creates a new file to write
-        for (int i = 0; i < PAGE_SIZE; i++) // Iterates through the size of the page
-            fputc('\0', fPtr);              // Writes single \0 at a time. Fills the entire single page in a file with \0
-    }
-    else // If the file already exists
+/**
+ * Method to count a call that took nanos nanoseconds in its log2 bucket of histogram.
+ **/
+static void recordLatency(long long histogram[SM_LATENCY_BUCKETS], long long nanos)
+{
+    int bucket = 0;
+    while (nanos > 1 && bucket < SM_LATENCY_BUCKETS - 1) // the last bucket also takes everything slower
     {
-        for (int i = 0; i < PAGE_SIZE; i++) // Iterates through the size of the page
-            fputc('\0', fPtr);              // Writes single \0 at a time. Overwrites the entire single page with \0
+        nanos >>= 1;
+        bucket++;
     }
-
-    fclose(fPtr); // closes the file
-
-    return RC_OK;
+    addStat(&histogram[bucket], 1);
 }
 
 /**
- * Opens an existing page file.Should return RC FILE NOT FOUND if the file does not exist.
- * – The second parameter is an existing file handle.
- * – If opening the file is successful, then the fields of this file handle should be initialized with
- * the information about the opened file.
- * For instance, you would have to read the total number of pages that are stored in the file from disk.
- * */
-
-RC openPageFile(char *fileName, SM_FileHandle *fHandle)
+ * Method to count count pages transferred by a read or write.
+ **/
+static void recordPages(SM_FileStats *stats, int count, size_t pageSize, int isWrite)
 {
-    FILE *fptr;
+    addStat(isWrite ? &stats->writes : &stats->reads, count);
+    addStat(isWrite ? &stats->bytesWritten : &stats->bytesRead, (long long)count * pageSize);
+}
 
-    fptr = fopen(fileName, "r"); // Open the file in read mode
+/* I/O statistics helpers - End */
 
-    if (fptr != NULL) // If file exists
-    {
-        fHandle->fileName = fileName; // assigning filename to the filename in file handle
+/* segment files - Begin */
 
-        long position = ftell(fptr);    // fetches the current position of the pointer
-        fHandle->curPagePos = position; // assigning the current position of the pointer to the curPagePos in file handle
+/**
+ * A segment file of a segmented page file
+ */
+typedef struct SM_Segment
+{
+    int fd;
+    int dirty; // written since the last sync
+} SM_Segment;
 
-        fseek(fptr, 0, SEEK_END);            // moves the pointer to the end of the file
-        long size = ftell(fptr);             // fetches the current position of the pointer which gives the total file size
-        long totalpages = size / PAGE_SIZE;  // dividing the file size with the page size
-        fHandle->totalNumPages = totalpages; // assigning the total number if pages stored in the file from disk to totalNumPages in file handle
+/**
+ * Segment files of an open segmented page file. The list only grows in the thread doing the I/O,
+ * the sync thread reads it, so changes to the list and the dirty flags are made under the lock.
+ */
+typedef struct SM_SegmentTable
+{
+    pthread_mutex_t lock;
+    char *fileName; // name of segment 0, segment k is named fileName.k
+    int openFlags;  // flags of open() for the segment files
+    SM_Segment *entries;
+    int count;
+} SM_SegmentTable;
 
-        fHandle->mgmtInfo = fptr; // assigning the file pointer information to mgmtInfo in file handle
+/**
+ * Where a byte offset of the logical page file is stored
+ */
+typedef struct SM_FilePos
+{
+    int fd;
+    int segment; // 0 for a page file that is a single file
+    off_t offset; // offset inside the segment file
+    off_t room;   // bytes from offset to the end of the segment
+} SM_FilePos;
 
-        return RC_OK;
-    }
-    printError(RC_FILE_NOT_FOUND);
-    // perror("[ERROR] File not found\n");
-    return RC_FILE_NOT_FOUND; // returns RC_FILE_NOT_FOUND error code of the file does not exists
+/**
+ * Method to build the name of segment file segment of fileName, the name is released with free().
+ **/
+static char *segmentName(const char *fileName, int segment)
+{
+    size_t length = strlen(fileName) + 16;
+    char *name = (char *)malloc(length);
+    snprintf(name, length, "%s.%d", fileName, segment);
+    return name;
 }
 
 /**
- * Close an open page file
+ * Method to remove the segment files of fileName behind segment first, up to the first one missing.
  **/
-RC closePageFile(SM_FileHandle *fHandle)
+static void removeSegments(const char *fileName, int first)
 {
-    if (fHandle != NULL) // condition to check if file handle is initialized
+    for (int segment = first;; segment++)
     {
-        if (fHandle->mgmtInfo != NULL) // checks if file handle file pointer is not null. If its not null, the file is open
-        {
-            return fclose(fHandle->mgmtInfo); // closes the file
-        }
-        else
+        char *name = segmentName(fileName, segment);
+        int removed = unlink(name) == 0;
+        free(name);
+        if (!removed)
         {
-            printError(RC_FILE_NOT_FOUND);
-            // perror("[ERROR] File not found\n");
-            return RC_FILE_NOT_FOUND; // If file handle file pointer is null, file is not open or already closed, then retuns error code
+            break;
         }
     }
+}
 
-    printError(RC_FILE_HANDLE_NOT_INIT);
-    // perror("[ERROR] File handle is not initialized\n");
-    return RC_FILE_HANDLE_NOT_INIT; // returns error code if file handle is not initialized
+/**
+ * Method to compute the number of bytes of pages held by each segment file.
+ **/
+static off_t segmentBytes(SM_FileInfo *fInfo)
+{
+    return (off_t)fInfo->segmentPages * fInfo->pageSize;
 }
 
 /**
- *  Destroy (delete) a page file
+ * Method to remember that segment was written, so the next sync includes it.
  **/
-RC destroyPageFile(char *fileName)
+static void markSegmentDirty(SM_FileInfo *fInfo, int segment)
 {
-    if (remove(fileName) == 0) // Deletes the file
+    SM_SegmentTable *table = fInfo->segments;
+    if (table != NULL)
     {
-        return RC_OK; // returns 0 when file is successfully deleted
+        pthread_mutex_lock(&table->lock);
+        table->entries[segment].dirty = 1;
+        pthread_mutex_unlock(&table->lock);
     }
-    printError(RC_FILE_NOT_FOUND);
-    // perror("[ERROR] File not found\n");
-    return RC_FILE_NOT_FOUND; // returns error code otherwise
 }
 
-/* manipulating page files - End */
+/**
+ * Method to get the descriptor of segment file segment, creating it and the segments before it when create is set.
+ * A segment is only created behind full segments, so the segments before a new one are filled up to their full size.
+ * Returns -1 when the segment does not exist and create is not set or when it cannot be created.
+ **/
+static int openSegment(SM_FileInfo *fInfo, int segment, int create)
+{
+    SM_SegmentTable *table = fInfo->segments;
+    if (segment < table->count)
+    {
+        return table->entries[segment].fd;
+    }
+    if (!create)
+    {
+        return -1;
+    }
 
-/* reading blocks from disc - Begin */
+    while (table->count <= segment)
+    {
+        int last = table->count - 1;
+        off_t full = segmentBytes(fInfo) + ((last == 0) ? fInfo->dataOffset : 0); // segment 0 also holds the header
+        struct stat st;
+        addStat(&fInfo->stats.syscalls, 1);
+        if (fstat(table->entries[last].fd, &st) != 0)
+        {
+            return -1;
+        }
+        if (st.st_size < full) // pages at the end of the last segment were never written
+        {
+            addStat(&fInfo->stats.syscalls, 1);
+            if (ftruncate(table->entries[last].fd, full) != 0)
+            {
+                return -1;
+            }
+            markSegmentDirty(fInfo, last);
+        }
+
+        char *name = segmentName(table->fileName, table->count);
+        int fd = open(name, O_RDWR | O_CREAT | O_TRUNC | table->openFlags, 0644); // drops what an interrupted run left behind
+        free(name);
+        addStat(&fInfo->stats.syscalls, 1);
+        if (fd < 0)
+        {
+            return -1;
+        }
+
+        pthread_mutex_lock(&table->lock);
+        table->entries = (SM_Segment *)realloc(table->entries, (table->count + 1) * sizeof(SM_Segment));
+        table->entries[table->count].fd = fd;
+        table->entries[table->count].dirty = 1; // a new file has to reach the disk with its directory entry
+        table->count++;
+        pthread_mutex_unlock(&table->lock);
+    }
+    return table->entries[segment].fd;
+}
 
 /**
- * Method to reads the block at position pageNum from a file and stores its content in the memory pointed
- * to by the memPage page handle.
- * If the file has less than pageNum pages, the method should return RC READ NON EXISTING PAGE.
+ * Method to find where byte offset of the logical page file is stored. With create set, a write
+ * behind the last segment creates the segments up to the one holding offset.
+ * Returns 0 on success and -1 when the segment does not exist or cannot be created.
  **/
-RC readBlock(int pageNum, SM_FileHandle *filehandle, SM_PageHandle memPage)
+static int locate(SM_FileInfo *fInfo, off_t offset, int create, SM_FilePos *pos)
 {
-    if (filehandle == NULL)
+    if (fInfo->segments == NULL) // a single file holds everything
     {
-        printError(RC_FILE_HANDLE_NOT_INIT);
-        // perror("[ERROR] File handle is not initialized\n");
-        return RC_FILE_HANDLE_NOT_INIT;
+        pos->fd = fInfo->fd;
+        pos->segment = 0;
+        pos->offset = offset;
+        pos->room = (off_t)INT64_MAX - offset;
+        return 0;
     }
 
-    if (pageNum > filehandle->totalNumPages || pageNum < 0)
+    off_t size = segmentBytes(fInfo);
+    int segment = (offset < fInfo->dataOffset) ? 0 : (int)((offset - fInfo->dataOffset) / size);
+    off_t start = (segment == 0) ? 0 : fInfo->dataOffset + segment * size; // logical offset of the first byte of the segment
+    pos->fd = openSegment(fInfo, segment, create);
+    pos->segment = segment;
+    pos->offset = offset - start;
+    pos->room = fInfo->dataOffset + (segment + 1) * size - offset;
+    return (pos->fd < 0) ? -1 : 0;
+}
+
+/**
+ * Method to set the size of the logical page file to size bytes. Segment files are created as
+ * the file grows and removed when it shrinks below their start.
+ * Returns 0 on success and -1 on an error.
+ **/
+static int resizeFile(SM_FileInfo *fInfo, off_t size)
+{
+    SM_FilePos pos;
+    addStat(&fInfo->stats.syscalls, 1);
+    if (locate(fInfo, size - 1, 1, &pos) != 0 || ftruncate(pos.fd, pos.offset + 1) != 0)
     {
-        printError(RC_READ_NON_EXISTING_PAGE);
-        // perror("[ERROR] Invalid request to read non existing page\n");
-        return RC_READ_NON_EXISTING_PAGE;
+        return -1;
     }
+    markSegmentDirty(fInfo, pos.segment);
 
-    fseek(filehandle->mgmtInfo, (((pageNum)*PAGE_SIZE)), SEEK_SET);
-
-    if (fread(memPage, 1, PAGE_SIZE, filehandle->mgmtInfo) != PAGE_SIZE)
+    SM_SegmentTable *table = fInfo->segments;
+    if (table != NULL && table->count > pos.segment + 1) // segments behind the new end
     {
-        printError(RC_READ_NON_EXISTING_PAGE);
-        // perror("[ERROR] Invalid request to read non existing page\n");
-        return RC_READ_NON_EXISTING_PAGE;
+        pthread_mutex_lock(&table->lock);
+        for (int i = pos.segment + 1; i < table->count; i++)
+        {
+            close(table->entries[i].fd);
+        }
+        table->count = pos.segment + 1;
+        pthread_mutex_unlock(&table->lock);
+        removeSegments(table->fileName, pos.segment + 1);
     }
+    return 0;
+}
 
-    filehandle->curPagePos = (ftell(filehandle->mgmtInfo) / PAGE_SIZE);
-    printf("[INFO] Current page pos : %d\n", filehandle->curPagePos);
-    fclose(filehandle->mgmtInfo);
-    return RC_OK;
+/**
+ * Method to reserve disk space for length bytes at offset of the logical page file with fallocate.
+ * Space is only reserved in segments that exist, a segment is only created when pages are written to it.
+ **/
+static void reserveRange(SM_FileInfo *fInfo, off_t offset, off_t length)
+{
+    SM_FilePos pos;
+    while (length > 0 && locate(fInfo, offset, 0, &pos) == 0)
+    {
+        off_t part = (length < pos.room) ? length : pos.room;
+        // reserving is only an optimization, file systems without fallocate grow through ftruncate alone
+        fallocate(pos.fd, FALLOC_FL_KEEP_SIZE, pos.offset, part);
+        addStat(&fInfo->stats.syscalls, 1);
+        offset += part;
+        length -= part;
+    }
 }
 
 /**
- * Method to retrieve the current page position in a file.
+ * Method to open the segment files behind segment 0 of a segmented page file. Every segment file that exists is
+ * opened, empty ones at the end are left over from an interrupted growth and removed.
+ * Stores the size of the logical page file in fileSize.
  **/
-int getBlockPos(SM_FileHandle *filehandle)
+static void openSegments(SM_FileInfo *fInfo, char *fileName, int openFlags, off_t *fileSize)
 {
-    if (filehandle == NULL)
+    SM_SegmentTable *table = (SM_SegmentTable *)calloc(1, sizeof(SM_SegmentTable));
+    pthread_mutex_init(&table->lock, NULL);
+    table->fileName = strdup(fileName);
+    table->openFlags = openFlags;
+    table->entries = (SM_Segment *)malloc(sizeof(SM_Segment));
+    table->entries[0].fd = fInfo->fd;
+    table->entries[0].dirty = 0;
+    table->count = 1;
+    fInfo->segments = table;
+
+    int lastUsed = 0;
+    off_t lastSize = *fileSize;
+    while (1)
     {
-        printError(RC_FILE_HANDLE_NOT_INIT);
-        // printError("[ERROR] File handle is not initialized\n");
-        return RC_FILE_HANDLE_NOT_INIT;
+        char *name = segmentName(fileName, table->count);
+        int fd = open(name, O_RDWR | openFlags);
+        free(name);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            break;
+        }
+        table->entries = (SM_Segment *)realloc(table->entries, (table->count + 1) * sizeof(SM_Segment));
+        table->entries[table->count].fd = fd;
+        table->entries[table->count].dirty = 0;
+        if (st.st_size > 0)
+        {
+            lastUsed = table->count;
+            lastSize = st.st_size;
+        }
+        table->count++;
     }
 
-    if ((fopen(filehandle->fileName, "r")) == NULL)
+    for (int i = lastUsed + 1; i < table->count; i++)
     {
-        printError(RC_FILE_HANDLE_NOT_INIT);
-        // perror("[ERROR] File handle is not initialized\n");
-        return RC_FILE_NOT_FOUND;
+        close(table->entries[i].fd);
+    }
+    if (lastUsed + 1 < table->count)
+    {
+        table->count = lastUsed + 1;
+        removeSegments(fileName, lastUsed + 1);
     }
 
-    printf("%d ", filehandle->curPagePos);
-    return filehandle->curPagePos;
+    *fileSize = (lastUsed == 0) ? lastSize : fInfo->dataOffset + lastUsed * segmentBytes(fInfo) + lastSize;
 }
 
 /**
- * Method to read the first respective last page in a file.
+ * Method to close the segment files of a segmented page file, segment 0 is closed by the caller.
  **/
-RC readFirstBlock(SM_FileHandle *filehandle, SM_PageHandle memPage)
+static void closeSegments(SM_FileInfo *fInfo)
 {
-    return readBlock(0, filehandle, memPage);
+    SM_SegmentTable *table = fInfo->segments;
+    if (table == NULL)
+    {
+        return;
+    }
+    for (int i = 1; i < table->count; i++)
+    {
+        close(table->entries[i].fd);
+    }
+    pthread_mutex_destroy(&table->lock);
+    free(table->entries);
+    free(table->fileName);
+    free(table);
+    fInfo->segments = NULL;
 }
 
+/* segment files - End */
+
+/* positional I/O helpers - Begin */
+
 /**
- * Method to read the previous page relative to the curPagePos of the file.
+ * Method to compute the file offset of page pageNum. In a file with free page bitmaps every
+ * group of pagesPerMap pages is preceded by the bitmap page describing it.
  **/
-RC readPreviousBlock(SM_FileHandle *filehandle, SM_PageHandle memPage)
+static off_t pageOffset(SM_FileInfo *fInfo, int pageNum)
 {
-    curPagePos = getBlockPos(filehandle) - 1;
-    return readBlock(curPagePos, filehandle, memPage);
+    off_t physical = pageNum;
+    if (fInfo->pagesPerMap > 0) // skips the bitmap pages up to and including the one of this group
+    {
+        physical += pageNum / fInfo->pagesPerMap + 1;
+    }
+    return fInfo->dataOffset + physical * fInfo->pageSize;
 }
 
 /**
- * Method to read the current page relative to the curPagePos of the file.
+ * Method to compute the number of pages in a file of fileSize bytes.
  **/
-RC readCurrentBlock(SM_FileHandle *filehandle, SM_PageHandle memPage)
+static int countPages(SM_FileInfo *fInfo, off_t fileSize)
 {
-    curPagePos = getBlockPos(filehandle);
-    return readBlock(curPagePos, filehandle, memPage);
+    off_t physical = (fileSize - fInfo->dataOffset) / fInfo->pageSize;
+    if (fInfo->pagesPerMap > 0) // every started group has its bitmap page
+    {
+        physical -= (physical + fInfo->pagesPerMap) / (fInfo->pagesPerMap + 1);
+    }
+    return (int)physical;
 }
 
-// Method to read the next page relative to the curPagePos of the file.
-RC readNextBlock(SM_FileHandle *filehandle, SM_PageHandle memPage)
+/**
+ * Method to read len bytes at offset into buf, retrying short and interrupted reads.
+ * Returns the number of bytes read, which is less than len only at end of file.
+ * The system calls are counted in stats unless it is NULL.
+ **/
+static ssize_t readFully(int fd, void *buf, size_t len, off_t offset, SM_FileStats *stats)
 {
-    curPagePos = getBlockPos(filehandle) + 1;
-    return readBlock(curPagePos, filehandle, memPage);
+    size_t done = 0;
+    while (done < len)
+    {
+        ssize_t n = pread(fd, (char *)buf + done, len - done, offset + done);
+        if (stats != NULL)
+            addStat(&stats->syscalls, 1);
+        if (n < 0 && errno == EINTR) // interrupted by a signal, try again
+            continue;
+        if (n <= 0) // error or end of file
+            return (n < 0) ? -1 : (ssize_t)done;
+        done += n;
+    }
+    return (ssize_t)done;
 }
 
 /**
- * Method to read the last page of the file.
+ * Method to write len bytes from buf at offset, retrying short and interrupted writes.
+ * The system calls are counted in stats unless it is NULL.
  **/
-RC readLastBlock(SM_FileHandle *filehandle, SM_PageHandle memPage)
+static ssize_t writeFully(int fd, const void *buf, size_t len, off_t offset, SM_FileStats *stats)
 {
-    curPagePos = (filehandle->totalNumPages) - 1;
-    return readBlock(curPagePos, filehandle, memPage);
+    size_t done = 0;
+    while (done < len)
+    {
+        ssize_t n = pwrite(fd, (const char *)buf + done, len - done, offset + done);
+        if (stats != NULL)
+            addStat(&stats->syscalls, 1);
+        if (n < 0 && errno == EINTR) // interrupted by a signal, try again
+            continue;
+        if (n < 0)
+            return -1;
+        done += n;
+    }
+    return (ssize_t)done;
 }
 
-/* reading blocks from disc - End */
+/**
+ * Method to transfer a run of pages described by iov starting at offset with as few preadv/pwritev calls as possible.
+ * The iov array is consumed. Returns 0 on success and -1 on an error or a read past the end of the file.
+ **/
+static int transferVector(int fd, struct iovec *iov, int iovcnt, off_t offset, int isWrite, SM_FileStats *stats)
+{
+    while (iovcnt > 0)
+    {
+        int batch = (iovcnt < IOV_MAX) ? iovcnt : IOV_MAX; // the kernel accepts at most IOV_MAX buffers per call
+        ssize_t n = isWrite ? pwritev(fd, iov, batch, offset) : preadv(fd, iov, batch, offset);
+        addStat(&stats->syscalls, 1);
+        if (n < 0 && errno == EINTR) // interrupted by a signal, try again
+            continue;
+        if (n <= 0) // error or end of file
+            return -1;
 
-/* writing blocks to a page file - Begin */
+        offset += n;
+        while (n > 0) // skip the buffers that were transferred completely, resume inside a partial one
+        {
+            if ((size_t)n >= iov->iov_len)
+            {
+                n -= iov->iov_len;
+                iov++;
+                iovcnt--;
+            }
+            else
+            {
+                iov->iov_base = (char *)iov->iov_base + n;
+                iov->iov_len -= n;
+                n = 0;
+            }
+        }
+    }
+    return 0;
+}
 
 /**
- * Method to write a page to disk at an absolute position
+ * Method to check if buf has to go through an aligned bounce buffer, which is the case
+ * for unaligned buffers of a file opened with SM_OPEN_DIRECT.
  **/
-RC writeBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
+static int needsBounce(SM_FileInfo *fInfo, const void *buf)
+{
+    return (fInfo->flags & SM_OPEN_DIRECT) && ((uintptr_t)buf % SM_DIRECT_IO_ALIGNMENT) != 0;
+}
+
+/**
+ * Method to read or write the page at offset from buf. Returns the number of bytes transferred.
+ **/
+static ssize_t transferPage(SM_FileInfo *fInfo, char *buf, off_t offset, int isWrite)
 {
-    if (fHandle != NULL) // checking if file handle is initialized
+    SM_FilePos pos;
+    if (locate(fInfo, offset, isWrite, &pos) != 0) // a read of a segment that does not exist reads nothing
     {
-        FILE *fptr;
-        fptr = fopen(fHandle->fileName, "r+");                                    // opening the file in read and write mode
-        if (pageNum >= 0 && pageNum <= fHandle->totalNumPages && memPage != NULL) // checking if page number is in range and mempage is initialized
-        {
-            long absPos = pageNum * PAGE_SIZE;   // calculating the absolute position
-            fseek(fptr, absPos, SEEK_SET);       // pointer is moved to the begginning of the specified pages
-            fwrite(memPage, PAGE_SIZE, 1, fptr); // writes block of data of size memPage to the file specified
+        return isWrite ? -1 : 0;
+    }
 
-            fHandle->mgmtInfo = fptr;                        // updating fhandle pointer information
-            fseek(fptr, curPagePos * PAGE_SIZE, SEEK_SET);   // pointer is moved to the beginning of the specified page
-            fHandle->curPagePos = (ftell(fptr) / PAGE_SIZE); // calculates the currentPage position and updates teh fhandle
-            return RC_OK;                                    // returns successful response
+    char *io = buf;
+    if (needsBounce(fInfo, buf))
+    {
+        io = allocPageBuffer(1, fInfo->pageSize);
+        if (io == NULL)
+        {
+            return -1;
         }
-        else
+        if (isWrite)
         {
-            printError(RC_WRITE_FAILED);
-            // perror("[ERROR] PageNum out of bound\n");
-            return RC_WRITE_FAILED; // retuns error code when pagenumber is out of bound
+            memcpy(io, buf, fInfo->pageSize);
         }
     }
-    else
+
+    ssize_t n = isWrite ? writeFully(pos.fd, io, fInfo->pageSize, pos.offset, &fInfo->stats)
+                        : readFully(pos.fd, io, fInfo->pageSize, pos.offset, &fInfo->stats);
+    if (isWrite && n > 0)
     {
-        printError(RC_FILE_HANDLE_NOT_INIT);
-        // perror("[ERROR] File handle is not initialized\n");
-        return RC_FILE_HANDLE_NOT_INIT; // returns error code if the file is not initialized
+        markSegmentDirty(fInfo, pos.segment);
     }
-}
 
-/**
- * Method to write a page to disk at the current position.
- **/
-RC writeCurrentBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
-{
-    return writeBlock(getBlockPos(fHandle), fHandle, memPage); // passing the current page position to write block
+    if (io != buf) // copies the page read out of the bounce buffer
+    {
+        if (!isWrite && n > 0)
+        {
+            memcpy(buf, io, n);
+        }
+        free(io);
+    }
+    return n;
 }
 
 /**
- * Method to increase the number of pages in the file by one.
- * The new last page should be filled with zero bytes.
+ * Method to read or write count adjacent pages at offset from the buffers memPages[0..count-1], the pages must be in one segment.
+ * If any buffer needs a bounce buffer, the whole run goes through a single aligned one.
+ * Returns 0 on success and -1 on an error or a read past the end of the file.
  **/
-RC appendEmptyBlock(SM_FileHandle *fHandle)
+static int transferRun(SM_FileInfo *fInfo, SM_PageHandle memPages[], int count, off_t offset, int isWrite)
 {
-    if (fHandle != NULL) // checks if file handle is initialized
+    SM_FilePos pos;
+    if (locate(fInfo, offset, isWrite, &pos) != 0)
+    {
+        return -1;
+    }
+
+    char *bounce = NULL;
+    for (int i = 0; i < count && bounce == NULL; i++)
     {
-        FILE *fPtr;
-        fPtr = fopen(fHandle->fileName, "r+"); // opens the file in read write mode
-        if (fPtr != NULL)                      // if file is present
+        if (needsBounce(fInfo, memPages[i]))
         {
-            fseek(fPtr, 0, SEEK_END);           // moves the cursor to end of the page
-            for (int i = 0; i < PAGE_SIZE; i++) // Iterates through the size of the page to create empty page
+            bounce = allocPageBuffer(count, fInfo->pageSize);
+            if (bounce == NULL)
             {
-                fputc('\0', fPtr); // fills the entire page with zero bytes
+                return -1;
             }
+        }
+    }
 
-            fHandle->mgmtInfo = fPtr;                           // file pointer information is moved to file handle
-            fHandle->totalNumPages = (ftell(fPtr) / PAGE_SIZE); // number of pages is increased by 1
-            fHandle->curPagePos = fHandle->totalNumPages;       // updating current page position
-            return RC_OK;                                       // return successful response
+    size_t pageSize = fInfo->pageSize;
+    int iovcnt = (bounce != NULL) ? 1 : count;
+    struct iovec *iov = (struct iovec *)malloc(iovcnt * sizeof(struct iovec)); // one buffer per page of the run
+    if (bounce != NULL)
+    {
+        iov[0].iov_base = bounce;
+        iov[0].iov_len = count * pageSize;
+        for (int i = 0; i < count && isWrite; i++)
+        {
+            memcpy(bounce + i * pageSize, memPages[i], pageSize);
         }
-        else
+    }
+    else
+    {
+        for (int i = 0; i < count; i++)
         {
-            printError(RC_FILE_NOT_FOUND);
-            // perror("[ERROR] File not found\n");
-            return RC_FILE_NOT_FOUND; // returns error code when file is not found
+            iov[i].iov_base = memPages[i];
+            iov[i].iov_len = pageSize;
         }
     }
-    printError(RC_FILE_HANDLE_NOT_INIT);
-    // perror("[ERROR] File handle is not initialized\n");
-    return RC_FILE_HANDLE_NOT_INIT; // returns error code when file is not initialized
+
+    int failed = transferVector(pos.fd, iov, iovcnt, pos.offset, isWrite, &fInfo->stats);
+    free(iov);
+    if (isWrite && !failed)
+    {
+        markSegmentDirty(fInfo, pos.segment);
+    }
+    if (bounce != NULL)
+    {
+        for (int i = 0; i < count && !isWrite && !failed; i++)
+        {
+            memcpy(memPages[i], bounce + i * pageSize, pageSize);
+        }
+        free(bounce);
+    }
+    return failed;
 }
 
 /**
- * Method to increase the size to numberOfPages if the file has less than numberOfPages pages.
+ * Method to read or write count pages starting at startPage from the buffers memPages[0..count-1].
+ * The run is split where bitmap pages or segment boundaries interrupt it, each part is transferred with transferRun.
+ * Returns 0 on success and -1 on an error or a read past the end of the file.
  **/
-RC ensureCapacity(int numberOfPages, SM_FileHandle *fHandle)
+static int transferPages(SM_FileInfo *fInfo, SM_PageHandle memPages[], int startPage, int count, int isWrite)
 {
-    if (fHandle != NULL)
+    while (count > 0)
     {
-        if (fHandle->totalNumPages < numberOfPages) // checks if the number of pages are greater than file total number of pages
+        int part = count;
+        if (fInfo->pagesPerMap > 0 && part > fInfo->pagesPerMap - startPage % fInfo->pagesPerMap) // stops at the end of the group
+        {
+            part = fInfo->pagesPerMap - startPage % fInfo->pagesPerMap;
+        }
+        off_t offset = pageOffset(fInfo, startPage);
+        if (fInfo->segmentPages > 0) // stops at the end of the segment
         {
-            int additionalPages = numberOfPages - fHandle->totalNumPages; // calculate required additional pages
-            for (int i = 0; i < additionalPages; i++)                     // iterate through the additional pages and append an empty block
+            off_t room = fInfo->dataOffset + ((offset - fInfo->dataOffset) / segmentBytes(fInfo) + 1) * segmentBytes(fInfo) - offset;
+            if (part > room / fInfo->pageSize)
             {
-                appendEmptyBlock(fHandle); // appends empty page
+                part = (int)(room / fInfo->pageSize);
             }
         }
-        return RC_OK; // returns successful code
+        if (transferRun(fInfo, memPages, part, offset, isWrite) != 0)
+        {
+            return -1;
+        }
+        memPages += part;
+        startPage += part;
+        count -= part;
     }
-    printError(RC_FILE_HANDLE_NOT_INIT);
-    // perror("[ERROR] File handle is not initialized\n");
-    return RC_FILE_HANDLE_NOT_INIT; // returns error code
+    return 0;
+}
+
+/* positional I/O helpers - End */
+
+/* page file header - Begin */
+
+#define SM_FILE_MAGIC "CS525PGF"
+#define SM_FILE_VERSION 1
+
+/* features of a page file recorded in its header */
+#define SM_FEATURE_FREE_MAP 0x1 // groups of pages are preceded by free page bitmaps
+#define SM_FEATURE_SEGMENTED 0x2 // the file is split into segment files of segmentPages pages
+#define SM_FEATURE_COMPRESSED 0x4 // pages are compressed with codec into slots listed in the page map file
+
+/**
+ * Layout of the header block at the start of a page file, the rest of the block is zero
+ */
+typedef struct SM_FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t pageSize;
+    uint32_t features;
+    uint32_t segmentPages; // with SM_FEATURE_SEGMENTED, counting bitmap pages
+    uint32_t codec;        // with SM_FEATURE_COMPRESSED, SM_CODEC_* id
+} SM_FileHeader;
+
+/**
+ * Method to check that pageSize is a power of two between SM_MIN_PAGE_SIZE and SM_MAX_PAGE_SIZE.
+ **/
+static int isValidPageSize(int pageSize)
+{
+    return pageSize >= SM_MIN_PAGE_SIZE && pageSize <= SM_MAX_PAGE_SIZE && (pageSize & (pageSize - 1)) == 0;
+}
+
+/**
+ * Method to read the header of an open page file of fileSize bytes.
+ * Returns 0 when the file has no valid header, which is the case for files created without one.
+ **/
+static int readFileHeader(int fd, off_t fileSize, SM_FileHeader *fileHeader)
+{
+    if (fileSize < SM_FILE_HEADER_SIZE)
+    {
+        return 0;
+    }
+    char *block = allocPageBuffer(1, SM_FILE_HEADER_SIZE); // aligned, the file may be open for direct I/O
+    if (block == NULL)
+    {
+        return 0;
+    }
+
+    SM_FileHeader *header = (SM_FileHeader *)block;
+    int found = readFully(fd, block, SM_FILE_HEADER_SIZE, 0, NULL) == SM_FILE_HEADER_SIZE &&
+                memcmp(header->magic, SM_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+                header->version == SM_FILE_VERSION && isValidPageSize((int)header->pageSize);
+    if (found)
+    {
+        *fileHeader = *header;
+    }
+    free(block);
+    return found;
+}
+
+/**
+ * Method to fill in the header of a new page file.
+ **/
+static void initFileHeader(SM_FileHeader *header, const SM_CreateOptions *options)
+{
+    memset(header, 0, sizeof(SM_FileHeader));
+    memcpy(header->magic, SM_FILE_MAGIC, sizeof(header->magic));
+    header->version = SM_FILE_VERSION;
+    header->pageSize = options->pageSize;
+    if (options->codec != SM_CODEC_NONE) // the page map takes the place of the free page bitmaps
+    {
+        header->features = SM_FEATURE_COMPRESSED;
+        header->codec = options->codec;
+        return;
+    }
+    header->features = SM_FEATURE_FREE_MAP;
+    if (options->segmentPages > 0)
+    {
+        header->features |= SM_FEATURE_SEGMENTED;
+        header->segmentPages = options->segmentPages;
+    }
+}
+
+/* page file header - End */
+
+/* file mapping helpers - Begin */
+
+/**
+ * Method to extend the shared mapping of a mapped page file up to fileSize bytes.
+ * The new part is mapped in place inside the reserved address range, so pointers
+ * handed out by mapBlock stay valid while the file grows.
+ **/
+static RC growMapping(SM_FileInfo *fInfo, size_t fileSize)
+{
+    if (fInfo->mapBase == NULL || fileSize <= fInfo->mapLength) // not mapped or already covered
+    {
+        return RC_OK;
+    }
+    if (fileSize > fInfo->mapReserve) // the file outgrew the reserved address range
+    {
+        printError(RC_MAP_FAILED);
+        return RC_MAP_FAILED;
+    }
+
+    void *addr = mmap(fInfo->mapBase + fInfo->mapLength, fileSize - fInfo->mapLength, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_FIXED, fInfo->fd, (off_t)fInfo->mapLength);
+    if (addr == MAP_FAILED)
+    {
+        printError(RC_MAP_FAILED);
+        return RC_MAP_FAILED;
+    }
+    fInfo->mapLength = fileSize; // the whole file is mapped now
+    return RC_OK;
+}
+
+/**
+ * Method to reserve address space for a page file and map its current content.
+ **/
+static RC mapFile(SM_FileInfo *fInfo, size_t fileSize)
+{
+    size_t reserve = SM_MAP_RESERVE_SIZE;
+    if (reserve < 2 * fileSize) // leave room for the file to double
+    {
+        reserve = 2 * fileSize;
+    }
+
+    void *base = mmap(NULL, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        printError(RC_MAP_FAILED);
+        return RC_MAP_FAILED;
+    }
+
+    fInfo->mapBase = base;
+    fInfo->mapLength = 0;
+    fInfo->mapReserve = reserve;
+    return growMapping(fInfo, fileSize);
+}
+
+/* file mapping helpers - End */
+
+static void destroyAsyncEngine(SM_FileInfo *fInfo);
+static RC openPageMap(SM_FileInfo *fInfo, char *fileName);
+static void closePageMap(SM_FileInfo *fInfo);
+static RC growPageMap(SM_FileInfo *fInfo, int numberOfPages);
+static RC readCompressedPage(SM_FileInfo *fInfo, int pageNum, SM_PageHandle memPage);
+static RC writeCompressedPage(SM_FileInfo *fInfo, int pageNum, SM_PageHandle memPage);
+static char *pageMapName(const char *fileName);
+static RC noteWrites(SM_FileInfo *fInfo, int count);
+static RC stopSyncer(SM_FileInfo *fInfo);
+
+/* file growth helpers - Begin */
+
+/**
+ * Method to compute the size of the next extent of a file from its extent policy.
+ **/
+static int nextExtentPages(SM_FileInfo *fInfo)
+{
+    SM_ExtentPolicy *policy = &fInfo->extentPolicy;
+    long extent = (long)fInfo->allocatedPages * policy->growthPercent / 100; // geometric growth
+    if (extent < policy->minExtentPages)
+    {
+        extent = policy->minExtentPages;
+    }
+    if (extent > policy->maxExtentPages)
+    {
+        extent = policy->maxExtentPages;
+    }
+    return (int)extent;
+}
+
+/**
+ * Method to grow a page file to numberOfPages pages. Disk space is reserved one extent at a time
+ * with fallocate, and the file is extended to the end of the extent with a single ftruncate that
+ * fills its pages with zero bytes. Growing into an extent already reserved needs no system call,
+ * closePageFile gives back the part of the last extent that was never used.
+ **/
+static RC growFile(SM_FileHandle *fHandle, int numberOfPages)
+{
+    SM_FileInfo *fInfo = fHandle->mgmtInfo;
+    if (numberOfPages <= fHandle->totalNumPages) // already large enough
+    {
+        return RC_OK;
+    }
+    if (fInfo->pageMap != NULL) // pages of a compressed file get their slot when they are written
+    {
+        RC rc = growPageMap(fInfo, numberOfPages);
+        if (rc == RC_OK)
+        {
+            fHandle->totalNumPages = numberOfPages;
+            fInfo->allocatedPages = numberOfPages;
+        }
+        return rc;
+    }
+    if (fInfo->allocatedPages < fHandle->totalNumPages) // pages written past the end extended the file
+    {
+        fInfo->allocatedPages = fHandle->totalNumPages;
+    }
+
+    if (numberOfPages > fInfo->allocatedPages) // the reserved space is used up, reserve the next extent
+    {
+        int extent = nextExtentPages(fInfo);
+        if (extent < numberOfPages - fInfo->allocatedPages)
+        {
+            extent = numberOfPages - fInfo->allocatedPages;
+        }
+        reserveRange(fInfo, pageOffset(fInfo, fInfo->allocatedPages), (off_t)extent * fInfo->pageSize);
+
+        addStat(&fInfo->stats.extends, 1);
+        if (resizeFile(fInfo, pageOffset(fInfo, fInfo->allocatedPages + extent)) != 0) // extends the file with zero filled pages
+        {
+            printError(RC_WRITE_FAILED);
+            return RC_WRITE_FAILED;
+        }
+        fInfo->allocatedPages += extent;
+        RC rc = growMapping(fInfo, (size_t)pageOffset(fInfo, fInfo->allocatedPages)); // maps the new pages of a mapped file
+        if (rc != RC_OK)
+        {
+            return rc;
+        }
+    }
+    fHandle->totalNumPages = numberOfPages;
+    return RC_OK;
+}
+
+/* file growth helpers - End */
+
+/* manipulating page files - Begin */
+
+/*
+Initialize storage manager
+*/
+void initStorageManager(void)
+{
+    LOG_INFO("Begin Execution");
+}
+
+/**
+ * Method to create new page fileName. The initial file size is one page and fills the
+ * single page with ’\0’ bytes.
+ **/
+RC createPageFile(char *fileName)
+{
+    return createPageFileWithPageSize(fileName, PAGE_SIZE);
+}
+
+/**
+ * Method to create new page fileName with pages of pageSize bytes. The page size is recorded in a
+ * header block in front of the first page, the file starts with a single page filled with ’\0’ bytes.
+ **/
+RC createPageFileWithPageSize(char *fileName, int pageSize)
+{
+    SM_CreateOptions options = {pageSize, 0, SM_CODEC_NONE};
+    return createPageFileWithOptions(fileName, &options);
+}
+
+/**
+ * Method to create new page fileName with pages of pageSize bytes, split into segment files of segmentPages pages
+ * each. Bitmap pages count towards segmentPages. With segmentPages 0 the page file is a single file.
+ **/
+RC createSegmentedPageFile(char *fileName, int pageSize, int segmentPages)
+{
+    SM_CreateOptions options = {pageSize, segmentPages, SM_CODEC_NONE};
+    return createPageFileWithOptions(fileName, &options);
+}
+
+/**
+ * Method to create new page fileName with the layout given in options, NULL asks for the defaults.
+ * The pages of a file created with a codec are compressed on their way to disk.
+ **/
+RC createPageFileWithOptions(char *fileName, const SM_CreateOptions *options)
+{
+    struct stat st;
+    SM_CreateOptions layout = {PAGE_SIZE, 0, SM_CODEC_NONE};
+    if (options != NULL)
+    {
+        layout = *options;
+    }
+    if (layout.pageSize == 0)
+    {
+        layout.pageSize = PAGE_SIZE;
+    }
+    int pageSize = layout.pageSize;
+    if (!isValidPageSize(pageSize) || layout.segmentPages < 0 || (layout.codec != SM_CODEC_NONE && layout.segmentPages > 0))
+    {
+        printError(RC_INVALID_PARAMETER);
+        return RC_INVALID_PARAMETER;
+    }
+    if (layout.codec != SM_CODEC_NONE && findPageCodec(layout.codec) == NULL)
+    {
+        printError(RC_UNKNOWN_CODEC);
+        return RC_UNKNOWN_CODEC;
+    }
+
+    int fd = open(fileName, O_RDWR | O_CREAT, 0644); // Creates the file if it does not exist
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        printError(RC_WRITE_FAILED);
+        return RC_WRITE_FAILED;
+    }
+
+    RC rc = RC_OK;
+    SM_FileHeader header;
+    SM_FileHeader oldHeader;
+    initFileHeader(&header, &layout);
+    int hasHeader = st.st_size > 0 && readFileHeader(fd, st.st_size, &oldHeader);
+    if (st.st_size > 0 && (!hasHeader || memcmp(&oldHeader, &header, sizeof(header)) != 0 || layout.codec != SM_CODEC_NONE))
+    {
+        // the pages of an existing file with another layout cannot be kept
+        if (ftruncate(fd, 0) != 0)
+        {
+            rc = RC_WRITE_FAILED;
+        }
+        if (hasHeader && (oldHeader.features & SM_FEATURE_SEGMENTED))
+        {
+            removeSegments(fileName, 1);
+        }
+    }
+
+    char *mapName = pageMapName(fileName);
+    if (layout.codec != SM_CODEC_NONE) // an empty page map, the first page is added below
+    {
+        int mapFd = open(mapName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (mapFd < 0)
+        {
+            rc = RC_WRITE_FAILED;
+        }
+        else
+        {
+            close(mapFd);
+        }
+    }
+    else if (hasHeader && (oldHeader.features & SM_FEATURE_COMPRESSED))
+    {
+        unlink(mapName);
+    }
+    free(mapName);
+
+    // writes the header and the empty free page bitmap of the first group, which always fit into the first segment,
+    // overwriting them if the file already exists. A compressed file has no bitmap
+    size_t blockSize = SM_FILE_HEADER_SIZE + ((layout.codec == SM_CODEC_NONE) ? (size_t)pageSize : 0);
+    char *block = (char *)calloc(blockSize, sizeof(char));
+    memcpy(block, &header, sizeof(header));
+    if (rc == RC_OK && writeFully(fd, block, blockSize, 0, NULL) != (ssize_t)blockSize)
+    {
+        rc = RC_WRITE_FAILED;
+    }
+    free(block);
+
+    close(fd); // closes the file
+    if (rc != RC_OK)
+    {
+        printError(rc);
+        return rc;
+    }
+
+    // writes the first page filled with \0, which is in the second segment when segments hold a single page
+    SM_FileHandle fHandle;
+    rc = openPageFile(fileName, &fHandle);
+    if (rc != RC_OK)
+    {
+        return rc;
+    }
+    SM_PageHandle emptyPage = allocPageBuffer(1, pageSize);
+    rc = (emptyPage != NULL) ? writeBlock(0, &fHandle, emptyPage) : RC_WRITE_FAILED;
+    free(emptyPage);
+    RC closeRc = closePageFile(&fHandle);
+    return (rc != RC_OK) ? rc : closeRc;
+}
+
+/**
+ * Opens an existing page file.Should return RC FILE NOT FOUND if the file does not exist.
+ * – The second parameter is an existing file handle.
+ * – If opening the file is successful, then the fields of this file handle should be initialized with
+ * the information about the opened file.
+ * For instance, you would have to read the total number of pages that are stored in the file from disk.
+ * */
+
+RC openPageFile(char *fileName, SM_FileHandle *fHandle)
+{
+    return openPageFileWithFlags(fileName, fHandle, 0);
+}
+
+/**
+ * Opens an existing page file with a mapping of the whole file, blocks can then be accessed in place through mapBlock.
+ **/
+RC openPageFileMapped(char *fileName, SM_FileHandle *fHandle)
+{
+    return openPageFileWithFlags(fileName, fHandle, SM_OPEN_MAPPED);
+}
+
+/**
+ * Opens an existing page file with the SM_OPEN_* flags given.
+ **/
+RC openPageFileWithFlags(char *fileName, SM_FileHandle *fHandle, int flags)
+{
+    int fd;
+    struct stat st;
+
+    if ((flags & SM_OPEN_DIRECT) && (flags & SM_OPEN_MAPPED)) // a mapping is always served by the page cache
+    {
+        printError(RC_INVALID_PARAMETER);
+        return RC_INVALID_PARAMETER;
+    }
+    int openFlags = (flags & SM_OPEN_DIRECT) ? O_DIRECT : 0;
+
+    fd = open(fileName, O_RDWR | openFlags); // Open the file once in read write mode, the descriptor lives until closePageFile
+    if (fd < 0 && (flags & SM_OPEN_DIRECT) && errno == EINVAL) // the file system does not support direct I/O, use the page cache
+    {
+        flags &= ~SM_OPEN_DIRECT;
+        openFlags = 0;
+        fd = open(fileName, O_RDWR);
+    }
+
+    if (fd >= 0 && fstat(fd, &st) == 0) // If file exists
+    {
+        SM_FileInfo *fInfo = (SM_FileInfo *)calloc(1, sizeof(SM_FileInfo)); // dynamically allocate memory to the file info
+        fInfo->fd = fd;
+        fInfo->flags = flags;
+        fInfo->pageSize = PAGE_SIZE; // a file without header has pages of the compiled in size
+        fInfo->dataOffset = 0;
+        SM_FileHeader header;
+        if (readFileHeader(fd, st.st_size, &header))
+        {
+            fInfo->pageSize = header.pageSize;
+            fInfo->dataOffset = SM_FILE_HEADER_SIZE;
+            fInfo->pagesPerMap = (header.features & SM_FEATURE_FREE_MAP) ? header.pageSize * 8 : 0; // one bit per page
+            fInfo->segmentPages = (header.features & SM_FEATURE_SEGMENTED) ? (int)header.segmentPages : 0;
+            if (header.features & SM_FEATURE_COMPRESSED)
+            {
+                fInfo->codec = findPageCodec((int)header.codec);
+                if (fInfo->codec == NULL)
+                {
+                    close(fd);
+                    free(fInfo);
+                    printError(RC_UNKNOWN_CODEC);
+                    return RC_UNKNOWN_CODEC;
+                }
+            }
+        }
+        off_t fileSize = st.st_size;
+        if (fInfo->codec != NULL)
+        {
+            // compressed pages have no fixed place in the file, which neither a mapping nor direct I/O can serve
+            if ((flags & (SM_OPEN_MAPPED | SM_OPEN_DIRECT)) || openPageMap(fInfo, fileName) != RC_OK)
+            {
+                closePageMap(fInfo);
+                close(fd);
+                free(fInfo);
+                printError(RC_INVALID_PARAMETER);
+                return RC_INVALID_PARAMETER;
+            }
+        }
+        else if (fInfo->segmentPages > 0)
+        {
+            if (flags & SM_OPEN_MAPPED) // a mapping covers a single file
+            {
+                close(fd);
+                free(fInfo);
+                printError(RC_INVALID_PARAMETER);
+                return RC_INVALID_PARAMETER;
+            }
+            openSegments(fInfo, fileName, openFlags, &fileSize);
+        }
+        if (fInfo->codec == NULL) // a compressed file has as many pages as its page map has entries
+        {
+            fInfo->allocatedPages = countPages(fInfo, fileSize);
+        }
+        fInfo->access.lastPage = -1;
+        pthread_mutex_init(&fInfo->access.lock, NULL);
+        fInfo->access.readaheadPages = SM_MIN_READAHEAD_PAGES;
+        fInfo->extentPolicy.minExtentPages = SM_DEFAULT_MIN_EXTENT_PAGES;
+        fInfo->extentPolicy.maxExtentPages = SM_DEFAULT_MAX_EXTENT_PAGES;
+        fInfo->extentPolicy.growthPercent = SM_DEFAULT_GROWTH_PERCENT;
+
+        if ((flags & SM_OPEN_MAPPED) && mapFile(fInfo, st.st_size) != RC_OK) // maps the file when asked to
+        {
+            close(fd);
+            free(fInfo);
+            return RC_MAP_FAILED;
+        }
+
+        fHandle->fileName = fileName;                      // assigning filename to the filename in file handle
+        fHandle->curPagePos = 0;                           // a freshly opened file is positioned at the first page
+        fHandle->totalNumPages = fInfo->allocatedPages;    // dividing the size of the file behind its header with the page size
+        fHandle->pageSize = fInfo->pageSize;
+        fHandle->mgmtInfo = fInfo;                         // assigning the file info to mgmtInfo in file handle
+
+        return RC_OK;
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    printError(RC_FILE_NOT_FOUND);
+    // perror("[ERROR] File not found\n");
+    return RC_FILE_NOT_FOUND; // returns RC_FILE_NOT_FOUND error code of the file does not exists
+}
+
+/**
+ * Close an open page file
+ **/
+RC closePageFile(SM_FileHandle *fHandle)
+{
+    if (fHandle != NULL) // condition to check if file handle is initialized
+    {
+        if (fHandle->mgmtInfo != NULL) // checks if file handle file info is not null. If its not null, the file is open
+        {
+            SM_FileInfo *fInfo = fHandle->mgmtInfo;
+            destroyAsyncEngine(fInfo); // waits for requests still in flight
+            stopSyncer(fInfo);         // syncs the writes of the last group
+            if (fInfo->allocatedPages > fHandle->totalNumPages) // gives back the unused part of the last extent
+            {
+                resizeFile(fInfo, pageOffset(fInfo, fHandle->totalNumPages));
+            }
+            if (fInfo->mapBase != NULL) // releases the mapping together with the reserved address range
+            {
+                munmap(fInfo->mapBase, fInfo->mapReserve);
+            }
+            closeSegments(fInfo);
+            closePageMap(fInfo);
+            int rc = close(fInfo->fd); // closes the file descriptor
+            for (int i = 0; i < fInfo->numFreeMaps; i++)
+            {
+                free(fInfo->freeMaps[i]);
+            }
+            free(fInfo->freeMaps);
+            pthread_mutex_destroy(&fInfo->access.lock);
+            free(fInfo);
+            fHandle->mgmtInfo = NULL;
+            return (rc == 0) ? RC_OK : RC_FILE_NOT_FOUND;
+        }
+        else
+        {
+            printError(RC_FILE_NOT_FOUND);
+            // perror("[ERROR] File not found\n");
+            return RC_FILE_NOT_FOUND; // If file handle file pointer is null, file is not open or already closed, then retuns error code
+        }
+    }
+
+    printError(RC_FILE_HANDLE_NOT_INIT);
+    // perror("[ERROR] File handle is not initialized\n");
+    return RC_FILE_HANDLE_NOT_INIT; // returns error code if file handle is not initialized
+}
+
+/**
+ *  Destroy (delete) a page file
+ **/
+RC destroyPageFile(char *fileName)
+{
+    struct stat st;
+    SM_FileHeader header;
+    int fd = open(fileName, O_RDONLY);
+    if (fd >= 0)
+    {
+        if (fstat(fd, &st) == 0 && readFileHeader(fd, st.st_size, &header))
+        {
+            if (header.features & SM_FEATURE_SEGMENTED)
+            {
+                removeSegments(fileName, 1); // deletes the other segments of a segmented page file
+            }
+            if (header.features & SM_FEATURE_COMPRESSED) // deletes the page map of a compressed page file
+            {
+                char *mapName = pageMapName(fileName);
+                unlink(mapName);
+                free(mapName);
+            }
+        }
+        close(fd);
+    }
+
+    if (remove(fileName) == 0) // Deletes the file
+    {
+        return RC_OK; // returns 0 when file is successfully deleted
+    }
+    printError(RC_FILE_NOT_FOUND);
+    // perror("[ERROR] File not found\n");
+    return RC_FILE_NOT_FOUND; // returns error code otherwise
+}
+
+/* manipulating page files - End */
+
+/* access pattern detection - Begin */
+
+/**
+ * Method to pass the access pattern of a file on to the kernel, for every open segment file and for the mapping of a mapped file.
+ **/
+static void adviseFile(SM_FileInfo *fInfo, SM_AccessPattern pattern)
+{
+    int advice = POSIX_FADV_NORMAL;
+    int mapAdvice = MADV_NORMAL;
+    if (pattern == SM_ACCESS_SEQUENTIAL)
+    {
+        advice = POSIX_FADV_SEQUENTIAL; // doubles the readahead window of the kernel
+        mapAdvice = MADV_SEQUENTIAL;
+    }
+    else if (pattern == SM_ACCESS_RANDOM)
+    {
+        advice = POSIX_FADV_RANDOM; // no readahead at all
+        mapAdvice = MADV_RANDOM;
+    }
+
+    if (fInfo->mapBase != NULL) // page faults of a mapping follow the advice of the mapping
+    {
+        madvise(fInfo->mapBase, fInfo->mapLength, mapAdvice);
+    }
+    SM_SegmentTable *table = fInfo->segments;
+    if (table == NULL)
+    {
+        posix_fadvise(fInfo->fd, 0, 0, advice);
+        return;
+    }
+    pthread_mutex_lock(&table->lock);
+    for (int i = 0; i < table->count; i++)
+    {
+        if (table->entries[i].fd >= 0)
+        {
+            posix_fadvise(table->entries[i].fd, 0, 0, advice);
+        }
+    }
+    pthread_mutex_unlock(&table->lock);
+}
+
+/**
+ * Method to ask the kernel to start reading count pages from startPage into the page cache, without waiting for them.
+ **/
+static void adviseWillNeed(SM_FileInfo *fInfo, int startPage, int count)
+{
+    off_t offset = pageOffset(fInfo, startPage);
+    off_t length = pageOffset(fInfo, startPage + count) - offset; // includes the free page bitmaps in between
+    if (fInfo->mapBase != NULL)
+    {
+        if ((size_t)offset < fInfo->mapLength)
+        {
+            size_t mapped = fInfo->mapLength - offset;
+            madvise(fInfo->mapBase + offset, ((size_t)length < mapped) ? (size_t)length : mapped, MADV_WILLNEED);
+        }
+        return;
+    }
+    while (length > 0) // the window may cross the boundaries of segment files
+    {
+        SM_FilePos pos;
+        if (locate(fInfo, offset, 0, &pos) != 0)
+        {
+            return;
+        }
+        off_t part = (length < pos.room) ? length : pos.room;
+        posix_fadvise(pos.fd, pos.offset, part, POSIX_FADV_WILLNEED);
+        offset += part;
+        length -= part;
+    }
+}
+
+/**
+ * Method to record a read of count pages from startPage and to give the kernel readahead advice when the pattern of the
+ * reads changes. A sequential scan gets growing readahead windows announced half a window before the reader reaches them,
+ * point lookups scattered over the file switch readahead off so the kernel does not read pages nobody asked for.
+ * The tracker is only a heuristic, a read racing with another one on it is not recorded.
+ **/
+static void noteRead(SM_FileHandle *fHandle, int startPage, int count)
+{
+    SM_FileInfo *fInfo = fHandle->mgmtInfo;
+    SM_AccessTracker *tracker = &fInfo->access;
+    if ((fInfo->flags & SM_OPEN_DIRECT) || pthread_mutex_trylock(&tracker->lock) != 0) // no page cache to advise, or a concurrent read is recording
+    {
+        return;
+    }
+    if (startPage == tracker->lastPage && count == 1) // the same page again
+    {
+        pthread_mutex_unlock(&tracker->lock);
+        return;
+    }
+
+    if (startPage == tracker->lastPage + 1) // continues the run
+    {
+        tracker->sequentialRun += count;
+        tracker->randomRun = 0;
+    }
+    else // a run of a single readBlocks call is sequential on its own
+    {
+        tracker->sequentialRun = count;
+        tracker->randomRun = (count < SM_SEQUENTIAL_THRESHOLD) ? tracker->randomRun + 1 : 0;
+        tracker->readaheadEnd = startPage + count;
+        tracker->readaheadPages = SM_MIN_READAHEAD_PAGES;
+    }
+    tracker->lastPage = startPage + count - 1;
+
+    if (tracker->sequentialRun >= SM_SEQUENTIAL_THRESHOLD)
+    {
+        if (tracker->pattern != SM_ACCESS_SEQUENTIAL)
+        {
+            tracker->pattern = SM_ACCESS_SEQUENTIAL;
+            adviseFile(fInfo, SM_ACCESS_SEQUENTIAL);
+        }
+        if (tracker->readaheadEnd <= tracker->lastPage + tracker->readaheadPages / 2) // less than half a window left ahead
+        {
+            int start = (tracker->readaheadEnd > tracker->lastPage) ? tracker->readaheadEnd : tracker->lastPage + 1;
+            int end = start + tracker->readaheadPages;
+            if (end > fHandle->totalNumPages)
+            {
+                end = fHandle->totalNumPages;
+            }
+            if (end > start && fInfo->codec == NULL) // compressed pages have no fixed offset, their file only gets the sequential advice
+            {
+                adviseWillNeed(fInfo, start, end - start);
+                addStat(&fInfo->stats.readaheadHints, 1);
+            }
+            tracker->readaheadEnd = start + tracker->readaheadPages;
+            if (tracker->readaheadPages < SM_MAX_READAHEAD_PAGES)
+            {
+                tracker->readaheadPages *= 2;
+            }
+        }
+    }
+    else if (tracker->randomRun >= SM_RANDOM_THRESHOLD && tracker->pattern != SM_ACCESS_RANDOM)
+    {
+        tracker->pattern = SM_ACCESS_RANDOM;
+        adviseFile(fInfo, SM_ACCESS_RANDOM);
+    }
+    pthread_mutex_unlock(&tracker->lock);
+}
+
+/**
+ * Method to retrieve the access pattern detected from the recent reads of a file.
+ **/
+SM_AccessPattern getAccessPattern(SM_FileHandle *fHandle)
+{
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL)
+    {
+        return SM_ACCESS_NORMAL;
+    }
+    SM_AccessTracker *tracker = &((SM_FileInfo *)fHandle->mgmtInfo)->access;
+    pthread_mutex_lock(&tracker->lock);
+    SM_AccessPattern pattern = tracker->pattern;
+    pthread_mutex_unlock(&tracker->lock);
+    return pattern;
+}
+
+/* access pattern detection - End */
+
+/* reading blocks from disc - Begin */
+
+/**
+ * Method to move the current page position of a file to pageNum. Reads and writes at absolute positions may run
+ * concurrently on existing pages, each of them leaves the position at one of their pages.
+ **/
+static void setBlockPos(SM_FileHandle *fHandle, int pageNum)
+{
+    __atomic_store_n(&fHandle->curPagePos, pageNum, __ATOMIC_RELAXED);
+}
+
+/**
+ * Method to reads the block at position pageNum from a file and stores its content in the memory pointed
+ * to by the memPage page handle.
+ * If the file has less than pageNum pages, the method should return RC READ NON EXISTING PAGE.
+ **/
+RC readBlock(int pageNum, SM_FileHandle *filehandle, SM_PageHandle memPage)
+{
+    if (filehandle == NULL || filehandle->mgmtInfo == NULL)
+    {
+        printError(RC_FILE_HANDLE_NOT_INIT);
+        // perror("[ERROR] File handle is not initialized\n");
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+
+    if (pageNum >= filehandle->totalNumPages || pageNum < 0)
+    {
+        printError(RC_READ_NON_EXISTING_PAGE);
+        // perror("[ERROR] Invalid request to read non existing page\n");
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    SM_FileInfo *fInfo = filehandle->mgmtInfo;
+    long long start = nowNanos();
+    if (fInfo->codec != NULL) // compressed file, the page is read from its slot
+    {
+        RC rc = readCompressedPage(fInfo, pageNum, memPage);
+        if (rc != RC_OK)
+        {
+            printError(rc);
+            return rc;
+        }
+    }
+    else if (fInfo->mapBase != NULL) // mapped file, copy straight out of the mapping
+    {
+        char *mapped = fInfo->mapBase + pageOffset(fInfo, pageNum);
+        if (memPage != mapped)
+        {
+            memcpy(memPage, mapped, fInfo->pageSize);
+        }
+    }
+    else if (transferPage(fInfo, memPage, pageOffset(fInfo, pageNum), 0) != fInfo->pageSize) // reads the page at its absolute offset
+    {
+        printError(RC_READ_NON_EXISTING_PAGE);
+        // perror("[ERROR] Invalid request to read non existing page\n");
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    recordPages(&fInfo->stats, 1, fInfo->pageSize, 0);
+    recordLatency(fInfo->stats.readLatency, nowNanos() - start);
+    noteRead(filehandle, pageNum, 1);
+
+    setBlockPos(filehandle, pageNum);
+    LOG_TRACE("Current page pos : %d", pageNum);
+    return RC_OK;
+}
+
+/**
+ * Method to retrieve the current page position in a file.
+ **/
+int getBlockPos(SM_FileHandle *filehandle)
+{
+    if (filehandle == NULL)
+    {
+        printError(RC_FILE_HANDLE_NOT_INIT);
+        // printError("[ERROR] File handle is not initialized\n");
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+
+    if (filehandle->mgmtInfo == NULL)
+    {
+        printError(RC_FILE_HANDLE_NOT_INIT);
+        // perror("[ERROR] File handle is not initialized\n");
+        return RC_FILE_NOT_FOUND;
+    }
+
+    return __atomic_load_n(&filehandle->curPagePos, __ATOMIC_RELAXED);
+}
+
+/**
+ * Method to read the first respective last page in a file.
+ **/
+RC readFirstBlock(SM_FileHandle *filehandle, SM_PageHandle memPage)
+{
+    return readBlock(0, filehandle, memPage);
+}
+
+/**
+ * Method to read the previous page relative to the curPagePos of the file.
+ **/
+RC readPreviousBlock(SM_FileHandle *filehandle, SM_PageHandle memPage)
+{
+    curPagePos = getBlockPos(filehandle) - 1;
+    return readBlock(curPagePos, filehandle, memPage);
+}
+
+/**
+ * Method to read the current page relative to the curPagePos of the file.
+ **/
+RC readCurrentBlock(SM_FileHandle *filehandle, SM_PageHandle memPage)
+{
+    curPagePos = getBlockPos(filehandle);
+    return readBlock(curPagePos, filehandle, memPage);
+}
+
+// Method to read the next page relative to the curPagePos of the file.
+RC readNextBlock(SM_FileHandle *filehandle, SM_PageHandle memPage)
+{
+    curPagePos = getBlockPos(filehandle) + 1;
+    return readBlock(curPagePos, filehandle, memPage);
+}
+
+/**
+ * Method to read the last page of the file.
+ **/
+RC readLastBlock(SM_FileHandle *filehandle, SM_PageHandle memPage)
+{
+    curPagePos = (filehandle->totalNumPages) - 1;
+    return readBlock(curPagePos, filehandle, memPage);
+}
+
+/**
+ * Method to access the block at position pageNum of a mapped file without copying it.
+ * memPage is set to point into the mapping, the pointer stays valid until the file is closed.
+ **/
+RC mapBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle *memPage)
+{
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL)
+    {
+        printError(RC_FILE_HANDLE_NOT_INIT);
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+
+    SM_FileInfo *fInfo = fHandle->mgmtInfo;
+    if (fInfo->mapBase == NULL) // only files opened with SM_OPEN_MAPPED can hand out block pointers
+    {
+        printError(RC_MAP_FAILED);
+        return RC_MAP_FAILED;
+    }
+
+    if (pageNum >= fHandle->totalNumPages || pageNum < 0)
+    {
+        printError(RC_READ_NON_EXISTING_PAGE);
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    *memPage = fInfo->mapBase + pageOffset(fInfo, pageNum);
+    setBlockPos(fHandle, pageNum);
+    return RC_OK;
+}
+
+/**
+ * Method to read count adjacent blocks starting at startPage into the buffers memPages[0..count-1] with a single vectored read.
+ **/
+RC readBlocks(int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle memPages[])
+{
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL)
+    {
+        printError(RC_FILE_HANDLE_NOT_INIT);
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+
+    if (startPage < 0 || count < 0 || startPage + count > fHandle->totalNumPages)
+    {
+        printError(RC_READ_NON_EXISTING_PAGE);
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    if (count == 0)
+    {
+        return RC_OK;
+    }
+
+    SM_FileInfo *fInfo = fHandle->mgmtInfo;
+    if (fInfo->codec != NULL) // compressed file, every page is read from its own slot
+    {
+        for (int i = 0; i < count; i++)
+        {
+            RC rc = readCompressedPage(fInfo, startPage + i, memPages[i]);
+            if (rc != RC_OK)
+            {
+                printError(rc);
+                return rc;
+            }
+        }
+    }
+    else if (fInfo->mapBase != NULL) // mapped file, copy straight out of the mapping
+    {
+        for (int i = 0; i < count; i++)
+        {
+            char *mapped = fInfo->mapBase + pageOffset(fInfo, startPage + i);
+            if (memPages[i] != mapped)
+            {
+                memcpy(memPages[i], mapped, fInfo->pageSize);
+            }
+        }
+    }
+    else if (transferPages(fInfo, memPages, startPage, count, 0) != 0)
+    {
+        printError(RC_READ_NON_EXISTING_PAGE);
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    recordPages(&fInfo->stats, count, fInfo->pageSize, 0);
+    noteRead(fHandle, startPage, count);
+    setBlockPos(fHandle, startPage + count - 1); // positioned at the last page read
+    return RC_OK;
+}
+
+/* reading blocks from disc - End */
+
+/* writing blocks to a page file - Begin */
+
+/**
+ * Method to write a page to disk at an absolute position
+ **/
+RC writeBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
+{
+    if (fHandle != NULL && fHandle->mgmtInfo != NULL) // checking if file handle is initialized
+    {
+        SM_FileInfo *fInfo = fHandle->mgmtInfo;
+        if (pageNum >= 0 && pageNum <= fHandle->totalNumPages && memPage != NULL) // checking if page number is in range and mempage is initialized
+        {
+            off_t absPos = pageOffset(fInfo, pageNum); // calculating the absolute position
+            long long start = nowNanos();
+            if (fInfo->codec != NULL) // compressed file, the page is compressed into its slot
+            {
+                if (pageNum == fHandle->totalNumPages && growFile(fHandle, pageNum + 1) != RC_OK) // the page map only covers existing pages
+                {
+                    return RC_WRITE_FAILED;
+                }
+                if (writeCompressedPage(fInfo, pageNum, memPage) != RC_OK)
+                {
+                    return RC_WRITE_FAILED;
+                }
+            }
+            else if (fInfo->mapBase != NULL) // mapped file, the page is written through the mapping
+            {
+                if (pageNum == fHandle->totalNumPages && appendEmptyBlock(fHandle) != RC_OK) // the mapping only covers existing pages
+                {
+                    return RC_WRITE_FAILED;
+                }
+                if (memPage != fInfo->mapBase + absPos) // a page handed out by mapBlock is already in place
+                {
+                    memcpy(fInfo->mapBase + absPos, memPage, fInfo->pageSize);
+                }
+            }
+            else if (transferPage(fInfo, memPage, absPos, 1) != fInfo->pageSize)
+            {
+                printError(RC_WRITE_FAILED);
+                return RC_WRITE_FAILED; // returns error code when the page could not be written
+            }
+
+            if (noteWrites(fInfo, 1) != RC_OK) // makes the write durable as the sync policy asks
+            {
+                return RC_WRITE_FAILED;
+            }
+            recordPages(&fInfo->stats, 1, fInfo->pageSize, 1);
+            recordLatency(fInfo->stats.writeLatency, nowNanos() - start);
+
+            if (pageNum == fHandle->totalNumPages) // writing right behind the last page appends a page
+            {
+                fHandle->totalNumPages++;
+            }
+            setBlockPos(fHandle, pageNum); // updates the current page position of the file handle
+            return RC_OK;                  // returns successful response
+        }
+        else
+        {
+            printError(RC_WRITE_FAILED);
+            // perror("[ERROR] PageNum out of bound\n");
+            return RC_WRITE_FAILED; // retuns error code when pagenumber is out of bound
+        }
+    }
+    else
+    {
+        printError(RC_FILE_HANDLE_NOT_INIT);
+        // perror("[ERROR] File handle is not initialized\n");
+        return RC_FILE_HANDLE_NOT_INIT; // returns error code if the file is not initialized
+    }
+}
+
+/**
+ * Method to write count adjacent blocks starting at startPage from the buffers memPages[0..count-1] with a single vectored write.
+ * The run may extend the file, as long as it starts no later than right behind the last page.
+ **/
+RC writeBlocks(int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle memPages[])
+{
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL)
+    {
+        printError(RC_FILE_HANDLE_NOT_INIT);
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+
+    if (startPage < 0 || count < 0 || startPage > fHandle->totalNumPages || memPages == NULL)
+    {
+        printError(RC_WRITE_FAILED);
+        return RC_WRITE_FAILED;
+    }
+    if (count == 0)
+    {
+        return RC_OK;
+    }
+
+    SM_FileInfo *fInfo = fHandle->mgmtInfo;
+    if (fInfo->codec != NULL) // compressed file, every page is compressed into its own slot
+    {
+        RC rc = ensureCapacity(startPage + count, fHandle); // the page map only covers existing pages
+        if (rc != RC_OK)
+        {
+            return rc;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            if (writeCompressedPage(fInfo, startPage + i, memPages[i]) != RC_OK)
+            {
+                return RC_WRITE_FAILED;
+            }
+        }
+    }
+    else if (fInfo->mapBase != NULL) // mapped file, the pages are written through the mapping
+    {
+        RC rc = ensureCapacity(startPage + count, fHandle); // the mapping only covers existing pages
+        if (rc != RC_OK)
+        {
+            return rc;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            char *mapped = fInfo->mapBase + pageOffset(fInfo, startPage + i);
+            if (memPages[i] != mapped) // a page handed out by mapBlock is already in place
+            {
+                memcpy(mapped, memPages[i], fInfo->pageSize);
+            }
+        }
+    }
+    else
+    {
+        if (transferPages(fInfo, memPages, startPage, count, 1) != 0)
+        {
+            printError(RC_WRITE_FAILED);
+            return RC_WRITE_FAILED;
+        }
+        if (startPage + count > fHandle->totalNumPages) // the run extended the file
+        {
+            fHandle->totalNumPages = startPage + count;
+        }
+    }
+
+    if (noteWrites(fInfo, count) != RC_OK) // makes the run durable as the sync policy asks
+    {
+        return RC_WRITE_FAILED;
+    }
+    recordPages(&fInfo->stats, count, fInfo->pageSize, 1);
+    setBlockPos(fHandle, startPage + count - 1); // positioned at the last page written
+    return RC_OK;
+}
+
+/**
+ * Method to write a page to disk at the current position.
+ **/
+RC writeCurrentBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
+{
+    return writeBlock(getBlockPos(fHandle), fHandle, memPage); // passing the current page position to write block
+}
+
+/**
+ * Method to increase the number of pages in the file by one.
+ * The new last page should be filled with zero bytes.
+ **/
+RC appendEmptyBlock(SM_FileHandle *fHandle)
+{
+    if (fHandle != NULL) // checks if file handle is initialized
+    {
+        SM_FileInfo *fInfo = fHandle->mgmtInfo;
+        if (fInfo != NULL) // if file is open
+        {
+            RC rc = growFile(fHandle, fHandle->totalNumPages + 1); // number of pages is increased by 1
+            if (rc == RC_OK)
+            {
+                fHandle->curPagePos = fHandle->totalNumPages - 1; // updating current page position to the new last page
+            }
+            return rc;
+        }
+        else
+        {
+            printError(RC_FILE_NOT_FOUND);
+            // perror("[ERROR] File not found\n");
+            return RC_FILE_NOT_FOUND; // returns error code when file is not found
+        }
+    }
+    printError(RC_FILE_HANDLE_NOT_INIT);
+    // perror("[ERROR] File handle is not initialized\n");
+    return RC_FILE_HANDLE_NOT_INIT; // returns error code when file is not initialized
+}
+
+/**
+ * Method to increase the size to numberOfPages if the file has less than numberOfPages pages.
+ **/
+RC ensureCapacity(int numberOfPages, SM_FileHandle *fHandle)
+{
+    if (fHandle != NULL && fHandle->mgmtInfo != NULL)
+    {
+        return growFile(fHandle, numberOfPages); // grows the file in one step if it has less than numberOfPages pages
+    }
+    printError(RC_FILE_HANDLE_NOT_INIT);
+    // perror("[ERROR] File handle is not initialized\n");
+    return RC_FILE_HANDLE_NOT_INIT; // returns error code
+}
+/**
+ * Method to change how a page file grows, the policy stays in effect until the file is closed.
+ **/
+RC setExtentPolicy(SM_FileHandle *fHandle, const SM_ExtentPolicy *policy)
+{
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL)
+    {
+        printError(RC_FILE_HANDLE_NOT_INIT);
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    if (policy == NULL || policy->minExtentPages < 1 || policy->maxExtentPages < policy->minExtentPages || policy->growthPercent < 0)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    SM_FileInfo *fInfo = fHandle->mgmtInfo;
+    fInfo->extentPolicy = *policy;
+    return RC_OK;
 }
 /* writing blocks to a page file - End */
+
+/* allocating and freeing pages - Begin */
+
+/**
+ * Method to compute the file offset of the free page bitmap of group map.
+ **/
+static off_t freeMapOffset(SM_FileInfo *fInfo, int map)
+{
+    return fInfo->dataOffset + (off_t)map * (fInfo->pagesPerMap + 1) * fInfo->pageSize;
+}
+
+/**
+ * Method to load the free page bitmaps covering the first numberOfPages pages of a file.
+ * Bitmaps of groups the file grew into since the last call are read from disk.
+ **/
+static RC loadFreeMaps(SM_FileInfo *fInfo, int numberOfPages)
+{
+    int needed = (numberOfPages + fInfo->pagesPerMap - 1) / fInfo->pagesPerMap;
+    if (needed <= fInfo->numFreeMaps)
+    {
+        return RC_OK;
+    }
+
+    fInfo->freeMaps = (char **)realloc(fInfo->freeMaps, needed * sizeof(char *));
+    while (fInfo->numFreeMaps < needed)
+    {
+        char *map = allocPageBuffer(1, fInfo->pageSize); // aligned, the file may be open for direct I/O
+        if (map == NULL || transferPage(fInfo, map, freeMapOffset(fInfo, fInfo->numFreeMaps), 0) != fInfo->pageSize)
+        {
+            free(map);
+            printError(RC_READ_NON_EXISTING_PAGE);
+            return RC_READ_NON_EXISTING_PAGE;
+        }
+        for (int i = 0; i < fInfo->pageSize; i++) // counts the free pages of the group
+        {
+            fInfo->numFreePages += __builtin_popcount((unsigned char)map[i]);
+        }
+        fInfo->freeMaps[fInfo->numFreeMaps++] = map;
+    }
+    return RC_OK;
+}
+
+/**
+ * Method to write the free page bitmap of group map back to the file.
+ **/
+static RC storeFreeMap(SM_FileInfo *fInfo, int map)
+{
+    if (transferPage(fInfo, fInfo->freeMaps[map], freeMapOffset(fInfo, map), 1) != fInfo->pageSize)
+    {
+        printError(RC_WRITE_FAILED);
+        return RC_WRITE_FAILED;
+    }
+    return noteWrites(fInfo, 1);
+}
+
+/**
+ * Method to find the lowest numbered free page below totalNumPages and take it out of the free page bitmap.
+ * Returns -1 when no page is free.
+ **/
+static int takeFreePage(SM_FileInfo *fInfo, int totalNumPages)
+{
+    for (int map = 0; map < fInfo->numFreeMaps; map++)
+    {
+        unsigned char *bits = (unsigned char *)fInfo->freeMaps[map];
+        for (int i = 0; i < fInfo->pageSize; i++)
+        {
+            if (bits[i] == 0) // all eight pages are in use
+            {
+                continue;
+            }
+            int bit = __builtin_ctz(bits[i]);
+            int pageNum = map * fInfo->pagesPerMap + i * 8 + bit;
+            if (pageNum >= totalNumPages)
+            {
+                return -1;
+            }
+            bits[i] &= ~(1 << bit);
+            fInfo->numFreePages--;
+            if (storeFreeMap(fInfo, map) != RC_OK)
+            {
+                bits[i] |= (1 << bit); // the page stays free
+                fInfo->numFreePages++;
+                return -1;
+            }
+            return pageNum;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Method to get an empty page for new data. Pages given back with freePage are reused first,
+ * lowest page number first, and are filled with zero bytes. Otherwise an empty page is appended.
+ * The number of the page is stored in pageNum.
+ **/
+RC allocatePage(SM_FileHandle *fHandle, int *pageNum)
+{
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL)
+    {
+        printError(RC_FILE_HANDLE_NOT_INIT);
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    if (pageNum == NULL)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    SM_FileInfo *fInfo = fHandle->mgmtInfo;
+    if (fInfo->pagesPerMap > 0) // files without free page bitmaps can only grow
+    {
+        RC rc = loadFreeMaps(fInfo, fHandle->totalNumPages);
+        if (rc != RC_OK)
+        {
+            return rc;
+        }
+        int freePageNum = (fInfo->numFreePages > 0) ? takeFreePage(fInfo, fHandle->totalNumPages) : -1;
+        if (freePageNum >= 0)
+        {
+            SM_PageHandle emptyPage = allocPageBuffer(1, fInfo->pageSize); // the reused page may still hold its old content
+            rc = (emptyPage != NULL) ? writeBlock(freePageNum, fHandle, emptyPage) : RC_WRITE_FAILED;
+            free(emptyPage);
+            *pageNum = freePageNum;
+            return rc;
+        }
+    }
+
+    RC rc = appendEmptyBlock(fHandle);
+    if (rc == RC_OK)
+    {
+        *pageNum = fHandle->totalNumPages - 1;
+    }
+    return rc;
+}
+
+/**
+ * Method to give page pageNum back for reuse by allocatePage. The page keeps its place in the file,
+ * with punchHole set its disk space is released and it reads as zero bytes afterwards.
+ **/
+RC freePage(int pageNum, SM_FileHandle *fHandle, int punchHole)
+{
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL)
+    {
+        printError(RC_FILE_HANDLE_NOT_INIT);
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    SM_FileInfo *fInfo = fHandle->mgmtInfo;
+    if (fInfo->pagesPerMap == 0) // created before page files had free page bitmaps
+    {
+        printError(RC_NO_FREE_PAGE_MAP);
+        return RC_NO_FREE_PAGE_MAP;
+    }
+    if (pageNum < 0 || pageNum >= fHandle->totalNumPages)
+    {
+        printError(RC_READ_NON_EXISTING_PAGE);
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    RC rc = loadFreeMaps(fInfo, fHandle->totalNumPages);
+    if (rc != RC_OK)
+    {
+        return rc;
+    }
+    int map = pageNum / fInfo->pagesPerMap;
+    int bit = pageNum % fInfo->pagesPerMap;
+    unsigned char *bits = (unsigned char *)fInfo->freeMaps[map];
+    if (bits[bit / 8] & (1 << (bit % 8))) // already free
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    bits[bit / 8] |= (1 << (bit % 8));
+    rc = storeFreeMap(fInfo, map);
+    if (rc != RC_OK)
+    {
+        bits[bit / 8] &= ~(1 << (bit % 8));
+        return rc;
+    }
+    fInfo->numFreePages++;
+
+    SM_FilePos pos;
+    if (punchHole && locate(fInfo, pageOffset(fInfo, pageNum), 0, &pos) == 0) // releasing the space is only an optimization, file systems without hole punching keep it
+    {
+        fallocate(pos.fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, pos.offset, fInfo->pageSize);
+        addStat(&fInfo->stats.syscalls, 1);
+    }
+    return RC_OK;
+}
+
+/* allocating and freeing pages - End */
+
+/* page compression - Begin */
+
+#define SM_SLOT_RAW 0xFFFFFFFFu // length of a page stored as it is because it did not get smaller
+
+/**
+ * Entry of the page map of a compressed page file, entry i describes page i. A page never written has
+ * no slot and reads as zero bytes.
+ */
+typedef struct SM_SlotEntry
+{
+    uint64_t sector;  // first sector of the slot, counted from the end of the header
+    uint32_t sectors; // size of the slot
+    uint32_t length;  // length of the compressed page, 0 for a page never written or SM_SLOT_RAW
+} SM_SlotEntry;
+
+/**
+ * A run of sectors that belongs to no page
+ */
+typedef struct SM_FreeSlot
+{
+    uint64_t sector;
+    uint32_t sectors;
+} SM_FreeSlot;
+
+/**
+ * Page map of an open compressed page file, kept in memory and written through to fileName.map
+ */
+typedef struct SM_PageMap
+{
+    int fd;
+    pthread_mutex_t lock; // held by every read, write and growth of the file, pages move and the arrays below are reallocated
+    SM_SlotEntry *entries;
+    int count;
+    int capacity;
+    SM_FreeSlot *freeSlots; // free space between slots, sorted by sector with neighbours merged, none ends at endSector
+    int numFreeSlots;
+    int freeSlotCapacity;
+    uint64_t endSector;     // first sector behind the last slot, new slots are appended there
+} SM_PageMap;
+
+/**
+ * Method to build the name of the page map file of fileName, the name is released with free().
+ **/
+static char *pageMapName(const char *fileName)
+{
+    size_t length = strlen(fileName) + 5;
+    char *name = (char *)malloc(length);
+    snprintf(name, length, "%s.map", fileName);
+    return name;
+}
+
+/**
+ * Method to make room for numberOfPages entries in the page map.
+ **/
+static void reservePageMap(SM_PageMap *pageMap, int numberOfPages)
+{
+    if (numberOfPages <= pageMap->capacity)
+    {
+        return;
+    }
+    int capacity = (pageMap->capacity > 0) ? pageMap->capacity : 16;
+    while (capacity < numberOfPages)
+    {
+        capacity *= 2;
+    }
+    pageMap->entries = (SM_SlotEntry *)realloc(pageMap->entries, capacity * sizeof(SM_SlotEntry));
+    pageMap->capacity = capacity;
+}
+
+/**
+ * Method to find the first free slot of the page map that starts behind sector, numFreeSlots if there is none.
+ **/
+static int findFreeSlot(SM_PageMap *pageMap, uint64_t sector)
+{
+    int low = 0;
+    int high = pageMap->numFreeSlots;
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if (pageMap->freeSlots[middle].sector <= sector)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * Method to remove free slot i of the page map, the slots behind it move up.
+ **/
+static void removeFreeSlot(SM_PageMap *pageMap, int i)
+{
+    pageMap->numFreeSlots--;
+    memmove(&pageMap->freeSlots[i], &pageMap->freeSlots[i + 1], (pageMap->numFreeSlots - i) * sizeof(SM_FreeSlot));
+}
+
+/**
+ * Method to give the sectors of a slot back to the free space of the file. They are merged with the free slots right
+ * in front of and behind them, and free space reaching the last slot makes the file end earlier.
+ **/
+static void releaseSlot(SM_PageMap *pageMap, uint64_t sector, uint32_t sectors)
+{
+    if (sectors == 0)
+    {
+        return;
+    }
+    int i = findFreeSlot(pageMap, sector);
+    if (i > 0 && pageMap->freeSlots[i - 1].sector + pageMap->freeSlots[i - 1].sectors == sector) // joins the free slot in front
+    {
+        i--;
+        sector = pageMap->freeSlots[i].sector;
+        sectors += pageMap->freeSlots[i].sectors;
+        removeFreeSlot(pageMap, i);
+    }
+    if (i < pageMap->numFreeSlots && sector + sectors == pageMap->freeSlots[i].sector) // joins the free slot behind
+    {
+        sectors += pageMap->freeSlots[i].sectors;
+        removeFreeSlot(pageMap, i);
+    }
+    if (sector + sectors == pageMap->endSector) // behind the last slot, the file ends earlier now
+    {
+        pageMap->endSector = sector;
+        return;
+    }
+
+    if (pageMap->numFreeSlots == pageMap->freeSlotCapacity)
+    {
+        pageMap->freeSlotCapacity = (pageMap->freeSlotCapacity > 0) ? 2 * pageMap->freeSlotCapacity : 16;
+        pageMap->freeSlots = (SM_FreeSlot *)realloc(pageMap->freeSlots, pageMap->freeSlotCapacity * sizeof(SM_FreeSlot));
+    }
+    memmove(&pageMap->freeSlots[i + 1], &pageMap->freeSlots[i], (pageMap->numFreeSlots - i) * sizeof(SM_FreeSlot));
+    pageMap->freeSlots[i].sector = sector;
+    pageMap->freeSlots[i].sectors = sectors;
+    pageMap->numFreeSlots++;
+}
+
+/**
+ * Method to find room for a slot of sectors sectors, first in the free space between slots and then behind the last slot.
+ * Returns the first sector of the slot.
+ **/
+static uint64_t allocateSlot(SM_PageMap *pageMap, uint32_t sectors)
+{
+    for (int i = 0; i < pageMap->numFreeSlots; i++) // first fit, the lowest sectors are used first
+    {
+        SM_FreeSlot *freeSlot = &pageMap->freeSlots[i];
+        if (freeSlot->sectors >= sectors)
+        {
+            uint64_t sector = freeSlot->sector;
+            freeSlot->sector += sectors;
+            freeSlot->sectors -= sectors;
+            if (freeSlot->sectors == 0)
+            {
+                removeFreeSlot(pageMap, i);
+            }
+            return sector;
+        }
+    }
+    uint64_t sector = pageMap->endSector;
+    pageMap->endSector += sectors;
+    return sector;
+}
+
+/**
+ * Method to grow the slot of sectors sectors at sector by extra sectors, if the sectors behind it are free.
+ * Returns 1 when the slot grew.
+ **/
+static int extendSlot(SM_PageMap *pageMap, uint64_t sector, uint32_t sectors, uint32_t extra)
+{
+    uint64_t end = sector + sectors;
+    if (end == pageMap->endSector) // the last slot
+    {
+        pageMap->endSector += extra;
+        return 1;
+    }
+    int i = findFreeSlot(pageMap, end - 1);
+    if (i == pageMap->numFreeSlots || pageMap->freeSlots[i].sector != end || pageMap->freeSlots[i].sectors < extra)
+    {
+        return 0;
+    }
+    pageMap->freeSlots[i].sector += extra;
+    pageMap->freeSlots[i].sectors -= extra;
+    if (pageMap->freeSlots[i].sectors == 0)
+    {
+        removeFreeSlot(pageMap, i);
+    }
+    return 1;
+}
+
+/**
+ * Method to order slots by their first sector for qsort.
+ **/
+static int compareSlots(const void *a, const void *b)
+{
+    uint64_t first = ((const SM_FreeSlot *)a)->sector;
+    uint64_t second = ((const SM_FreeSlot *)b)->sector;
+    return (first > second) - (first < second);
+}
+
+/**
+ * Method to open the page map of compressed page file fileName and read it into memory.
+ * The free space of the file is the space between the slots of the pages.
+ **/
+static RC openPageMap(SM_FileInfo *fInfo, char *fileName)
+{
+    struct stat st;
+    char *name = pageMapName(fileName);
+    int fd = open(name, O_RDWR);
+    free(name);
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return RC_FILE_NOT_FOUND;
+    }
+
+    SM_PageMap *pageMap = (SM_PageMap *)calloc(1, sizeof(SM_PageMap));
+    pageMap->fd = fd;
+    pthread_mutex_init(&pageMap->lock, NULL);
+    pageMap->count = (int)(st.st_size / sizeof(SM_SlotEntry));
+    reservePageMap(pageMap, pageMap->count);
+    size_t bytes = pageMap->count * sizeof(SM_SlotEntry);
+    fInfo->pageMap = pageMap;
+    fInfo->allocatedPages = pageMap->count;
+    if (readFully(fd, pageMap->entries, bytes, 0, NULL) != (ssize_t)bytes)
+    {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    int numSlots = 0;
+    SM_FreeSlot *slots = (SM_FreeSlot *)malloc((pageMap->count + 1) * sizeof(SM_FreeSlot)); // the slots in use, sorted
+    for (int i = 0; i < pageMap->count; i++)
+    {
+        if (pageMap->entries[i].sectors > 0)
+        {
+            slots[numSlots].sector = pageMap->entries[i].sector;
+            slots[numSlots].sectors = pageMap->entries[i].sectors;
+            numSlots++;
+        }
+    }
+    qsort(slots, numSlots, sizeof(SM_FreeSlot), compareSlots);
+    for (int i = 0; i < numSlots; i++)
+    {
+        if (slots[i].sector > pageMap->endSector) // a gap in front of this slot
+        {
+            releaseSlot(pageMap, pageMap->endSector, (uint32_t)(slots[i].sector - pageMap->endSector));
+        }
+        pageMap->endSector = slots[i].sector + slots[i].sectors;
+    }
+    free(slots);
+    return RC_OK;
+}
+
+/**
+ * Method to release the page map of a compressed page file.
+ **/
+static void closePageMap(SM_FileInfo *fInfo)
+{
+    SM_PageMap *pageMap = fInfo->pageMap;
+    if (pageMap == NULL)
+    {
+        return;
+    }
+    close(pageMap->fd);
+    pthread_mutex_destroy(&pageMap->lock);
+    free(pageMap->entries);
+    free(pageMap->freeSlots);
+    free(pageMap);
+    fInfo->pageMap = NULL;
+}
+
+/**
+ * Method to write the page map entry of page pageNum to the page map file.
+ **/
+static RC storeSlotEntry(SM_FileInfo *fInfo, int pageNum)
+{
+    SM_PageMap *pageMap = fInfo->pageMap;
+    if (writeFully(pageMap->fd, &pageMap->entries[pageNum], sizeof(SM_SlotEntry), (off_t)pageNum * sizeof(SM_SlotEntry), &fInfo->stats) != sizeof(SM_SlotEntry))
+    {
+        printError(RC_WRITE_FAILED);
+        return RC_WRITE_FAILED;
+    }
+    return RC_OK;
+}
+
+/**
+ * Method to grow a compressed page file to numberOfPages pages. The new pages have no slot yet, only the page map grows.
+ **/
+static RC growPageMap(SM_FileInfo *fInfo, int numberOfPages)
+{
+    SM_PageMap *pageMap = fInfo->pageMap;
+    RC rc = RC_OK;
+    pthread_mutex_lock(&pageMap->lock);
+    reservePageMap(pageMap, numberOfPages);
+    memset(&pageMap->entries[pageMap->count], 0, (numberOfPages - pageMap->count) * sizeof(SM_SlotEntry));
+    addStat(&fInfo->stats.syscalls, 1);
+    addStat(&fInfo->stats.extends, 1);
+    if (ftruncate(pageMap->fd, (off_t)numberOfPages * sizeof(SM_SlotEntry)) != 0) // zero filled entries
+    {
+        printError(RC_WRITE_FAILED);
+        rc = RC_WRITE_FAILED;
+    }
+    else
+    {
+        pageMap->count = numberOfPages;
+    }
+    pthread_mutex_unlock(&pageMap->lock);
+    return rc;
+}
+
+/**
+ * Method to read page pageNum of a compressed page file into memPage, called with the page map lock held. Only the
+ * sectors holding the compressed page are read.
+ **/
+static RC loadCompressedPage(SM_FileInfo *fInfo, int pageNum, SM_PageHandle memPage)
+{
+    SM_SlotEntry *entry = &fInfo->pageMap->entries[pageNum];
+    off_t offset = fInfo->dataOffset + (off_t)entry->sector * SM_SLOT_SECTOR_SIZE;
+    if (entry->length == 0) // never written, nothing to read
+    {
+        memset(memPage, 0, fInfo->pageSize);
+        return RC_OK;
+    }
+    if (entry->length == SM_SLOT_RAW)
+    {
+        return (readFully(fInfo->fd, memPage, fInfo->pageSize, offset, &fInfo->stats) == fInfo->pageSize) ? RC_OK : RC_READ_NON_EXISTING_PAGE;
+    }
+
+    char *slot = (char *)malloc(entry->length);
+    RC rc = RC_OK;
+    if (readFully(fInfo->fd, slot, entry->length, offset, &fInfo->stats) != (ssize_t)entry->length)
+    {
+        rc = RC_READ_NON_EXISTING_PAGE;
+    }
+    else if (fInfo->codec->decompress(slot, entry->length, memPage, fInfo->pageSize) != fInfo->pageSize)
+    {
+        rc = RC_PAGE_CORRUPT;
+    }
+    free(slot);
+    return rc;
+}
+
+/**
+ * Method to read page pageNum of a compressed page file into memPage under the page map lock, so the page does not move
+ * while it is read.
+ **/
+static RC readCompressedPage(SM_FileInfo *fInfo, int pageNum, SM_PageHandle memPage)
+{
+    pthread_mutex_lock(&fInfo->pageMap->lock);
+    RC rc = loadCompressedPage(fInfo, pageNum, memPage);
+    pthread_mutex_unlock(&fInfo->pageMap->lock);
+    return rc;
+}
+
+/**
+ * Method to write memPage to the existing page pageNum of a compressed page file, called with the page map lock held.
+ * A page that does not get smaller is stored as it is. The page stays in its slot when it fits or the free space right
+ * behind the slot makes it fit, otherwise it moves to a new slot and the old one becomes free space.
+ **/
+static RC storeCompressedPage(SM_FileInfo *fInfo, int pageNum, SM_PageHandle memPage)
+{
+    SM_PageMap *pageMap = fInfo->pageMap;
+    char *slot = (char *)malloc(fInfo->pageSize);
+    const char *data = slot;
+    int length = fInfo->codec->compress(memPage, fInfo->pageSize, slot, fInfo->pageSize);
+    uint32_t sectors = (length + SM_SLOT_SECTOR_SIZE - 1) / SM_SLOT_SECTOR_SIZE;
+    if (length <= 0 || sectors >= (uint32_t)fInfo->pageSize / SM_SLOT_SECTOR_SIZE) // no sector saved
+    {
+        data = memPage;
+        length = fInfo->pageSize;
+        sectors = fInfo->pageSize / SM_SLOT_SECTOR_SIZE;
+    }
+
+    SM_SlotEntry *entry = &pageMap->entries[pageNum];
+    uint32_t grown = 0; // sectors the slot took from the free space right behind it
+    if (sectors > entry->sectors && entry->sectors > 0 && extendSlot(pageMap, entry->sector, entry->sectors, sectors - entry->sectors))
+    {
+        grown = sectors - entry->sectors;
+    }
+    int inPlace = sectors <= entry->sectors + grown; // a page that does not fit into its slot is written to a new one, the old stays intact until then
+    uint64_t sector = inPlace ? entry->sector : allocateSlot(pageMap, sectors);
+    off_t offset = fInfo->dataOffset + (off_t)sector * SM_SLOT_SECTOR_SIZE;
+    ssize_t written = writeFully(fInfo->fd, data, length, offset, &fInfo->stats);
+    free(slot);
+    if (written != length)
+    {
+        if (!inPlace)
+        {
+            releaseSlot(pageMap, sector, sectors);
+        }
+        releaseSlot(pageMap, entry->sector + entry->sectors, grown);
+        printError(RC_WRITE_FAILED);
+        return RC_WRITE_FAILED;
+    }
+
+    SM_SlotEntry previous = *entry;
+    if (inPlace) // the sectors behind the page are freed
+    {
+        releaseSlot(pageMap, entry->sector + sectors, entry->sectors + grown - sectors);
+    }
+    else
+    {
+        releaseSlot(pageMap, entry->sector, entry->sectors);
+    }
+    entry->sector = sector;
+    entry->sectors = sectors;
+    entry->length = (data == memPage) ? SM_SLOT_RAW : (uint32_t)length;
+    if (memcmp(&previous, entry, sizeof(SM_SlotEntry)) != 0) // the page is found through its new entry once the data is written
+    {
+        return storeSlotEntry(fInfo, pageNum);
+    }
+    return RC_OK;
+}
+
+/**
+ * Method to write memPage to the existing page pageNum of a compressed page file under the page map lock
+ **/
+static RC writeCompressedPage(SM_FileInfo *fInfo, int pageNum, SM_PageHandle memPage)
+{
+    pthread_mutex_lock(&fInfo->pageMap->lock);
+    RC rc = storeCompressedPage(fInfo, pageNum, memPage);
+    pthread_mutex_unlock(&fInfo->pageMap->lock);
+    return rc;
+}
+
+/* page compression - End */
+
+/* page buffers - Begin */
+
+/**
+ * Method to allocate numPages zero filled pages of pageSize bytes aligned for direct I/O, the buffer is released with free().
+ * Returns NULL when the memory could not be allocated.
+ **/
+SM_PageHandle allocPageBuffer(int numPages, int pageSize)
+{
+    void *buffer = NULL;
+    if (numPages <= 0 || pageSize <= 0 || posix_memalign(&buffer, SM_DIRECT_IO_ALIGNMENT, (size_t)numPages * pageSize) != 0)
+    {
+        return NULL;
+    }
+    memset(buffer, 0, (size_t)numPages * pageSize);
+    return (SM_PageHandle)buffer;
+}
+
+/* page buffers - End */
+
+/* durability - Begin */
+
+/**
+ * State of the background thread syncing the writes of a file opened with SM_SYNC_GROUP
+ */
+typedef struct SM_Syncer
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wakeUp;  // signalled when a group is complete, a sync is requested or the thread has to stop
+    pthread_cond_t synced;  // signalled after every sync
+    long long writeSeq;     // writes noted so far
+    long long syncedSeq;    // writes known to be durable
+    int syncRequested;      // syncPageFile waits for a sync
+    int failed;             // the last sync failed
+    int stopping;
+} SM_Syncer;
+
+/**
+ * Method to flush the written pages of a file to disk.
+ **/
+static RC syncFile(SM_FileInfo *fInfo)
+{
+    SM_SegmentTable *table = fInfo->segments;
+    int failed = 0;
+    addStat(&fInfo->stats.syncs, 1);
+    if (table == NULL)
+    {
+        addStat(&fInfo->stats.syscalls, 1);
+        failed = fdatasync(fInfo->fd) != 0;
+        if (fInfo->pageMap != NULL) // the entries locating the synced pages
+        {
+            addStat(&fInfo->stats.syscalls, 1);
+            failed |= fdatasync(fInfo->pageMap->fd) != 0;
+        }
+    }
+    else // syncs the segments written since the last sync, a segment written meanwhile is marked again
+    {
+        pthread_mutex_lock(&table->lock);
+        int count = 0;
+        int *fds = (int *)malloc(table->count * sizeof(int));
+        for (int i = 0; i < table->count; i++)
+        {
+            if (table->entries[i].dirty)
+            {
+                table->entries[i].dirty = 0;
+                fds[count++] = table->entries[i].fd;
+            }
+        }
+        pthread_mutex_unlock(&table->lock);
+        for (int i = 0; i < count; i++)
+        {
+            addStat(&fInfo->stats.syscalls, 1);
+            failed |= fdatasync(fds[i]) != 0;
+        }
+        free(fds);
+    }
+    if (failed)
+    {
+        printError(RC_WRITE_FAILED);
+        return RC_WRITE_FAILED;
+    }
+    return RC_OK;
+}
+
+/**
+ * Method run by the sync thread of a file. It syncs when a group of writes is complete, when the oldest
+ * unsynced write has waited groupIntervalMs, when syncPageFile asks for it and a last time when it stops.
+ **/
+static void *syncWorker(void *arg)
+{
+    SM_FileInfo *fInfo = arg;
+    SM_Syncer *syncer = fInfo->syncer;
+    pthread_mutex_lock(&syncer->lock);
+    while (1)
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += fInfo->syncPolicy.groupIntervalMs / 1000;
+        deadline.tv_nsec += (long)(fInfo->syncPolicy.groupIntervalMs % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        int timedOut = 0;
+        while (!syncer->stopping && !syncer->syncRequested && !timedOut &&
+               !(fInfo->syncPolicy.groupWrites > 0 && syncer->writeSeq - syncer->syncedSeq >= fInfo->syncPolicy.groupWrites))
+        {
+            timedOut = pthread_cond_timedwait(&syncer->wakeUp, &syncer->lock, &deadline) != 0;
+        }
+
+        long long target = syncer->writeSeq;
+        syncer->syncRequested = 0;
+        if (target > syncer->syncedSeq) // something to sync, writes arriving meanwhile join the next group
+        {
+            pthread_mutex_unlock(&syncer->lock);
+            RC rc = syncFile(fInfo);
+            pthread_mutex_lock(&syncer->lock);
+            syncer->failed = (rc != RC_OK);
+            syncer->syncedSeq = target;
+        }
+        pthread_cond_broadcast(&syncer->synced);
+        if (syncer->stopping && syncer->syncedSeq == syncer->writeSeq)
+        {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&syncer->lock);
+    return NULL;
+}
+
+/**
+ * Method to start the sync thread of a file.
+ **/
+static RC startSyncer(SM_FileInfo *fInfo)
+{
+    SM_Syncer *syncer = (SM_Syncer *)calloc(1, sizeof(SM_Syncer));
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC); // the interval must not follow changes of the wall clock
+    pthread_mutex_init(&syncer->lock, NULL);
+    pthread_cond_init(&syncer->wakeUp, &attr);
+    pthread_cond_init(&syncer->synced, NULL);
+    pthread_condattr_destroy(&attr);
+
+    fInfo->syncer = syncer;
+    if (pthread_create(&syncer->thread, NULL, syncWorker, fInfo) != 0)
+    {
+        pthread_cond_destroy(&syncer->synced);
+        pthread_cond_destroy(&syncer->wakeUp);
+        pthread_mutex_destroy(&syncer->lock);
+        free(syncer);
+        fInfo->syncer = NULL;
+        return RC_WRITE_FAILED;
+    }
+    return RC_OK;
+}
+
+/**
+ * Method to stop the sync thread of a file after it synced all writes noted so far.
+ **/
+static RC stopSyncer(SM_FileInfo *fInfo)
+{
+    SM_Syncer *syncer = fInfo->syncer;
+    if (syncer == NULL)
+    {
+        return RC_OK;
+    }
+
+    pthread_mutex_lock(&syncer->lock);
+    syncer->stopping = 1;
+    pthread_cond_signal(&syncer->wakeUp);
+    pthread_mutex_unlock(&syncer->lock);
+    pthread_join(syncer->thread, NULL);
+
+    RC rc = syncer->failed ? RC_WRITE_FAILED : RC_OK;
+    pthread_cond_destroy(&syncer->synced);
+    pthread_cond_destroy(&syncer->wakeUp);
+    pthread_mutex_destroy(&syncer->lock);
+    free(syncer);
+    fInfo->syncer = NULL;
+    return rc;
+}
+
+/**
+ * Method to make count pages just written durable as the sync policy of the file asks.
+ **/
+static RC noteWrites(SM_FileInfo *fInfo, int count)
+{
+    switch (fInfo->syncPolicy.mode)
+    {
+    case SM_SYNC_PER_WRITE:
+        return syncFile(fInfo);
+    case SM_SYNC_GROUP:
+    {
+        SM_Syncer *syncer = fInfo->syncer;
+        pthread_mutex_lock(&syncer->lock);
+        syncer->writeSeq += count;
+        if (fInfo->syncPolicy.groupWrites > 0 && syncer->writeSeq - syncer->syncedSeq >= fInfo->syncPolicy.groupWrites) // the group is complete
+        {
+            pthread_cond_signal(&syncer->wakeUp);
+        }
+        pthread_mutex_unlock(&syncer->lock);
+        return RC_OK;
+    }
+    default:
+        return RC_OK;
+    }
+}
+
+/**
+ * Method to change when the writes to a page file are made durable. The default is SM_SYNC_NONE.
+ * Leaving SM_SYNC_GROUP syncs the writes of the current group first.
+ **/
+RC setSyncPolicy(SM_FileHandle *fHandle, const SM_SyncPolicy *policy)
+{
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL)
+    {
+        printError(RC_FILE_HANDLE_NOT_INIT);
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    if (policy == NULL || policy->mode < SM_SYNC_NONE || policy->mode > SM_SYNC_GROUP ||
+        (policy->mode == SM_SYNC_GROUP && (policy->groupIntervalMs <= 0 || policy->groupWrites < 0)))
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    SM_FileInfo *fInfo = fHandle->mgmtInfo;
+    RC rc = RC_OK;
+    if (fInfo->syncer != NULL) // the thread picks up a new policy only at its next wait, so it is restarted
+    {
+        rc = stopSyncer(fInfo);
+    }
+    fInfo->syncPolicy = *policy;
+    if (policy->mode == SM_SYNC_GROUP && startSyncer(fInfo) != RC_OK)
+    {
+        fInfo->syncPolicy.mode = SM_SYNC_PER_WRITE; // without the thread every write is synced on its own
+        rc = RC_WRITE_FAILED;
+    }
+    return rc;
+}
+
+/**
+ * Method to wait until all pages written to the file so far are on disk. With SM_SYNC_GROUP the
+ * caller joins the sync of the current group, so concurrent callers share one fdatasync.
+ **/
+RC syncPageFile(SM_FileHandle *fHandle)
+{
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL)
+    {
+        printError(RC_FILE_HANDLE_NOT_INIT);
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+
+    SM_FileInfo *fInfo = fHandle->mgmtInfo;
+    SM_Syncer *syncer = fInfo->syncer;
+    if (syncer == NULL)
+    {
+        return syncFile(fInfo);
+    }
+
+    pthread_mutex_lock(&syncer->lock);
+    long long target = syncer->writeSeq;
+    if (syncer->syncedSeq < target)
+    {
+        syncer->syncRequested = 1;
+        pthread_cond_signal(&syncer->wakeUp);
+        while (syncer->syncedSeq < target)
+        {
+            pthread_cond_wait(&syncer->synced, &syncer->lock);
+        }
+    }
+    RC rc = syncer->failed ? RC_WRITE_FAILED : RC_OK;
+    pthread_mutex_unlock(&syncer->lock);
+    return rc;
+}
+
+/* durability - End */
+
+/* I/O statistics - Begin */
+
+/**
+ * Method to copy the I/O statistics gathered since the file was opened, or since resetFileStats, into stats.
+ **/
+RC getFileStats(SM_FileHandle *fHandle, SM_FileStats *stats)
+{
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL)
+    {
+        printError(RC_FILE_HANDLE_NOT_INIT);
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    if (stats == NULL)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    SM_FileInfo *fInfo = fHandle->mgmtInfo;
+    long long *from = (long long *)&fInfo->stats; // the statistics consist of counters only
+    long long *to = (long long *)stats;
+    for (size_t i = 0; i < sizeof(SM_FileStats) / sizeof(long long); i++)
+    {
+        to[i] = __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+    }
+    return RC_OK;
+}
+
+/**
+ * Method to set all I/O statistics of a file back to zero.
+ **/
+RC resetFileStats(SM_FileHandle *fHandle)
+{
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL)
+    {
+        printError(RC_FILE_HANDLE_NOT_INIT);
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+
+    SM_FileInfo *fInfo = fHandle->mgmtInfo;
+    long long *counters = (long long *)&fInfo->stats;
+    for (size_t i = 0; i < sizeof(SM_FileStats) / sizeof(long long); i++)
+    {
+        __atomic_store_n(&counters[i], 0, __ATOMIC_RELAXED);
+    }
+    return RC_OK;
+}
+
+/**
+ * Method to estimate a percentile, given as a fraction between 0 and 1, of the latencies counted in histogram.
+ * Returns the upper bound in nanoseconds of the bucket the percentile falls into, 0 for an empty histogram.
+ **/
+long long getLatencyPercentile(const long long histogram[SM_LATENCY_BUCKETS], double percentile)
+{
+    long long total = 0;
+    for (int i = 0; i < SM_LATENCY_BUCKETS; i++)
+    {
+        total += histogram[i];
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    long long rank = (long long)(percentile * total + 0.5); // number of calls at or below the percentile
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+    long long seen = 0;
+    for (int i = 0; i < SM_LATENCY_BUCKETS; i++)
+    {
+        seen += histogram[i];
+        if (seen >= rank)
+        {
+            return 2LL << i; // bucket i ends at 2^(i+1) nanoseconds
+        }
+    }
+    return 2LL << (SM_LATENCY_BUCKETS - 1);
+}
+
+/* I/O statistics - End */
+
+/* asynchronous block I/O - Begin */
+
+/**
+ * A block read or write handed to the asynchronous engine
+ */
+typedef struct SM_IORequest
+{
+    SM_IOCompletion completion;
+    char *buffer; // where the page is transferred, an aligned bounce buffer when target is set
+    char *target; // the caller's unaligned buffer of a request on a direct I/O file, NULL otherwise
+    int fd;       // file of the segment holding the page
+    int segment;
+    off_t offset; // offset of the page inside that file
+    size_t length; // page size of the file
+    ssize_t transferred; // result of a request taken from the completion ring and not settled yet
+    struct SM_IORequest *next;
+} SM_IORequest;
+
+/**
+ * Contains the state of the asynchronous engine of an open page file. Requests go to an io_uring
+ * instance when the kernel provides one and to a pool of worker threads otherwise. Finished requests
+ * are collected on the completed list until pollCompletions hands them out.
+ */
+typedef struct SM_AsyncEngine
+{
+    SM_FileStats *stats; // statistics of the file, finished requests are counted there
+    SM_FileInfo *file;
+    pthread_mutex_t lock;
+    pthread_cond_t workAvailable;
+    pthread_cond_t workDone;
+    SM_IORequest *pendingHead; // requests waiting for a worker thread
+    SM_IORequest *pendingTail;
+    SM_IORequest *completedHead; // finished requests not yet returned by pollCompletions
+    SM_IORequest *completedTail;
+    int numCompleted;
+    int inFlight; // submitted requests that are not finished yet
+    SM_IORequest *reapedHead; // requests taken from the completion ring, settled once the lock is dropped
+    int settling;             // requests of inFlight being settled without the lock, the kernel has no more of them
+    int ringWaiter;           // a thread waits in the kernel for the ring without the lock, see waitForRing
+    int stopping;
+    int numWorkers;
+    pthread_t workers[SM_ASYNC_WORKERS];
+#ifdef HAVE_IO_URING
+    int ringFd; // -1 when the worker pool is used
+    unsigned ringEntries;
+    void *sqRing;
+    void *cqRing;
+    size_t sqRingSize;
+    size_t cqRingSize;
+    struct io_uring_sqe *sqes;
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    struct io_uring_cqe *cqes;
+#endif
+} SM_AsyncEngine;
+
+/**
+ * Method to note a finished asynchronous write to segment for the sync policy of the file
+ */
+static RC noteSegmentWrite(SM_FileInfo *fInfo, int segment)
+{
+    markSegmentDirty(fInfo, segment);
+    return noteWrites(fInfo, 1);
+}
+
+/**
+ * Method to settle the result of a finished request. A write is made durable as the sync policy asks before it is
+ * reported as done, so this is called without the engine lock: a sync under SM_SYNC_PER_WRITE must not stall the
+ * other submitters and pollers of the file.
+ */
+static void settleRequest(SM_AsyncEngine *engine, SM_IORequest *req, ssize_t transferred)
+{
+    if (transferred < 0 || (size_t)transferred != req->length)
+    {
+        req->completion.rc = req->completion.isWrite ? RC_WRITE_FAILED : RC_READ_NON_EXISTING_PAGE;
+    }
+    else if (req->completion.isWrite && noteSegmentWrite(engine->file, req->segment) != RC_OK) // durable before it is reported as done
+    {
+        req->completion.rc = RC_WRITE_FAILED;
+    }
+    else
+    {
+        recordPages(engine->stats, 1, req->length, req->completion.isWrite);
+    }
+    if (req->target != NULL) // hands the page read to the caller and releases the bounce buffer
+    {
+        if (!req->completion.isWrite && req->completion.rc == RC_OK)
+        {
+            memcpy(req->target, req->buffer, req->length);
+        }
+        free(req->buffer);
+        req->buffer = req->target;
+        req->target = NULL;
+    }
+}
+
+/**
+ * Method to put a settled request on the completed list, the engine lock must be held
+ */
+static void completeRequest(SM_AsyncEngine *engine, SM_IORequest *req)
+{
+    req->next = NULL;
+    if (engine->completedTail != NULL)
+    {
+        engine->completedTail->next = req;
+    }
+    else
+    {
+        engine->completedHead = req;
+    }
+    engine->completedTail = req;
+    engine->numCompleted++;
+    engine->inFlight--;
+}
+
+/**
+ * Method run by the worker threads, it performs queued requests with pread/pwrite
+ */
+static void *asyncWorker(void *arg)
+{
+    SM_AsyncEngine *engine = arg;
+    pthread_mutex_lock(&engine->lock);
+    while (1)
+    {
+        while (engine->pendingHead == NULL && !engine->stopping) // sleeps until there is work
+        {
+            pthread_cond_wait(&engine->workAvailable, &engine->lock);
+        }
+        if (engine->pendingHead == NULL) // stopping and nothing left to do
+        {
+            break;
+        }
+
+        SM_IORequest *req = engine->pendingHead;
+        engine->pendingHead = req->next;
+        if (engine->pendingHead == NULL)
+        {
+            engine->pendingTail = NULL;
+        }
+        pthread_mutex_unlock(&engine->lock);
+
+        ssize_t transferred = req->completion.isWrite ? writeFully(req->fd, req->buffer, req->length, req->offset, engine->stats)
+                                                      : readFully(req->fd, req->buffer, req->length, req->offset, engine->stats);
+
+        settleRequest(engine, req, transferred);
+
+        pthread_mutex_lock(&engine->lock);
+        completeRequest(engine, req);
+        pthread_cond_broadcast(&engine->workDone);
+    }
+    pthread_mutex_unlock(&engine->lock);
+    return NULL;
+}
+
+#ifdef HAVE_IO_URING
+/**
+ * Method to set up an io_uring instance for the engine. Returns 0 when the kernel does not provide
+ * io_uring with plain read/write operations, the caller then falls back to the worker pool.
+ */
+static int setupRing(SM_AsyncEngine *engine)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    engine->ringFd = -1;
+
+    int ringFd = (int)syscall(__NR_io_uring_setup, SM_ASYNC_QUEUE_DEPTH, &params);
+    if (ringFd < 0)
+    {
+        return 0;
+    }
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) // IORING_OP_READ/WRITE came with the same kernel release
+    {
+        close(ringFd);
+        return 0;
+    }
+
+    engine->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    engine->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) // both rings share one mapping
+    {
+        if (engine->cqRingSize > engine->sqRingSize)
+        {
+            engine->sqRingSize = engine->cqRingSize;
+        }
+        engine->cqRingSize = engine->sqRingSize;
+    }
+
+    engine->sqRing = mmap(NULL, engine->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (engine->sqRing == MAP_FAILED)
+    {
+        close(ringFd);
+        return 0;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        engine->cqRing = engine->sqRing;
+    }
+    else
+    {
+        engine->cqRing = mmap(NULL, engine->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (engine->cqRing == MAP_FAILED)
+        {
+            munmap(engine->sqRing, engine->sqRingSize);
+            close(ringFd);
+            return 0;
+        }
+    }
+    engine->sqes = mmap(NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (engine->sqes == MAP_FAILED)
+    {
+        if (engine->cqRing != engine->sqRing)
+        {
+            munmap(engine->cqRing, engine->cqRingSize);
+        }
+        munmap(engine->sqRing, engine->sqRingSize);
+        close(ringFd);
+        return 0;
+    }
+
+    char *sq = engine->sqRing;
+    char *cq = engine->cqRing;
+    engine->sqTail = (unsigned *)(sq + params.sq_off.tail);
+    engine->sqMask = (unsigned *)(sq + params.sq_off.ring_mask);
+    engine->sqArray = (unsigned *)(sq + params.sq_off.array);
+    engine->cqHead = (unsigned *)(cq + params.cq_off.head);
+    engine->cqTail = (unsigned *)(cq + params.cq_off.tail);
+    engine->cqMask = (unsigned *)(cq + params.cq_off.ring_mask);
+    engine->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    engine->ringEntries = params.sq_entries;
+    engine->ringFd = ringFd;
+    return 1;
+}
+
+/**
+ * Method to take finished requests from the completion ring for settleReaped, the engine lock must be held. Only the
+ * ring waiter takes them while it waits, so the kernel never has its completions taken from under it.
+ */
+static void reapRing(SM_AsyncEngine *engine)
+{
+    unsigned head = *engine->cqHead;
+    unsigned tail = __atomic_load_n(engine->cqTail, __ATOMIC_ACQUIRE);
+    while (head != tail)
+    {
+        struct io_uring_cqe *cqe = &engine->cqes[head & *engine->cqMask];
+        SM_IORequest *req = (SM_IORequest *)(uintptr_t)cqe->user_data;
+        req->transferred = cqe->res;
+        req->next = engine->reapedHead;
+        engine->reapedHead = req;
+        engine->settling++;
+        head++;
+    }
+    __atomic_store_n(engine->cqHead, head, __ATOMIC_RELEASE);
+}
+
+/**
+ * Method to settle the requests taken from the completion ring and put them on the completed list. Called with the
+ * engine lock held, which is dropped while they are settled.
+ */
+static void settleReaped(SM_AsyncEngine *engine)
+{
+    while (engine->reapedHead != NULL)
+    {
+        SM_IORequest *reaped = engine->reapedHead;
+        engine->reapedHead = NULL;
+        pthread_mutex_unlock(&engine->lock);
+        for (SM_IORequest *req = reaped; req != NULL; req = req->next)
+        {
+            settleRequest(engine, req, req->transferred);
+        }
+        pthread_mutex_lock(&engine->lock);
+        while (reaped != NULL)
+        {
+            SM_IORequest *next = reaped->next;
+            completeRequest(engine, reaped);
+            engine->settling--;
+            reaped = next;
+        }
+        pthread_cond_broadcast(&engine->workDone);
+    }
+}
+
+/**
+ * Method to wait for a request of the ring to finish and settle it, the engine lock must be held. One thread at a
+ * time waits in the kernel, without the lock so submitters and other pollers of the file go on, and reaps the ring
+ * once it is back. Others wait for it on workDone, and so are requests another thread is settling, the kernel does
+ * not report them again.
+ */
+static void waitForRing(SM_AsyncEngine *engine)
+{
+    if (engine->inFlight > engine->settling && !engine->ringWaiter)
+    {
+        engine->ringWaiter = 1;
+        pthread_mutex_unlock(&engine->lock);
+        while (syscall(__NR_io_uring_enter, engine->ringFd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno == EINTR)
+            ;
+        addStat(&engine->stats->syscalls, 1);
+        pthread_mutex_lock(&engine->lock);
+        engine->ringWaiter = 0;
+        reapRing(engine);
+        pthread_cond_broadcast(&engine->workDone); // another thread may wait in the kernel next
+        settleReaped(engine);
+    }
+    else
+    {
+        pthread_cond_wait(&engine->workDone, &engine->lock);
+    }
+}
+
+/**
+ * Method to queue a request on the submission ring and tell the kernel about it, the engine lock must be held
+ */
+static void submitToRing(SM_AsyncEngine *engine, SM_IORequest *req)
+{
+    while (engine->inFlight - engine->settling >= (int)engine->ringEntries) // every slot is in use, wait for one to finish
+    {
+        waitForRing(engine);
+    }
+
+    unsigned tail = *engine->sqTail;
+    unsigned index = tail & *engine->sqMask;
+    struct io_uring_sqe *sqe = &engine->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = req->completion.isWrite ? IORING_OP_WRITE : IORING_OP_READ;
+    sqe->fd = req->fd;
+    sqe->off = req->offset;
+    sqe->addr = (uintptr_t)req->buffer;
+    sqe->len = req->length;
+    sqe->user_data = (uintptr_t)req;
+    engine->sqArray[index] = index;
+    __atomic_store_n(engine->sqTail, tail + 1, __ATOMIC_RELEASE);
+    engine->inFlight++;
+
+    while (syscall(__NR_io_uring_enter, engine->ringFd, 1, 0, 0, NULL, 0) < 0 && errno == EINTR)
+        ;
+    addStat(&engine->stats->syscalls, 1);
+}
+#endif
+
+static pthread_mutex_t engineCreationLock = PTHREAD_MUTEX_INITIALIZER; // first requests of a file create one engine
+
+/**
+ * Method to create the asynchronous engine of a file on its first request
+ */
+static SM_AsyncEngine *getAsyncEngine(SM_FileInfo *fInfo)
+{
+    SM_AsyncEngine *engine = __atomic_load_n(&fInfo->asyncEngine, __ATOMIC_ACQUIRE);
+    if (engine != NULL)
+    {
+        return engine;
+    }
+    pthread_mutex_lock(&engineCreationLock);
+    if (fInfo->asyncEngine != NULL) // another thread created it meanwhile
+    {
+        pthread_mutex_unlock(&engineCreationLock);
+        return fInfo->asyncEngine;
+    }
+
+    engine = (SM_AsyncEngine *)calloc(1, sizeof(SM_AsyncEngine));
+    engine->stats = &fInfo->stats;
+    engine->file = fInfo;
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->workAvailable, NULL);
+    pthread_cond_init(&engine->workDone, NULL);
+
+#ifdef HAVE_IO_URING
+    if (!setupRing(engine)) // no io_uring, start the worker pool instead
+#endif
+    {
+        for (int i = 0; i < SM_ASYNC_WORKERS; i++)
+        {
+            if (pthread_create(&engine->workers[engine->numWorkers], NULL, asyncWorker, engine) == 0)
+            {
+                engine->numWorkers++;
+            }
+        }
+    }
+
+    __atomic_store_n(&fInfo->asyncEngine, engine, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&engineCreationLock);
+    return engine;
+}
+
+/**
+ * Method to wait for all requests in flight and release the asynchronous engine of a file
+ */
+static void destroyAsyncEngine(SM_FileInfo *fInfo)
+{
+    SM_AsyncEngine *engine = fInfo->asyncEngine;
+    if (engine == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+#ifdef HAVE_IO_URING
+    while (engine->ringFd >= 0 && engine->inFlight > 0)
+    {
+        waitForRing(engine);
+    }
+#endif
+    engine->stopping = 1; // workers finish the queued requests before they exit
+    pthread_cond_broadcast(&engine->workAvailable);
+    pthread_mutex_unlock(&engine->lock);
+    for (int i = 0; i < engine->numWorkers; i++)
+    {
+        pthread_join(engine->workers[i], NULL);
+    }
+
+    while (engine->completedHead != NULL) // results nobody asked for
+    {
+        SM_IORequest *req = engine->completedHead;
+        engine->completedHead = req->next;
+        free(req);
+    }
+#ifdef HAVE_IO_URING
+    if (engine->ringFd >= 0)
+    {
+        munmap(engine->sqes, engine->ringEntries * sizeof(struct io_uring_sqe));
+        if (engine->cqRing != engine->sqRing)
+        {
+            munmap(engine->cqRing, engine->cqRingSize);
+        }
+        munmap(engine->sqRing, engine->sqRingSize);
+        close(engine->ringFd);
+    }
+#endif
+    pthread_cond_destroy(&engine->workDone);
+    pthread_cond_destroy(&engine->workAvailable);
+    pthread_mutex_destroy(&engine->lock);
+    free(engine);
+    fInfo->asyncEngine = NULL;
+}
+
+/**
+ * Method to hand a block read or write to the asynchronous engine of a file
+ */
+static RC submitBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage, void *userData, int isWrite)
+{
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL)
+    {
+        printError(RC_FILE_HANDLE_NOT_INIT);
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    if (pageNum < 0 || pageNum >= fHandle->totalNumPages || memPage == NULL) // asynchronous writes do not extend the file
+    {
+        RC rc = isWrite ? RC_WRITE_FAILED : RC_READ_NON_EXISTING_PAGE;
+        printError(rc);
+        return rc;
+    }
+
+    SM_FileInfo *fInfo = fHandle->mgmtInfo;
+    SM_FilePos pos = {fInfo->fd, 0, 0, 0};
+    if (fInfo->mapBase == NULL && fInfo->codec == NULL && locate(fInfo, pageOffset(fInfo, pageNum), 0, &pos) != 0)
+    {
+        RC rc = isWrite ? RC_WRITE_FAILED : RC_READ_NON_EXISTING_PAGE;
+        printError(rc);
+        return rc;
+    }
+    SM_AsyncEngine *engine = getAsyncEngine(fInfo);
+    SM_IORequest *req = (SM_IORequest *)malloc(sizeof(SM_IORequest));
+    req->completion.userData = userData;
+    req->completion.pageNum = pageNum;
+    req->completion.isWrite = isWrite;
+    req->completion.rc = RC_OK;
+    req->buffer = memPage;
+    req->target = NULL;
+    req->fd = pos.fd;
+    req->segment = pos.segment;
+    req->offset = pos.offset;
+    req->length = fInfo->pageSize;
+    req->next = NULL;
+    if (needsBounce(fInfo, memPage)) // direct I/O needs an aligned buffer
+    {
+        req->buffer = allocPageBuffer(1, fInfo->pageSize);
+        if (req->buffer == NULL)
+        {
+            free(req);
+            RC rc = isWrite ? RC_WRITE_FAILED : RC_READ_NON_EXISTING_PAGE;
+            printError(rc);
+            return rc;
+        }
+        if (isWrite)
+        {
+            memcpy(req->buffer, memPage, fInfo->pageSize);
+        }
+        req->target = memPage;
+    }
+
+    if (fInfo->mapBase != NULL || fInfo->codec != NULL) // served right away, without the engine lock
+    {
+        ssize_t transferred = fInfo->pageSize;
+        if (fInfo->mapBase != NULL) // a mapped file is served by a copy
+        {
+            char *mapped = fInfo->mapBase + pageOffset(fInfo, pageNum);
+            if (memPage != mapped)
+            {
+                memcpy(isWrite ? mapped : memPage, isWrite ? memPage : mapped, fInfo->pageSize);
+            }
+        }
+        else if ((isWrite ? writeCompressedPage(fInfo, pageNum, memPage) : readCompressedPage(fInfo, pageNum, memPage)) != RC_OK)
+        {
+            transferred = -1; // located through the page map, under its own lock
+        }
+        settleRequest(engine, req, transferred);
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    if (fInfo->mapBase != NULL || fInfo->codec != NULL)
+    {
+        engine->inFlight++;
+        completeRequest(engine, req);
+    }
+#ifdef HAVE_IO_URING
+    else if (engine->ringFd >= 0)
+    {
+        submitToRing(engine, req);
+    }
+#endif
+    else
+    {
+        if (engine->pendingTail != NULL)
+        {
+            engine->pendingTail->next = req;
+        }
+        else
+        {
+            engine->pendingHead = req;
+        }
+        engine->pendingTail = req;
+        engine->inFlight++;
+        pthread_cond_signal(&engine->workAvailable);
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    if (!isWrite)
+    {
+        noteRead(fHandle, pageNum, 1);
+    }
+    setBlockPos(fHandle, pageNum);
+    return RC_OK;
+}
+
+/**
+ * Method to start reading the block at position pageNum into memPage without waiting for it.
+ * memPage must stay valid until the request is returned by pollCompletions.
+ **/
+RC submitReadBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage, void *userData)
+{
+    return submitBlock(pageNum, fHandle, memPage, userData, 0);
+}
+
+/**
+ * Method to start writing memPage to the existing block at position pageNum without waiting for it.
+ * memPage must stay valid and unchanged until the request is returned by pollCompletions.
+ **/
+RC submitWriteBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage, void *userData)
+{
+    return submitBlock(pageNum, fHandle, memPage, userData, 1);
+}
+
+/**
+ * Method to collect up to maxCompletions finished asynchronous requests of a file. It waits until at least
+ * minCompletions are finished, or until nothing is in flight anymore. Returns the number of completions stored.
+ **/
+int pollCompletions(SM_FileHandle *fHandle, SM_IOCompletion *completions, int maxCompletions, int minCompletions)
+{
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL || completions == NULL)
+    {
+        return 0;
+    }
+    SM_FileInfo *fInfo = fHandle->mgmtInfo;
+    SM_AsyncEngine *engine = __atomic_load_n(&fInfo->asyncEngine, __ATOMIC_ACQUIRE);
+    if (engine == NULL) // nothing was ever submitted
+    {
+        return 0;
+    }
+    if (minCompletions > maxCompletions)
+    {
+        minCompletions = maxCompletions;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+#ifdef HAVE_IO_URING
+    if (engine->ringFd >= 0)
+    {
+        if (!engine->ringWaiter) // otherwise the waiter reaps the ring when it is back
+        {
+            reapRing(engine);
+        }
+        settleReaped(engine);
+        while (engine->numCompleted < minCompletions && engine->inFlight > 0)
+        {
+            waitForRing(engine);
+        }
+    }
+#endif
+    while (engine->numCompleted < minCompletions && engine->inFlight > 0) // worker pool
+    {
+        pthread_cond_wait(&engine->workDone, &engine->lock);
+    }
+
+    int count = 0;
+    while (count < maxCompletions && engine->completedHead != NULL)
+    {
+        SM_IORequest *req = engine->completedHead;
+        engine->completedHead = req->next;
+        if (engine->completedHead == NULL)
+        {
+            engine->completedTail = NULL;
+        }
+        engine->numCompleted--;
+        completions[count++] = req->completion;
+        free(req);
+    }
+    pthread_mutex_unlock(&engine->lock);
+    return count;
+}
+
+/* asynchronous block I/O - End */
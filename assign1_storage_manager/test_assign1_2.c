@@ -0,0 +1,923 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "storage_mgr.h"
+#include "page_codec.h"
+#include "log_mgr.h"
+#include "dberror.h"
+#include "test_helper.h"
+
+// test name
+char *testName;
+
+/* test output files */
+#define TESTPF "test_pagefile.bin"
+
+/* prototypes for test functions */
+static void testMappedPageFile(void);
+static void testMultiBlockReadWrite(void);
+static void testExtentGrowth(void);
+static void testAsyncReadWrite(void);
+static void testDirectIO(void);
+static void testPageSizes(void);
+static void testFreePages(void);
+static void testFileStats(void);
+static void testSyncPolicy(void);
+static void testSegmentedPageFile(void);
+static void testCompressedPageFile(void);
+static void testAccessPattern(void);
+static void testAsyncLogging(void);
+
+/* main function running all tests */
+int
+main (void)
+{
+  testName = "";
+
+  initStorageManager();
+
+  testMappedPageFile();
+  testMultiBlockReadWrite();
+  testExtentGrowth();
+  testAsyncReadWrite();
+  testDirectIO();
+  testPageSizes();
+  testFreePages();
+  testFileStats();
+  testSyncPolicy();
+  testSegmentedPageFile();
+  testCompressedPageFile();
+  testAccessPattern();
+  testAsyncLogging();
+
+  return 0;
+}
+
+/* Try to read, write and grow a page file through its mapping */
+void
+testMappedPageFile(void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle ph;
+  SM_PageHandle mapped;
+  SM_PageHandle first;
+  int i;
+
+  testName = "test mapped page file";
+
+  ph = (SM_PageHandle) malloc(PAGE_SIZE);
+
+  TEST_CHECK(createPageFile (TESTPF));
+  TEST_CHECK(openPageFileMapped (TESTPF, &fh));
+  ASSERT_TRUE((fh.totalNumPages == 1), "expect 1 page in new file");
+
+  // the first page is served in place and is empty
+  TEST_CHECK(mapBlock (0, &fh, &first));
+  for (i=0; i < PAGE_SIZE; i++)
+    ASSERT_TRUE((first[i] == 0), "expected zero byte in first page of freshly initialized page");
+
+  // a page written with writeBlock shows up in the mapping
+  for (i=0; i < PAGE_SIZE; i++)
+    ph[i] = (i % 10) + '0';
+  TEST_CHECK(writeBlock (0, &fh, ph));
+  for (i=0; i < PAGE_SIZE; i++)
+    ASSERT_TRUE((first[i] == (i % 10) + '0'), "character in mapped page is the one we wrote.");
+
+  // growing the file keeps the first pointer valid and maps the new pages
+  TEST_CHECK(appendEmptyBlock (&fh));
+  TEST_CHECK(ensureCapacity (10, &fh));
+  ASSERT_TRUE((fh.totalNumPages == 10), "expect 10 pages after ensureCapacity");
+  TEST_CHECK(mapBlock (0, &fh, &mapped));
+  ASSERT_TRUE((mapped == first), "mapping does not move when the file grows");
+  TEST_CHECK(mapBlock (9, &fh, &mapped));
+  for (i=0; i < PAGE_SIZE; i++)
+    ASSERT_TRUE((mapped[i] == 0), "expected zero byte in appended page");
+
+  // changes made in place are read back through readBlock
+  mapped[0] = 'x';
+  TEST_CHECK(readBlock (9, &fh, ph));
+  ASSERT_TRUE((ph[0] == 'x'), "readBlock sees the page changed in place");
+  ASSERT_ERROR(mapBlock (10, &fh, &mapped), "mapping a page behind the end of the file");
+
+  TEST_CHECK(closePageFile (&fh));
+
+  // the content is in the file after closing it
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_ERROR(mapBlock (0, &fh, &mapped), "mapBlock needs a mapped file");
+  TEST_CHECK(readBlock (9, &fh, ph));
+  ASSERT_TRUE((ph[0] == 'x'), "page changed in place was written to the file");
+  TEST_CHECK(closePageFile (&fh));
+
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  free(ph);
+
+  TEST_DONE();
+}
+
+/* Try to write and read back a run of adjacent pages with single calls */
+void
+testMultiBlockReadWrite(void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle pages[5];
+  int i, j;
+
+  testName = "test multi block read and write";
+
+  for (i=0; i < 5; i++)
+    pages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+
+  TEST_CHECK(createPageFile (TESTPF));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+
+  // write five pages at once, the run extends the file
+  for (i=0; i < 5; i++)
+    memset(pages[i], 'a' + i, PAGE_SIZE);
+  TEST_CHECK(writeBlocks (0, 5, &fh, pages));
+  ASSERT_TRUE((fh.totalNumPages == 5), "expect 5 pages after writing a run of 5 pages");
+  ASSERT_ERROR(writeBlocks (6, 1, &fh, pages), "writing a run that leaves a gap behind the last page");
+
+  // read the middle of the run back
+  for (i=0; i < 5; i++)
+    memset(pages[i], 0, PAGE_SIZE);
+  TEST_CHECK(readBlocks (1, 3, &fh, pages));
+  for (i=0; i < 3; i++)
+    for (j=0; j < PAGE_SIZE; j++)
+      ASSERT_TRUE((pages[i][j] == 'b' + i), "character in page of the run is the one we expected.");
+  ASSERT_ERROR(readBlocks (3, 3, &fh, pages), "reading a run past the last page");
+
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  for (i=0; i < 5; i++)
+    free(pages[i]);
+
+  TEST_DONE();
+}
+
+/* Try to grow a page file by many pages at once */
+void
+testExtentGrowth(void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle ph;
+  SM_ExtentPolicy policy = { 8, 64, 50 };
+  SM_ExtentPolicy invalid = { 8, 4, 50 };
+  SM_FileStats stats;
+  int i;
+
+  testName = "test extent based file growth";
+
+  ph = (SM_PageHandle) malloc(PAGE_SIZE);
+
+  TEST_CHECK(createPageFile (TESTPF));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  TEST_CHECK(setExtentPolicy (&fh, &policy));
+  ASSERT_ERROR(setExtentPolicy (&fh, &invalid), "maximum extent smaller than the minimum extent");
+
+  // one call grows the file by thousands of pages, all of them empty
+  TEST_CHECK(ensureCapacity (5000, &fh));
+  ASSERT_TRUE((fh.totalNumPages == 5000), "expect 5000 pages after ensureCapacity");
+  TEST_CHECK(readLastBlock (&fh, ph));
+  for (i=0; i < PAGE_SIZE; i++)
+    ASSERT_TRUE((ph[i] == 0), "expected zero byte in last page of grown file");
+
+  TEST_CHECK(appendEmptyBlock (&fh));
+  ASSERT_TRUE((fh.totalNumPages == 5001), "expect 5001 pages after appending a page");
+
+  // pages appended inside the extent reserved by the last append do not grow the file again
+  for (i=0; i < 10; i++)
+    TEST_CHECK(appendEmptyBlock (&fh));
+  TEST_CHECK(getFileStats (&fh, &stats));
+  ASSERT_TRUE((stats.extends == 2), "the file is grown once per extent");
+  TEST_CHECK(readLastBlock (&fh, ph));
+  for (i=0; i < PAGE_SIZE; i++)
+    ASSERT_TRUE((ph[i] == 0), "expected zero byte in a page appended inside the extent");
+  TEST_CHECK(closePageFile (&fh));
+
+  // space reserved ahead is not counted as pages of the file
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_TRUE((fh.totalNumPages == 5011), "expect 5011 pages after reopening the file");
+  TEST_CHECK(closePageFile (&fh));
+
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  free(ph);
+
+  TEST_DONE();
+}
+
+/* Try to write and read pages through the asynchronous interface */
+void
+testAsyncReadWrite(void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle pages[10];
+  SM_IOCompletion completions[10];
+  int seen[10];
+  int i, n, done;
+
+  testName = "test asynchronous read and write";
+
+  for (i=0; i < 10; i++)
+    pages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+
+  TEST_CHECK(createPageFile (TESTPF));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  TEST_CHECK(ensureCapacity (10, &fh));
+  ASSERT_TRUE((pollCompletions(&fh, completions, 10, 0) == 0), "no completions before anything was submitted");
+
+  // write ten pages without waiting in between
+  for (i=0; i < 10; i++)
+  {
+    memset(pages[i], 'a' + i, PAGE_SIZE);
+    TEST_CHECK(submitWriteBlock (i, &fh, pages[i], pages[i]));
+  }
+  for (done = 0; done < 10; done += n)
+  {
+    n = pollCompletions(&fh, completions, 10, 1);
+    for (i=0; i < n; i++)
+    {
+      ASSERT_TRUE((completions[i].rc == RC_OK), "asynchronous write succeeded");
+      ASSERT_TRUE((completions[i].isWrite && completions[i].userData == pages[completions[i].pageNum]), "completion belongs to the page written");
+    }
+  }
+  ASSERT_ERROR(submitWriteBlock (10, &fh, pages[0], NULL), "asynchronous write behind the last page");
+
+  // read them back, waiting for all of them at once
+  for (i=0; i < 10; i++)
+  {
+    memset(pages[i], 0, PAGE_SIZE);
+    seen[i] = 0;
+    TEST_CHECK(submitReadBlock (i, &fh, pages[i], NULL));
+  }
+  n = pollCompletions(&fh, completions, 10, 10);
+  ASSERT_EQUALS_INT(10, n, "all asynchronous reads completed");
+  for (i=0; i < n; i++)
+  {
+    ASSERT_TRUE((completions[i].rc == RC_OK && !completions[i].isWrite), "asynchronous read succeeded");
+    seen[completions[i].pageNum]++;
+  }
+  for (i=0; i < 10; i++)
+  {
+    ASSERT_TRUE((seen[i] == 1), "every page was read exactly once");
+    ASSERT_TRUE((pages[i][0] == 'a' + i && pages[i][PAGE_SIZE - 1] == 'a' + i), "page read asynchronously has the content written");
+  }
+
+  // requests still in flight are finished by closing the file
+  TEST_CHECK(submitReadBlock (3, &fh, pages[0], NULL));
+  TEST_CHECK(closePageFile (&fh));
+  ASSERT_TRUE((pages[0][0] == 'd'), "request in flight completed before the file was closed");
+
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  for (i=0; i < 10; i++)
+    free(pages[i]);
+
+  TEST_DONE();
+}
+
+/* Try to read and write pages bypassing the page cache, from aligned and unaligned buffers */
+void
+testDirectIO(void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle aligned;
+  SM_PageHandle unalignedBase;
+  SM_PageHandle unaligned;
+  SM_PageHandle pages[3];
+  SM_IOCompletion completion;
+  int i;
+
+  testName = "test direct I/O";
+
+  aligned = allocPageBuffer(3, PAGE_SIZE);
+  ASSERT_TRUE((aligned != NULL && ((size_t) aligned % SM_DIRECT_IO_ALIGNMENT) == 0), "page buffer is aligned for direct I/O");
+  unalignedBase = (SM_PageHandle) malloc(3 * PAGE_SIZE + 1);
+  unaligned = unalignedBase + 1;
+
+  TEST_CHECK(createPageFile (TESTPF));
+  ASSERT_ERROR(openPageFileWithFlags (TESTPF, &fh, SM_OPEN_DIRECT | SM_OPEN_MAPPED), "direct I/O on a mapped file");
+  TEST_CHECK(openPageFileWithFlags (TESTPF, &fh, SM_OPEN_DIRECT));
+
+  // write from an aligned buffer, read back into an unaligned one
+  memset(aligned, 'a', PAGE_SIZE);
+  TEST_CHECK(writeBlock (0, &fh, aligned));
+  TEST_CHECK(readBlock (0, &fh, unaligned));
+  for (i=0; i < PAGE_SIZE; i++)
+    ASSERT_TRUE((unaligned[i] == 'a'), "character in page read into an unaligned buffer is the one we wrote.");
+
+  // and the other way round, appending a page
+  memset(unaligned, 'b', PAGE_SIZE);
+  TEST_CHECK(writeBlock (1, &fh, unaligned));
+  TEST_CHECK(readBlock (1, &fh, aligned));
+  for (i=0; i < PAGE_SIZE; i++)
+    ASSERT_TRUE((aligned[i] == 'b'), "character in page written from an unaligned buffer is the one we wrote.");
+
+  // a run mixing aligned and unaligned buffers
+  for (i=0; i < 3; i++)
+    pages[i] = (i == 1) ? unaligned : aligned + i * PAGE_SIZE;
+  for (i=0; i < 3; i++)
+    memset(pages[i], 'c' + i, PAGE_SIZE);
+  TEST_CHECK(writeBlocks (0, 3, &fh, pages));
+  for (i=0; i < 3; i++)
+    memset(pages[i], 0, PAGE_SIZE);
+  TEST_CHECK(readBlocks (0, 3, &fh, pages));
+  for (i=0; i < 3; i++)
+    ASSERT_TRUE((pages[i][0] == 'c' + i && pages[i][PAGE_SIZE - 1] == 'c' + i), "page of a run read with direct I/O has the content written");
+
+  // asynchronous read into an unaligned buffer
+  memset(unaligned, 0, PAGE_SIZE);
+  TEST_CHECK(submitReadBlock (2, &fh, unaligned, NULL));
+  ASSERT_EQUALS_INT(1, pollCompletions(&fh, &completion, 1, 1), "asynchronous read completed");
+  ASSERT_TRUE((completion.rc == RC_OK && unaligned[0] == 'e' && unaligned[PAGE_SIZE - 1] == 'e'), "asynchronous read into an unaligned buffer has the content written");
+
+  TEST_CHECK(closePageFile (&fh));
+
+  // the pages reached the file
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_TRUE((fh.totalNumPages == 3), "expect 3 pages after direct writes");
+  TEST_CHECK(readBlock (1, &fh, aligned));
+  ASSERT_TRUE((aligned[0] == 'd'), "page written with direct I/O is in the file");
+  TEST_CHECK(closePageFile (&fh));
+
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  free(aligned);
+  free(unalignedBase);
+
+  TEST_DONE();
+}
+
+/* Try page files with a page size other than PAGE_SIZE and files without a header */
+void
+testPageSizes(void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle pages[2];
+  SM_PageHandle mapped;
+  SM_IOCompletion completion;
+  FILE *legacy;
+  int pageSize = 16 * 1024;
+  int i;
+
+  testName = "test runtime page size";
+
+  for (i=0; i < 2; i++)
+    pages[i] = allocPageBuffer(1, pageSize);
+
+  ASSERT_ERROR(createPageFileWithPageSize (TESTPF, 1000), "page size that is not a power of two");
+  ASSERT_ERROR(createPageFileWithPageSize (TESTPF, 2 * SM_MAX_PAGE_SIZE), "page size above the maximum");
+
+  // the page size of a new file is read back from its header
+  TEST_CHECK(createPageFileWithPageSize (TESTPF, pageSize));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_EQUALS_INT(pageSize, fh.pageSize, "page size read from the file header");
+  ASSERT_TRUE((fh.totalNumPages == 1), "expect 1 page in new file");
+  TEST_CHECK(readFirstBlock (&fh, pages[0]));
+  for (i=0; i < pageSize; i++)
+    ASSERT_TRUE((pages[0][i] == 0), "expected zero byte in first page of freshly initialized page");
+
+  // whole large pages are written and read
+  for (i=0; i < 2; i++)
+    memset(pages[i], 'a' + i, pageSize);
+  TEST_CHECK(writeBlocks (0, 2, &fh, pages));
+  TEST_CHECK(ensureCapacity (4, &fh));
+  memset(pages[0], 0, pageSize);
+  TEST_CHECK(readBlock (1, &fh, pages[0]));
+  ASSERT_TRUE((pages[0][0] == 'b' && pages[0][pageSize - 1] == 'b'), "large page has the content written");
+  TEST_CHECK(submitReadBlock (0, &fh, pages[1], NULL));
+  ASSERT_EQUALS_INT(1, pollCompletions(&fh, &completion, 1, 1), "asynchronous read completed");
+  ASSERT_TRUE((completion.rc == RC_OK && pages[1][pageSize - 1] == 'a'), "large page read asynchronously has the content written");
+  TEST_CHECK(closePageFile (&fh));
+
+  // the mapping uses the same layout
+  TEST_CHECK(openPageFileMapped (TESTPF, &fh));
+  ASSERT_TRUE((fh.totalNumPages == 4), "expect 4 pages after reopening the file");
+  TEST_CHECK(mapBlock (1, &fh, &mapped));
+  ASSERT_TRUE((mapped[0] == 'b' && mapped[pageSize - 1] == 'b'), "mapped large page has the content written");
+  TEST_CHECK(closePageFile (&fh));
+
+  // creating the file again with another page size starts over
+  TEST_CHECK(createPageFile (TESTPF));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_EQUALS_INT(PAGE_SIZE, fh.pageSize, "default page size after creating the file again");
+  ASSERT_TRUE((fh.totalNumPages == 1), "expect 1 page after creating the file again");
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  // a file without header is read with PAGE_SIZE pages
+  legacy = fopen(TESTPF, "wb");
+  memset(pages[0], 'x', PAGE_SIZE);
+  fwrite(pages[0], 1, PAGE_SIZE, legacy);
+  memset(pages[0], 'y', PAGE_SIZE);
+  fwrite(pages[0], 1, PAGE_SIZE, legacy);
+  fclose(legacy);
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_EQUALS_INT(PAGE_SIZE, fh.pageSize, "page size of a file without header");
+  ASSERT_TRUE((fh.totalNumPages == 2), "expect 2 pages in the file without header");
+  TEST_CHECK(readBlock (0, &fh, pages[0]));
+  ASSERT_TRUE((pages[0][0] == 'x'), "first page of a file without header starts at offset 0");
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  for (i=0; i < 2; i++)
+    free(pages[i]);
+
+  TEST_DONE();
+}
+
+/* Try to free pages and get them back from allocatePage */
+void
+testFreePages(void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle ph;
+  SM_PageHandle pages[4];
+  FILE *legacy;
+  int pagesPerMap = PAGE_SIZE * 8;
+  int pageNum;
+  int i;
+
+  testName = "test free page bitmap";
+
+  ph = (SM_PageHandle) malloc(PAGE_SIZE);
+  for (i=0; i < 4; i++)
+    pages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+
+  TEST_CHECK(createPageFile (TESTPF));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  for (i=0; i < 10; i++)
+  {
+    memset(ph, 'a' + i, PAGE_SIZE);
+    TEST_CHECK(writeBlock (i, &fh, ph));
+  }
+
+  // freed pages are reused first, lowest page number first, and come back empty
+  TEST_CHECK(freePage (7, &fh, 1));
+  TEST_CHECK(freePage (3, &fh, 0));
+  ASSERT_ERROR(freePage (3, &fh, 0), "freeing a page that is already free");
+  ASSERT_ERROR(freePage (10, &fh, 0), "freeing a page behind the last page");
+  TEST_CHECK(readBlock (7, &fh, ph));
+  ASSERT_TRUE((ph[0] == 0 && ph[PAGE_SIZE - 1] == 0), "punched page reads as zero bytes");
+  TEST_CHECK(allocatePage (&fh, &pageNum));
+  ASSERT_EQUALS_INT(3, pageNum, "lowest free page is reused first");
+  TEST_CHECK(readBlock (3, &fh, ph));
+  ASSERT_TRUE((ph[0] == 0 && ph[PAGE_SIZE - 1] == 0), "reused page is empty");
+  TEST_CHECK(allocatePage (&fh, &pageNum));
+  ASSERT_EQUALS_INT(7, pageNum, "next free page is reused");
+  TEST_CHECK(allocatePage (&fh, &pageNum));
+  ASSERT_EQUALS_INT(10, pageNum, "without free pages a page is appended");
+  ASSERT_TRUE((fh.totalNumPages == 11), "expect 11 pages after appending a page");
+  TEST_CHECK(readBlock (9, &fh, ph));
+  ASSERT_TRUE((ph[0] == 'j'), "pages in use keep their content");
+
+  // free pages are remembered in the file
+  TEST_CHECK(freePage (5, &fh, 0));
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_TRUE((fh.totalNumPages == 11), "expect 11 pages after reopening the file");
+  TEST_CHECK(allocatePage (&fh, &pageNum));
+  ASSERT_EQUALS_INT(5, pageNum, "page freed before closing the file is reused");
+
+  // a run crossing into the second group of pages skips the bitmap page in between
+  TEST_CHECK(ensureCapacity (pagesPerMap + 10, &fh));
+  for (i=0; i < 4; i++)
+    memset(pages[i], 'p' + i, PAGE_SIZE);
+  TEST_CHECK(writeBlocks (pagesPerMap - 2, 4, &fh, pages));
+  for (i=0; i < 4; i++)
+    memset(pages[i], 0, PAGE_SIZE);
+  TEST_CHECK(readBlocks (pagesPerMap - 2, 4, &fh, pages));
+  for (i=0; i < 4; i++)
+    ASSERT_TRUE((pages[i][0] == 'p' + i && pages[i][PAGE_SIZE - 1] == 'p' + i), "page of a run across groups has the content written");
+  TEST_CHECK(freePage (pagesPerMap + 1, &fh, 0));
+  TEST_CHECK(closePageFile (&fh));
+
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_EQUALS_INT(pagesPerMap + 10, fh.totalNumPages, "page count of a file with two groups");
+  TEST_CHECK(readBlock (pagesPerMap, &fh, ph));
+  ASSERT_TRUE((ph[0] == 'r'), "first page of the second group has the content written");
+  TEST_CHECK(allocatePage (&fh, &pageNum));
+  ASSERT_EQUALS_INT(pagesPerMap + 1, pageNum, "free page of the second group is reused");
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  // a file without header has no bitmap, allocatePage can only append
+  legacy = fopen(TESTPF, "wb");
+  memset(ph, 0, PAGE_SIZE);
+  fwrite(ph, 1, PAGE_SIZE, legacy);
+  fclose(legacy);
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_ERROR(freePage (0, &fh, 0), "freeing a page of a file without free page bitmap");
+  TEST_CHECK(allocatePage (&fh, &pageNum));
+  ASSERT_EQUALS_INT(1, pageNum, "page appended to a file without free page bitmap");
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  free(ph);
+  for (i=0; i < 4; i++)
+    free(pages[i]);
+
+  TEST_DONE();
+}
+
+/* Try the I/O statistics of a page file */
+void
+testFileStats(void)
+{
+  SM_FileHandle fh;
+  SM_FileStats stats;
+  SM_PageHandle pages[3];
+  SM_IOCompletion completion;
+  long long calls;
+  int i;
+
+  testName = "test I/O statistics";
+
+  for (i=0; i < 3; i++)
+    pages[i] = (SM_PageHandle) calloc(PAGE_SIZE, 1);
+
+  TEST_CHECK(createPageFile (TESTPF));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  TEST_CHECK(getFileStats (&fh, &stats));
+  ASSERT_TRUE((stats.reads == 0 && stats.writes == 0 && stats.syscalls == 0), "no I/O right after opening the file");
+
+  TEST_CHECK(ensureCapacity (3, &fh));
+  for (i=0; i < 3; i++)
+    TEST_CHECK(writeBlock (i, &fh, pages[i]));
+  for (i=0; i < 2; i++)
+    TEST_CHECK(readBlock (i, &fh, pages[i]));
+  TEST_CHECK(readBlocks (0, 3, &fh, pages));
+  TEST_CHECK(submitReadBlock (2, &fh, pages[0], NULL));
+  ASSERT_EQUALS_INT(1, pollCompletions(&fh, &completion, 1, 1), "asynchronous read completed");
+
+  TEST_CHECK(getFileStats (&fh, &stats));
+  ASSERT_TRUE((stats.reads == 6), "pages read by readBlock, readBlocks and asynchronous reads are counted");
+  ASSERT_TRUE((stats.writes == 3), "pages written are counted");
+  ASSERT_TRUE((stats.bytesRead == 6 * PAGE_SIZE && stats.bytesWritten == 3 * PAGE_SIZE), "bytes transferred are counted");
+  ASSERT_TRUE((stats.extends == 1), "growing the file is counted");
+  ASSERT_TRUE((stats.syscalls >= 7), "every read and write needs a system call");
+
+  // the histograms hold one entry per readBlock and writeBlock call
+  for (calls = 0, i=0; i < SM_LATENCY_BUCKETS; i++)
+    calls += stats.readLatency[i];
+  ASSERT_TRUE((calls == 2), "readBlock latencies are counted");
+  for (calls = 0, i=0; i < SM_LATENCY_BUCKETS; i++)
+    calls += stats.writeLatency[i];
+  ASSERT_TRUE((calls == 3), "writeBlock latencies are counted");
+  ASSERT_TRUE((getLatencyPercentile(stats.readLatency, 0.5) > 0), "median read latency is known");
+  ASSERT_TRUE((getLatencyPercentile(stats.readLatency, 0.5) <= getLatencyPercentile(stats.readLatency, 0.99)), "percentiles grow");
+
+  TEST_CHECK(resetFileStats (&fh));
+  TEST_CHECK(getFileStats (&fh, &stats));
+  ASSERT_TRUE((stats.reads == 0 && stats.writes == 0 && stats.readLatency[0] == 0), "statistics are zero after a reset");
+
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  for (i=0; i < 3; i++)
+    free(pages[i]);
+
+  TEST_DONE();
+}
+
+/* Try the sync policies of a page file */
+void
+testSyncPolicy(void)
+{
+  SM_FileHandle fh;
+  SM_FileStats stats;
+  SM_PageHandle ph;
+  SM_SyncPolicy perWrite = { SM_SYNC_PER_WRITE, 0, 0 };
+  SM_SyncPolicy group = { SM_SYNC_GROUP, 10000, 0 };
+  SM_SyncPolicy invalid = { SM_SYNC_GROUP, 0, 0 };
+  int i;
+
+  testName = "test sync policies";
+
+  ph = (SM_PageHandle) calloc(PAGE_SIZE, 1);
+
+  TEST_CHECK(createPageFile (TESTPF));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  TEST_CHECK(ensureCapacity (8, &fh));
+
+  // by default nothing is synced
+  TEST_CHECK(writeBlock (0, &fh, ph));
+  TEST_CHECK(getFileStats (&fh, &stats));
+  ASSERT_TRUE((stats.syncs == 0), "no sync without a sync policy");
+  TEST_CHECK(syncPageFile (&fh));
+  TEST_CHECK(getFileStats (&fh, &stats));
+  ASSERT_TRUE((stats.syncs == 1), "syncPageFile syncs right away");
+
+  // one sync per write
+  ASSERT_ERROR(setSyncPolicy (&fh, &invalid), "group sync without interval");
+  TEST_CHECK(setSyncPolicy (&fh, &perWrite));
+  TEST_CHECK(resetFileStats (&fh));
+  for (i=0; i < 4; i++)
+    TEST_CHECK(writeBlock (i, &fh, ph));
+  TEST_CHECK(getFileStats (&fh, &stats));
+  ASSERT_TRUE((stats.syncs == 4), "every write is synced");
+
+  // a group shares one sync, the long interval leaves it to syncPageFile
+  TEST_CHECK(setSyncPolicy (&fh, &group));
+  TEST_CHECK(resetFileStats (&fh));
+  for (i=0; i < 8; i++)
+    TEST_CHECK(writeBlock (i, &fh, ph));
+  TEST_CHECK(getFileStats (&fh, &stats));
+  ASSERT_TRUE((stats.syncs == 0), "writes of a group are not synced one by one");
+  TEST_CHECK(syncPageFile (&fh));
+  TEST_CHECK(getFileStats (&fh, &stats));
+  ASSERT_TRUE((stats.syncs == 1), "the group is synced once");
+  TEST_CHECK(syncPageFile (&fh));
+  TEST_CHECK(getFileStats (&fh, &stats));
+  ASSERT_TRUE((stats.syncs == 1), "nothing left to sync");
+
+  // a complete group is synced by the background thread without waiting for the interval
+  group.groupWrites = 4;
+  TEST_CHECK(setSyncPolicy (&fh, &group));
+  TEST_CHECK(resetFileStats (&fh));
+  for (i=0; i < 4; i++)
+    TEST_CHECK(writeBlock (i, &fh, ph));
+  for (i=0; i < 1000; i++)
+  {
+    TEST_CHECK(getFileStats (&fh, &stats));
+    if (stats.syncs > 0)
+      break;
+    usleep(1000);
+  }
+  ASSERT_TRUE((stats.syncs == 1), "complete group is synced by the background thread");
+
+  // closing the file syncs the last group
+  TEST_CHECK(writeBlock (5, &fh, ph));
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  free(ph);
+
+  TEST_DONE();
+}
+
+/* Try a page file split into segment files */
+void
+testSegmentedPageFile(void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle pages[10];
+  SM_PageHandle ph;
+  SM_IOCompletion completion;
+  int i, j;
+
+  testName = "test segmented page file";
+
+  ph = (SM_PageHandle) malloc(PAGE_SIZE);
+  for (i=0; i < 10; i++)
+  {
+    pages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+    memset(pages[i], 'a' + i, PAGE_SIZE);
+  }
+
+  // segments of four pages, the first one also holds the free page bitmap
+  ASSERT_ERROR(createSegmentedPageFile (TESTPF, PAGE_SIZE, -1), "negative segment size");
+  TEST_CHECK(createSegmentedPageFile (TESTPF, PAGE_SIZE, 4));
+  ASSERT_ERROR(openPageFileMapped (TESTPF, &fh), "segmented page file cannot be mapped");
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_TRUE((fh.totalNumPages == 1), "expect 1 page in new file");
+  ASSERT_TRUE((access(TESTPF ".1", F_OK) != 0), "a new file is a single segment");
+
+  // a run crossing two segment boundaries
+  TEST_CHECK(writeBlocks (0, 10, &fh, pages));
+  ASSERT_TRUE((fh.totalNumPages == 10), "expect 10 pages after the run");
+  ASSERT_TRUE((access(TESTPF ".2", F_OK) == 0), "the run reached the third segment");
+  ASSERT_TRUE((access(TESTPF ".3", F_OK) != 0), "no segment behind the last page");
+  TEST_CHECK(closePageFile (&fh));
+
+  // the pages are found again in their segments
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_TRUE((fh.totalNumPages == 10), "expect 10 pages after reopening");
+  for (i=0; i < 10; i++)
+  {
+    TEST_CHECK(readBlock (i, &fh, ph));
+    for (j=0; j < PAGE_SIZE; j++)
+      ASSERT_TRUE((ph[j] == 'a' + i), "page read from its segment");
+  }
+  TEST_CHECK(submitReadBlock (7, &fh, ph, NULL));
+  ASSERT_TRUE((pollCompletions (&fh, &completion, 1, 1) == 1), "asynchronous read finished");
+  TEST_CHECK(completion.rc);
+  ASSERT_TRUE((ph[0] == 'h'), "asynchronous read from the third segment");
+
+  // growing creates the next segment with zero filled pages
+  TEST_CHECK(ensureCapacity (14, &fh));
+  ASSERT_TRUE((access(TESTPF ".3", F_OK) == 0), "growth reached the fourth segment");
+  TEST_CHECK(readBlock (13, &fh, ph));
+  for (j=0; j < PAGE_SIZE; j++)
+    ASSERT_TRUE((ph[j] == 0), "expected zero byte in a new page");
+  TEST_CHECK(closePageFile (&fh));
+
+  // destroying the file removes every segment
+  TEST_CHECK(destroyPageFile (TESTPF));
+  ASSERT_TRUE((access(TESTPF ".1", F_OK) != 0 && access(TESTPF ".3", F_OK) != 0), "segments are removed");
+
+  for (i=0; i < 10; i++)
+    free(pages[i]);
+  free(ph);
+
+  TEST_DONE();
+}
+
+/* Try a page file whose pages are compressed */
+void
+testCompressedPageFile(void)
+{
+  SM_FileHandle fh;
+  SM_CreateOptions options = {PAGE_SIZE, 0, SM_CODEC_LZ};
+  SM_CreateOptions unknown = {PAGE_SIZE, 0, SM_MAX_CODECS - 1};
+  SM_PageHandle pages[8];
+  SM_PageHandle ph;
+  struct stat st;
+  off_t size;
+  int i, j;
+
+  testName = "test compressed page file";
+
+  ph = (SM_PageHandle) malloc(PAGE_SIZE);
+  for (i=0; i < 8; i++) // pages of records with repeated text, the last one does not compress
+  {
+    pages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+    for (j=0; j < PAGE_SIZE; j++)
+      pages[i][j] = (i == 7) ? (char) rand() : "record 0000 of the compressed page file|"[j % 40] + ((j % 40 == 10) ? i : 0);
+  }
+
+  ASSERT_ERROR(createPageFileWithOptions (TESTPF, &unknown), "unknown codec");
+  TEST_CHECK(createPageFileWithOptions (TESTPF, &options));
+  ASSERT_ERROR(openPageFileMapped (TESTPF, &fh), "compressed page file cannot be mapped");
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_TRUE((fh.totalNumPages == 1), "expect 1 page in new file");
+  TEST_CHECK(writeBlocks (0, 8, &fh, pages));
+  TEST_CHECK(closePageFile (&fh));
+
+  // the pages take less space on disk than their size and read back unchanged
+  ASSERT_TRUE((stat(TESTPF, &st) == 0 && st.st_size < 4 * PAGE_SIZE), "compressed pages are smaller");
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_TRUE((fh.totalNumPages == 8), "expect 8 pages after reopening");
+  for (i=0; i < 8; i++)
+  {
+    TEST_CHECK(readBlock (i, &fh, ph));
+    ASSERT_TRUE((memcmp(ph, pages[i], PAGE_SIZE) == 0), "page read back unchanged");
+  }
+
+  // a page that stops compressing moves to a new slot, its old slot is reused by a page that compresses again
+  TEST_CHECK(writeBlock (2, &fh, pages[7]));
+  TEST_CHECK(writeBlock (7, &fh, pages[3]));
+  TEST_CHECK(appendEmptyBlock (&fh));
+  TEST_CHECK(readBlock (8, &fh, ph));
+  for (j=0; j < PAGE_SIZE; j++)
+    ASSERT_TRUE((ph[j] == 0), "expected zero byte in a new page");
+  TEST_CHECK(closePageFile (&fh));
+
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  for (i=0; i < 8; i++)
+  {
+    TEST_CHECK(readBlock (i, &fh, ph));
+    ASSERT_TRUE((memcmp(ph, pages[(i == 2) ? 7 : (i == 7) ? 3 : i], PAGE_SIZE) == 0), "rewritten page read back");
+  }
+  TEST_CHECK(closePageFile (&fh));
+
+  // pages growing and shrinking over and over reuse the space they free, so the file stops growing
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  for (i=0; i < 100; i++)
+  {
+    TEST_CHECK(writeBlock (1 + i % 3, &fh, pages[(i / 3) % 2 ? 1 + i % 3 : 7]));
+    if (i == 5)
+      ASSERT_TRUE((stat(TESTPF, &st) == 0), "file size taken");
+  }
+  size = st.st_size;
+  ASSERT_TRUE((stat(TESTPF, &st) == 0 && st.st_size <= size), "free space is merged and reused");
+  TEST_CHECK(closePageFile (&fh));
+
+  // destroying the file removes its page map
+  TEST_CHECK(destroyPageFile (TESTPF));
+  ASSERT_TRUE((access(TESTPF ".map", F_OK) != 0), "page map is removed");
+
+  for (i=0; i < 8; i++)
+    free(pages[i]);
+  free(ph);
+
+  TEST_DONE();
+}
+
+/* Try the detection of sequential and random reads */
+void
+testAccessPattern(void)
+{
+  SM_FileHandle fh;
+  SM_FileStats stats;
+  SM_PageHandle pages[8];
+  SM_PageHandle ph;
+  int lookups[] = {40, 5, 61, 22, 33};
+  int i;
+
+  testName = "test access pattern detection";
+
+  ph = (SM_PageHandle) malloc(PAGE_SIZE);
+  for (i=0; i < 8; i++)
+    pages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+
+  TEST_CHECK(createPageFile (TESTPF));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  TEST_CHECK(ensureCapacity (64, &fh));
+  ASSERT_TRUE((getAccessPattern(&fh) == SM_ACCESS_NORMAL), "nothing read yet");
+
+  // a scan reading page after page announces the pages ahead of it
+  TEST_CHECK(readFirstBlock (&fh, ph));
+  for (i=1; i < 16; i++)
+    TEST_CHECK(readNextBlock (&fh, ph));
+  ASSERT_TRUE((getAccessPattern(&fh) == SM_ACCESS_SEQUENTIAL), "scan detected");
+  TEST_CHECK(getFileStats (&fh, &stats));
+  ASSERT_TRUE((stats.readaheadHints >= 2), "readahead windows announced during the scan");
+
+  // reading the current page again does not break the scan
+  TEST_CHECK(readCurrentBlock (&fh, ph));
+  ASSERT_TRUE((getAccessPattern(&fh) == SM_ACCESS_SEQUENTIAL), "scan continues");
+
+  // point lookups all over the file switch readahead off
+  for (i=0; i < 5; i++)
+    TEST_CHECK(readBlock (lookups[i], &fh, ph));
+  ASSERT_TRUE((getAccessPattern(&fh) == SM_ACCESS_RANDOM), "random reads detected");
+  TEST_CHECK(resetFileStats (&fh));
+  TEST_CHECK(getFileStats (&fh, &stats));
+  ASSERT_TRUE((stats.readaheadHints == 0), "no readahead during random reads");
+
+  // a vectored read of a run is a scan of its own
+  TEST_CHECK(readBlocks (48, 8, &fh, pages));
+  ASSERT_TRUE((getAccessPattern(&fh) == SM_ACCESS_SEQUENTIAL), "run detected as scan");
+  TEST_CHECK(getFileStats (&fh, &stats));
+  ASSERT_TRUE((stats.readaheadHints == 1), "the pages behind the run are announced");
+
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  for (i=0; i < 8; i++)
+    free(pages[i]);
+  free(ph);
+
+  TEST_DONE();
+}
+
+/* Try the asynchronous sink of the log */
+void
+testAsyncLogging(void)
+{
+  FILE *out = tmpfile();
+  char line[LOG_MESSAGE_SIZE];
+  char longText[2 * LOG_MESSAGE_SIZE];
+  int lines = 0, i;
+
+  testName = "test asynchronous logging";
+
+  memset(longText, 'x', sizeof(longText) - 1);
+  longText[sizeof(longText) - 1] = '\0';
+
+  ASSERT_ERROR(startAsyncLogging (NULL, 0), "sink needs a stream");
+  TEST_CHECK(startAsyncLogging (out, 0));
+  ASSERT_ERROR(startAsyncLogging (out, 0), "only one sink at a time");
+
+  setLogLevel(LOG_LEVEL_WARN);
+  LOG_INFO("below the runtime level");
+  LOG_WARN("message %d", 1);
+  LOG_ERROR("message %d", 2);
+  LOG_WARN("%s", longText);
+  setLogLevel(LOG_LEVEL_INFO);
+  TEST_CHECK(stopAsyncLogging ());
+  ASSERT_TRUE((getDroppedLogMessages() == 0), "no message dropped");
+
+  // the writer thread wrote every message above the level, each on its own line
+  rewind(out);
+  while (fgets(line, sizeof(line), out) != NULL)
+  {
+    ASSERT_TRUE((line[strlen(line) - 1] == '\n'), "messages end their line");
+    ASSERT_TRUE((strstr(line, "below") == NULL), "message below the level is not written");
+    lines++;
+  }
+  ASSERT_TRUE((lines == 3), "expect 3 messages");
+  rewind(out);
+  ASSERT_TRUE((fgets(line, sizeof(line), out) != NULL && strncmp(line, "[WARN] test_assign1_2.c:", 24) == 0), "level and source in front");
+  ASSERT_TRUE((strstr(line, "message 1\n") != NULL), "formatted message");
+  fclose(out);
+
+  // a ring of two messages without room drops the rest instead of waiting
+  out = tmpfile();
+  TEST_CHECK(startAsyncLogging (out, 2));
+  for (i=0; i < 1000; i++)
+    LOG_WARN("flood %d", i);
+  TEST_CHECK(stopAsyncLogging ());
+  rewind(out);
+  for (lines = 0; fgets(line, sizeof(line), out) != NULL; lines++);
+  ASSERT_TRUE((lines + getDroppedLogMessages() == 1000), "every message written or dropped");
+  fclose(out);
+
+  TEST_DONE();
+}
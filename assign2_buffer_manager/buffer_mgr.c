@@ -1,55 +1,1781 @@
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "dberror.h"
 
 #include "storage_mgr.h"
 #include "buffer_mgr.h"
+#include "log_mgr.h"
+
+/*Page Table Functions - BEGIN*/
+
+/**
+ * Method to compute the slot a page number is searched from
+ */
+static int pageTableHome(const BM_PageTable *table, PageNumber pageNum)
+{
+    unsigned int hash = (unsigned int)pageNum * 2654435761u; // Fibonacci hashing spreads adjacent page numbers
+    return (int)((hash ^ (hash >> 16)) & (unsigned int)table->mask);
+}
+
+/**
+ * Method to create an empty page table with room for numPages pages
+ */
+static void initPageTable(BM_PageTable *table, int numPages)
+{
+    int slots = 2;
+    while (slots < 2 * numPages)
+    {
+        slots *= 2;
+    }
+    table->pages = (PageNumber *)malloc(slots * sizeof(PageNumber));
+    table->frames = (int *)malloc(slots * sizeof(int));
+    table->mask = slots - 1;
+    for (int i = 0; i < slots; i++)
+    {
+        table->pages[i] = NO_PAGE;
+    }
+}
+
+/**
+ * Method to free the slots of a page table
+ */
+static void freePageTable(BM_PageTable *table)
+{
+    free(table->pages);
+    free(table->frames);
+    table->pages = NULL;
+    table->frames = NULL;
+}
+
+/**
+ * Method to find the slot of page pageNum, returns -1 if the page is not in the table
+ */
+static int pageTableSlot(const BM_PageTable *table, PageNumber pageNum)
+{
+    for (int i = pageTableHome(table, pageNum);; i = (i + 1) & table->mask) // the table is never full, an empty slot ends the probe
+    {
+        if (table->pages[i] == pageNum)
+        {
+            return i;
+        }
+        if (table->pages[i] == NO_PAGE)
+        {
+            return -1;
+        }
+    }
+}
+
+/**
+ * Method to add page pageNum held by frame frameNumber to the page table
+ */
+static void pageTableInsert(BM_PageTable *table, PageNumber pageNum, int frameNumber)
+{
+    int i = pageTableHome(table, pageNum);
+    while (table->pages[i] != NO_PAGE && table->pages[i] != pageNum)
+    {
+        i = (i + 1) & table->mask;
+    }
+    table->pages[i] = pageNum;
+    table->frames[i] = frameNumber;
+}
+
+/**
+ * Method to remove page pageNum from the page table. The entries behind it in its probe sequence are moved
+ * up into the gap, so lookups never need tombstones.
+ */
+static void pageTableRemove(BM_PageTable *table, PageNumber pageNum)
+{
+    int gap = pageTableSlot(table, pageNum);
+    if (gap < 0)
+    {
+        return;
+    }
+    for (int i = (gap + 1) & table->mask; table->pages[i] != NO_PAGE; i = (i + 1) & table->mask)
+    {
+        int home = pageTableHome(table, table->pages[i]);
+        if (((i - home) & table->mask) >= ((i - gap) & table->mask)) // the entry may move back to the gap without passing its home slot
+        {
+            table->pages[gap] = table->pages[i];
+            table->frames[gap] = table->frames[i];
+            gap = i;
+        }
+    }
+    table->pages[gap] = NO_PAGE;
+}
+
+/**
+ * Method to find the frame holding page pageNum, returns NULL if the page is not in the pool
+ */
+static BM_PageFrame *lookupFrame(BM_PoolInfo *bpInfo, PageNumber pageNum)
+{
+    int slot = pageTableSlot(&bpInfo->pageTable, pageNum);
+    return (slot < 0) ? NULL : &bpInfo->bufferPool[bpInfo->pageTable.frames[slot]];
+}
+
+/**
+ * Method to tell whether page pageNum is being read while the dirty victim it replaces is written back, see claimFrame
+ */
+static bool isIncoming(BM_PoolInfo *bpInfo, PageNumber pageNum)
+{
+    return pageTableSlot(&bpInfo->incomingTable, pageNum) >= 0;
+}
+
+/**
+ * Method to find the frame holding page pageNum like lookupFrame, once a read of the page next to the write back of a
+ * victim is done. Called with the table latch held, which is left while it waits.
+ */
+static BM_PageFrame *findFrame(BM_PoolInfo *bpInfo, PageNumber pageNum)
+{
+    while (isIncoming(bpInfo, pageNum))
+    {
+        pthread_cond_wait(&bpInfo->pageLoaded, &bpInfo->tableLatch);
+    }
+    return lookupFrame(bpInfo, pageNum);
+}
+
+/**
+ * Method to put page pageNum into a frame, replacing the page table entry of the page the frame held before
+ */
+static void assignFrame(BM_PoolInfo *bpInfo, BM_PageFrame *frame, PageNumber pageNum)
+{
+    if (frame->pageNumber != NO_PAGE)
+    {
+        pageTableRemove(&bpInfo->pageTable, frame->pageNumber);
+    }
+    frame->pageNumber = pageNum;
+    pageTableInsert(&bpInfo->pageTable, pageNum, frame->frameNumber);
+}
+
+/**
+ * Method to tell whether a frame is pinned. The fix count is read atomically, a pin taken by holdFrame is dropped
+ * without the table latch.
+ */
+static bool isPinned(const BM_PageFrame *frame)
+{
+    return __atomic_load_n(&frame->fixCount, __ATOMIC_ACQUIRE) > 0;
+}
+
+/*Page Table Functions - END*/
+
+/*Replacement List Functions - BEGIN*/
+
+/**
+ * Method to put an entry at the head of a list, as its most recently used entry
+ */
+static void listPush(BM_PoolInfo *bpInfo, int list, int entry)
+{
+    BM_List *l = &bpInfo->lists[list];
+    BM_ListEntry *e = &bpInfo->listEntries[entry];
+    e->list = list;
+    e->previous = -1;
+    e->next = l->head;
+    if (l->head >= 0)
+    {
+        bpInfo->listEntries[l->head].previous = entry;
+    }
+    else
+    {
+        l->tail = entry;
+    }
+    l->head = entry;
+    l->length++;
+}
+
+/**
+ * Method to take an entry out of the list holding it, if any
+ */
+static void listRemove(BM_PoolInfo *bpInfo, int entry)
+{
+    BM_ListEntry *e = &bpInfo->listEntries[entry];
+    if (e->list < 0)
+    {
+        return;
+    }
+    BM_List *l = &bpInfo->lists[e->list];
+    if (e->previous >= 0)
+    {
+        bpInfo->listEntries[e->previous].next = e->next;
+    }
+    else
+    {
+        l->head = e->next;
+    }
+    if (e->next >= 0)
+    {
+        bpInfo->listEntries[e->next].previous = e->previous;
+    }
+    else
+    {
+        l->tail = e->previous;
+    }
+    l->length--;
+    e->list = -1;
+}
+
+/**
+ * Method to find the ghost entry of an evicted page, returns -1 if the page is not remembered
+ */
+static int findGhost(BM_PoolInfo *bpInfo, PageNumber pageNum)
+{
+    int slot = pageTableSlot(&bpInfo->ghostTable, pageNum);
+    return (slot < 0) ? -1 : bpInfo->ghostTable.frames[slot];
+}
+
+/**
+ * Method to forget an evicted page, its ghost entry goes back to the free list
+ */
+static void forgetPage(BM_PoolInfo *bpInfo, int entry)
+{
+    pageTableRemove(&bpInfo->ghostTable, bpInfo->listEntries[entry].pageNum);
+    bpInfo->listEntries[entry].pageNum = NO_PAGE;
+    listRemove(bpInfo, entry);
+    listPush(bpInfo, BM_LIST_FREE, entry);
+}
+
+/**
+ * Method to remember an evicted page at the head of a ghost list. When every ghost entry is in use the oldest ghost
+ * of the longer ghost list is forgotten, which also bounds the ghost list of 2Q.
+ */
+static void rememberPage(BM_PoolInfo *bpInfo, PageNumber pageNum, int list)
+{
+    int entry = bpInfo->lists[BM_LIST_FREE].head;
+    if (entry < 0)
+    {
+        int oldest = (bpInfo->lists[BM_LIST_RECENT_GHOSTS].length >= bpInfo->lists[BM_LIST_FREQUENT_GHOSTS].length) ? BM_LIST_RECENT_GHOSTS : BM_LIST_FREQUENT_GHOSTS;
+        forgetPage(bpInfo, bpInfo->lists[oldest].tail);
+        entry = bpInfo->lists[BM_LIST_FREE].head;
+    }
+    listRemove(bpInfo, entry);
+    bpInfo->listEntries[entry].pageNum = pageNum;
+    pageTableInsert(&bpInfo->ghostTable, pageNum, entry);
+    listPush(bpInfo, list, entry);
+}
+
+/**
+ * Method to find the least recently used unpinned frame of a list of frames, returns NULL if all of them are pinned
+ */
+static BM_PageFrame *listVictim(BM_PoolInfo *bpInfo, int list)
+{
+    for (int i = bpInfo->lists[list].tail; i >= 0; i = bpInfo->listEntries[i].previous)
+    {
+        if (!isPinned(&bpInfo->bufferPool[i]))
+        {
+            return &bpInfo->bufferPool[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Method to set up the lists of LRU, ARC and 2Q with an entry for every frame and numGhosts ghost entries, all ghost
+ * entries start on the free list
+ */
+static void initReplacementLists(BM_PoolInfo *bpInfo, int numPages, int numGhosts)
+{
+    for (int i = 0; i < BM_NUM_LISTS; i++)
+    {
+        bpInfo->lists[i].head = -1;
+        bpInfo->lists[i].tail = -1;
+        bpInfo->lists[i].length = 0;
+    }
+    bpInfo->listEntries = (BM_ListEntry *)malloc((numPages + numGhosts) * sizeof(BM_ListEntry));
+    for (int i = 0; i < numPages + numGhosts; i++)
+    {
+        bpInfo->listEntries[i].pageNum = NO_PAGE;
+        bpInfo->listEntries[i].list = -1;
+        bpInfo->listEntries[i].previous = -1;
+        bpInfo->listEntries[i].next = -1;
+        if (i >= numPages)
+        {
+            listPush(bpInfo, BM_LIST_FREE, i);
+        }
+    }
+    initPageTable(&bpInfo->ghostTable, numGhosts);
+}
+
+/*Replacement List Functions - END*/
+
+/*Replacement Policy Functions - BEGIN*/
+
+/**
+ * Method to pick the FIFO victim. Frames are loaded in order, so the hand going round them points at the frame
+ * loaded longest ago. Pinned frames are passed over.
+ */
+static BM_PageFrame *fifoPickVictim(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    for (int i = 0; i < bm->numPages; i++)
+    {
+        BM_PageFrame *frame = bpInfo->hand;
+        bpInfo->hand = frame->nextFrame;
+        if (!isPinned(frame))
+        {
+            return frame;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Method to set up the single list of LRU, the frames in the order they were last pinned
+ */
+static RC lruInit(BM_BufferPool *const bm, void *stratData, const BM_PoolOptions *options)
+{
+    initReplacementLists(bm->mgmtData, bm->numPages, 0);
+    return RC_OK;
+}
+
+/**
+ * Method to free the lists of LRU, ARC and 2Q
+ */
+static void listsShutdown(BM_BufferPool *const bm)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    free(bpInfo->listEntries);
+    freePageTable(&bpInfo->ghostTable);
+}
+
+/**
+ * Method to make the frame of a pinned page the most recently used one
+ */
+static void lruTouch(BM_BufferPool *const bm, BM_PageFrame *frame)
+{
+    listRemove(bm->mgmtData, frame->frameNumber);
+    listPush(bm->mgmtData, BM_LIST_RECENT, frame->frameNumber);
+}
+
+/**
+ * Method to pick the LRU victim, the unpinned frame pinned longest ago
+ */
+static BM_PageFrame *lruPickVictim(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    return listVictim(bm->mgmtData, BM_LIST_RECENT);
+}
+
+/**
+ * Method to take a frame out of the lists of LRU, ARC and 2Q when its page is evicted
+ */
+static void lruEvict(BM_BufferPool *const bm, BM_PageFrame *frame, PageNumber evicted)
+{
+    listRemove(bm->mgmtData, frame->frameNumber);
+}
+
+/**
+ * Method to give the frame of a pinned page its CLOCK reference bit
+ */
+static void clockReference(BM_BufferPool *const bm, BM_PageFrame *frame)
+{
+    frame->referenced = true;
+}
+
+/**
+ * Method to pick the CLOCK (second chance) victim. The hand goes round the frames, clearing the reference bits it
+ * passes, and takes the first unpinned frame whose bit is already clear. Two rounds are enough, the first one clears
+ * every bit.
+ */
+static BM_PageFrame *clockPickVictim(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    for (int i = 0; i < 2 * bm->numPages; i++)
+    {
+        BM_PageFrame *frame = bpInfo->hand;
+        bpInfo->hand = frame->nextFrame;
+        if (isPinned(frame)) // pinned frames keep their bit
+        {
+            continue;
+        }
+        if (frame->referenced) // second chance
+        {
+            frame->referenced = false;
+            continue;
+        }
+        return frame;
+    }
+    return NULL;
+}
+
+/**
+ * Method to take an empty bucket for the given count from the free list and link it in after bucket after,
+ * or as the lowest bucket if after is NULL
+ */
+static BM_FrequencyBucket *newBucket(BM_PoolInfo *bpInfo, int frequency, BM_FrequencyBucket *after)
+{
+    BM_FrequencyBucket *bucket = bpInfo->freeBuckets;
+    bpInfo->freeBuckets = bucket->next;
+    bucket->frequency = frequency;
+    bucket->first = NULL;
+    bucket->last = NULL;
+    bucket->previous = after;
+    bucket->next = (after != NULL) ? after->next : bpInfo->lowestBucket;
+    if (bucket->next != NULL)
+    {
+        bucket->next->previous = bucket;
+    }
+    if (after != NULL)
+    {
+        after->next = bucket;
+    }
+    else
+    {
+        bpInfo->lowestBucket = bucket;
+    }
+    return bucket;
+}
+
+/**
+ * Method to unlink an empty bucket and give it back to the free list
+ */
+static void releaseBucket(BM_PoolInfo *bpInfo, BM_FrequencyBucket *bucket)
+{
+    if (bucket->previous != NULL)
+    {
+        bucket->previous->next = bucket->next;
+    }
+    else
+    {
+        bpInfo->lowestBucket = bucket->next;
+    }
+    if (bucket->next != NULL)
+    {
+        bucket->next->previous = bucket->previous;
+    }
+    bucket->next = bpInfo->freeBuckets;
+    bpInfo->freeBuckets = bucket;
+}
+
+/**
+ * Method to add a frame to a bucket, at its end or, if asFirst is set, as its next victim
+ */
+static void bucketInsert(BM_FrequencyBucket *bucket, BM_PageFrame *frame, bool asFirst)
+{
+    frame->bucket = bucket;
+    frame->previousInBucket = asFirst ? NULL : bucket->last;
+    frame->nextInBucket = asFirst ? bucket->first : NULL;
+    if (frame->previousInBucket != NULL)
+    {
+        frame->previousInBucket->nextInBucket = frame;
+    }
+    else
+    {
+        bucket->first = frame;
+    }
+    if (frame->nextInBucket != NULL)
+    {
+        frame->nextInBucket->previousInBucket = frame;
+    }
+    else
+    {
+        bucket->last = frame;
+    }
+}
+
+/**
+ * Method to take a frame out of its bucket, the bucket is released when it becomes empty
+ */
+static void bucketRemove(BM_PoolInfo *bpInfo, BM_PageFrame *frame)
+{
+    BM_FrequencyBucket *bucket = frame->bucket;
+    if (frame->previousInBucket != NULL)
+    {
+        frame->previousInBucket->nextInBucket = frame->nextInBucket;
+    }
+    else
+    {
+        bucket->first = frame->nextInBucket;
+    }
+    if (frame->nextInBucket != NULL)
+    {
+        frame->nextInBucket->previousInBucket = frame->previousInBucket;
+    }
+    else
+    {
+        bucket->last = frame->previousInBucket;
+    }
+    frame->bucket = NULL;
+    if (bucket->first == NULL)
+    {
+        releaseBucket(bpInfo, bucket);
+    }
+}
+
+/**
+ * Method to count a reference to the page of a frame by moving the frame to the bucket of the next higher count
+ */
+static void countReference(BM_PoolInfo *bpInfo, BM_PageFrame *frame)
+{
+    BM_FrequencyBucket *bucket = frame->bucket;
+    BM_FrequencyBucket *target = bucket->next;
+    if (target == NULL || target->frequency != bucket->frequency + 1)
+    {
+        target = newBucket(bpInfo, bucket->frequency + 1, bucket);
+    }
+    bucketRemove(bpInfo, frame);
+    bucketInsert(target, frame, false);
+}
+
+/**
+ * Method to halve every reference count, so pages that were hot long ago can be replaced. Buckets whose counts
+ * become equal are merged, the frames of the lower one stay in front.
+ */
+static void ageFrequencies(BM_PoolInfo *bpInfo)
+{
+    BM_FrequencyBucket *bucket = bpInfo->lowestBucket;
+    while (bucket != NULL)
+    {
+        BM_FrequencyBucket *next = bucket->next;
+        BM_FrequencyBucket *previous = bucket->previous;
+        bucket->frequency = (bucket->frequency > 1) ? bucket->frequency / 2 : 1;
+        if (previous != NULL && previous->frequency == bucket->frequency)
+        {
+            for (BM_PageFrame *frame = bucket->first; frame != NULL; frame = frame->nextInBucket)
+            {
+                frame->bucket = previous;
+            }
+            previous->last->nextInBucket = bucket->first;
+            bucket->first->previousInBucket = previous->last;
+            previous->last = bucket->last;
+            bucket->first = NULL;
+            releaseBucket(bpInfo, bucket);
+        }
+        bucket = next;
+    }
+    LOG_DEBUG("Reference counts halved");
+}
+
+/**
+ * Method to set up the LFU buckets of a pool, one bucket more than frames, all of them on the free list
+ */
+static RC lfuInit(BM_BufferPool *const bm, void *stratData, const BM_PoolOptions *options)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    if (options != NULL && options->agingPeriod < 0)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+    bpInfo->agingPeriod = (options != NULL) ? options->agingPeriod : 0;
+    bpInfo->pinsSinceAging = 0;
+    bpInfo->lowestBucket = NULL;
+    bpInfo->freeBuckets = NULL;
+    bpInfo->buckets = (BM_FrequencyBucket *)malloc((bm->numPages + 1) * sizeof(BM_FrequencyBucket));
+    for (int i = bm->numPages; i >= 0; i--)
+    {
+        bpInfo->buckets[i].next = bpInfo->freeBuckets;
+        bpInfo->freeBuckets = &bpInfo->buckets[i];
+    }
+    return RC_OK;
+}
+
+/**
+ * Method to free the LFU buckets
+ */
+static void lfuShutdown(BM_BufferPool *const bm)
+{
+    free(((BM_PoolInfo *)bm->mgmtData)->buckets);
+}
+
+/**
+ * Method to count a pin for the aging of LFU, all counts are halved every agingPeriod pins
+ */
+static void lfuCountPin(BM_PoolInfo *bpInfo)
+{
+    if (bpInfo->agingPeriod > 0 && ++bpInfo->pinsSinceAging >= bpInfo->agingPeriod)
+    {
+        ageFrequencies(bpInfo);
+        bpInfo->pinsSinceAging = 0;
+    }
+}
+
+/**
+ * Method to count a pin of a page in the pool
+ */
+static void lfuHit(BM_BufferPool *const bm, BM_PageFrame *frame)
+{
+    countReference(bm->mgmtData, frame);
+    lfuCountPin(bm->mgmtData);
+}
+
+/**
+ * Method to pick the LFU victim, the page referenced the fewest times and among those the one that reached its count
+ * first. Pinned frames are passed over, usually the first frame of the lowest bucket is taken.
+ */
+static BM_PageFrame *lfuPickVictim(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    for (BM_FrequencyBucket *bucket = bpInfo->lowestBucket; bucket != NULL; bucket = bucket->next)
+    {
+        for (BM_PageFrame *frame = bucket->first; frame != NULL; frame = frame->nextInBucket)
+        {
+            if (!isPinned(frame))
+            {
+                return frame;
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Method to take the frame of an evicted page out of its bucket
+ */
+static void lfuEvict(BM_BufferPool *const bm, BM_PageFrame *frame, PageNumber evicted)
+{
+    bucketRemove(bm->mgmtData, frame);
+}
+
+/**
+ * Method to give a page entering the pool a count of one
+ */
+static void lfuLoad(BM_BufferPool *const bm, BM_PageFrame *frame)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    BM_FrequencyBucket *lowest = bpInfo->lowestBucket;
+    if (lowest == NULL || lowest->frequency != 1)
+    {
+        lowest = newBucket(bpInfo, 1, NULL);
+    }
+    bucketInsert(lowest, frame, false);
+    lfuCountPin(bpInfo);
+}
+
+/**
+ * Method to set up the LRU-K histories of a pool, every frame and every retained entry gets an array of K times.
+ * K is read from the int stratData points to, NULL gives BM_LRU_K_DEFAULT_K.
+ */
+static RC lrukInit(BM_BufferPool *const bm, void *stratData, const BM_PoolOptions *options)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    int k = (stratData != NULL) ? *(int *)stratData : BM_LRU_K_DEFAULT_K;
+    if (k < 1 || (options != NULL && (options->correlatedPeriod < 0 || options->retainedPages < 0)))
+    {
+        return RC_INVALID_PARAMETER;
+    }
+    bpInfo->k = k;
+    bpInfo->clock = 0;
+    bpInfo->correlatedPeriod = (options != NULL) ? options->correlatedPeriod : 0;
+    bpInfo->numRetained = (options != NULL && options->retainedPages > 0) ? options->retainedPages : bm->numPages;
+    bpInfo->nextRetained = 0;
+
+    bpInfo->historyData = (long *)calloc((size_t)(bm->numPages + bpInfo->numRetained) * k, sizeof(long));
+    bpInfo->retained = (BM_RetainedHistory *)malloc(bpInfo->numRetained * sizeof(BM_RetainedHistory));
+    for (int i = 0; i < bm->numPages; i++)
+    {
+        bpInfo->bufferPool[i].history = &bpInfo->historyData[(size_t)i * k];
+    }
+    for (int i = 0; i < bpInfo->numRetained; i++)
+    {
+        bpInfo->retained[i].pageNum = NO_PAGE;
+        bpInfo->retained[i].lastReference = 0;
+        bpInfo->retained[i].history = &bpInfo->historyData[(size_t)(bm->numPages + i) * k];
+    }
+    initPageTable(&bpInfo->retainedTable, bpInfo->numRetained);
+    return RC_OK;
+}
+
+/**
+ * Method to free the LRU-K histories
+ */
+static void lrukShutdown(BM_BufferPool *const bm)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    freePageTable(&bpInfo->retainedTable);
+    free(bpInfo->historyData);
+    free(bpInfo->retained);
+}
+
+/**
+ * Method to keep the LRU-K history of page pageNum, which is leaving its frame. The ring of retained histories
+ * overwrites its oldest entry when it is full, so only recently evicted pages are remembered.
+ */
+static void retainHistory(BM_PoolInfo *bpInfo, BM_PageFrame *frame, PageNumber pageNum)
+{
+    BM_RetainedHistory *entry;
+    int slot = pageTableSlot(&bpInfo->retainedTable, pageNum);
+    if (slot >= 0) // kept before, when writing the page back failed and it stayed in its frame
+    {
+        entry = &bpInfo->retained[bpInfo->retainedTable.frames[slot]];
+    }
+    else
+    {
+        entry = &bpInfo->retained[bpInfo->nextRetained];
+        if (entry->pageNum != NO_PAGE)
+        {
+            pageTableRemove(&bpInfo->retainedTable, entry->pageNum);
+        }
+        entry->pageNum = pageNum;
+        pageTableInsert(&bpInfo->retainedTable, entry->pageNum, bpInfo->nextRetained);
+        bpInfo->nextRetained = (bpInfo->nextRetained + 1) % bpInfo->numRetained;
+    }
+    entry->lastReference = frame->lastReference;
+    memcpy(entry->history, frame->history, bpInfo->k * sizeof(long));
+}
+
+/**
+ * Method to start the LRU-K history of a page just loaded into a frame, continuing its retained history if it has one.
+ * Loading the page is an uncorrelated reference at time now.
+ */
+static void loadHistory(BM_PoolInfo *bpInfo, BM_PageFrame *frame, long now)
+{
+    int slot = pageTableSlot(&bpInfo->retainedTable, frame->pageNumber);
+    if (slot >= 0)
+    {
+        BM_RetainedHistory *entry = &bpInfo->retained[bpInfo->retainedTable.frames[slot]];
+        memcpy(frame->history, entry->history, bpInfo->k * sizeof(long));
+        pageTableRemove(&bpInfo->retainedTable, entry->pageNum);
+        entry->pageNum = NO_PAGE;
+    }
+    else
+    {
+        memset(frame->history, 0, bpInfo->k * sizeof(long));
+    }
+    memmove(&frame->history[1], &frame->history[0], (bpInfo->k - 1) * sizeof(long));
+    frame->history[0] = now;
+    frame->lastReference = now;
+}
+
+/**
+ * Method to record a pin of a page in the pool at time now. A pin within the correlated period of the last one only moves
+ * the last reference. Otherwise it is a new reference and the older ones are moved forward by the length of the correlated
+ * period that just ended, so a burst of pins counts as a single reference.
+ */
+static void noteReference(BM_PoolInfo *bpInfo, BM_PageFrame *frame, long now)
+{
+    if (now - frame->lastReference > bpInfo->correlatedPeriod)
+    {
+        long correlatedSpan = frame->lastReference - frame->history[0];
+        for (int i = bpInfo->k - 1; i > 0; i--)
+        {
+            frame->history[i] = (frame->history[i - 1] != 0) ? frame->history[i - 1] + correlatedSpan : 0;
+        }
+        frame->history[0] = now;
+    }
+    frame->lastReference = now;
+}
+
+/**
+ * Method to choose the LRU-K victim, the unpinned frame whose K-th most recent reference is the oldest. Pages with fewer
+ * than K references have an infinite backward K-distance and go first, the least recently used of them. Pages still in
+ * their correlated period are only taken when no other frame is unpinned.
+ */
+static BM_PageFrame *findLRUKVictim(BM_BufferPool *const bm, BM_PoolInfo *bpInfo, long now)
+{
+    BM_PageFrame *victim = NULL;
+    BM_PageFrame *correlated = NULL; // least recently used frame in its correlated period
+    int last = bpInfo->k - 1;
+    for (int i = 0; i < bm->numPages; i++)
+    {
+        BM_PageFrame *frame = &bpInfo->bufferPool[i];
+        if (isPinned(frame))
+        {
+            continue;
+        }
+        if (now - frame->lastReference <= bpInfo->correlatedPeriod)
+        {
+            if (correlated == NULL || frame->lastReference < correlated->lastReference)
+            {
+                correlated = frame;
+            }
+            continue;
+        }
+        if (victim == NULL || frame->history[last] < victim->history[last] ||
+            (frame->history[last] == victim->history[last] && frame->lastReference < victim->lastReference))
+        {
+            victim = frame;
+        }
+    }
+    return (victim != NULL) ? victim : correlated;
+}
+
+/**
+ * Method to record a pin of a page in the pool in its LRU-K history
+ */
+static void lrukHit(BM_BufferPool *const bm, BM_PageFrame *frame)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    noteReference(bpInfo, frame, ++bpInfo->clock);
+}
+
+/**
+ * Method to pick the LRU-K victim for the pin about to happen
+ */
+static BM_PageFrame *lrukPickVictim(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    return findLRUKVictim(bm, bpInfo, bpInfo->clock + 1);
+}
+
+/**
+ * Method to retain the history of an evicted page while the frame still has it
+ */
+static void lrukEvict(BM_BufferPool *const bm, BM_PageFrame *frame, PageNumber evicted)
+{
+    retainHistory(bm->mgmtData, frame, evicted);
+}
+
+/**
+ * Method to start the history of a page entering the pool
+ */
+static void lrukLoad(BM_BufferPool *const bm, BM_PageFrame *frame)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    loadHistory(bpInfo, frame, ++bpInfo->clock);
+}
+
+/**
+ * Method to set up ARC, which remembers as many evicted pages as the pool has frames
+ */
+static RC arcInit(BM_BufferPool *const bm, void *stratData, const BM_PoolOptions *options)
+{
+    initReplacementLists(bm->mgmtData, bm->numPages, bm->numPages);
+    return RC_OK;
+}
+
+/**
+ * Method to make a pinned page the most recently used frequent page
+ */
+static void arcHit(BM_BufferPool *const bm, BM_PageFrame *frame)
+{
+    listRemove(bm->mgmtData, frame->frameNumber);
+    listPush(bm->mgmtData, BM_LIST_FREQUENT, frame->frameNumber);
+}
+
+/**
+ * ARC: how a miss on a page adapts the lists, worked out by planArcMiss
+ */
+typedef struct BM_ArcMiss
+{
+    int ghost;         // ghost entry of the page, -1 if it is not remembered
+    int ghostList;     // ghost list holding it, -1 for none
+    int recentTarget;  // target size of the recent list after the miss
+    int forgetGhost;   // ghost entry trimmed off the tail of its list, -1 for none
+    bool forgetVictim; // the recent list fills the pool, its victim is not remembered
+} BM_ArcMiss;
+
+/**
+ * Method to work out how ARC adapts to a page that is not in the pool, without changing anything. A page found in a
+ * ghost list shows which list was too short and moves the target size of the recent list. Otherwise the ghost lists
+ * are trimmed, so pages seen once and their ghosts never outnumber the frames and all ghosts never outnumber them twice.
+ */
+static void planArcMiss(BM_BufferPool *const bm, PageNumber pageNum, BM_ArcMiss *miss)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    BM_List *lists = bpInfo->lists;
+    int recent = lists[BM_LIST_RECENT].length;
+
+    miss->ghost = findGhost(bpInfo, pageNum);
+    miss->ghostList = (miss->ghost >= 0) ? bpInfo->listEntries[miss->ghost].list : -1;
+    miss->recentTarget = bpInfo->recentTarget;
+    miss->forgetGhost = -1;
+    miss->forgetVictim = false;
+    if (miss->ghostList == BM_LIST_RECENT_GHOSTS) // the recent list was too short
+    {
+        int step = lists[BM_LIST_FREQUENT_GHOSTS].length / lists[BM_LIST_RECENT_GHOSTS].length;
+        miss->recentTarget += (step > 1) ? step : 1;
+        miss->recentTarget = (miss->recentTarget < bm->numPages) ? miss->recentTarget : bm->numPages;
+    }
+    else if (miss->ghostList == BM_LIST_FREQUENT_GHOSTS) // the frequent list was too short
+    {
+        int step = lists[BM_LIST_RECENT_GHOSTS].length / lists[BM_LIST_FREQUENT_GHOSTS].length;
+        miss->recentTarget -= (step > 1) ? step : 1;
+        miss->recentTarget = (miss->recentTarget > 0) ? miss->recentTarget : 0;
+    }
+    else if (recent + lists[BM_LIST_RECENT_GHOSTS].length >= bm->numPages) // pages seen once and their ghosts fill a pool
+    {
+        if (recent < bm->numPages && lists[BM_LIST_RECENT_GHOSTS].length > 0)
+        {
+            miss->forgetGhost = lists[BM_LIST_RECENT_GHOSTS].tail;
+        }
+        else
+        {
+            miss->forgetVictim = true;
+        }
+    }
+    else if (recent + lists[BM_LIST_FREQUENT].length + lists[BM_LIST_RECENT_GHOSTS].length + lists[BM_LIST_FREQUENT_GHOSTS].length >= 2 * bm->numPages &&
+             lists[BM_LIST_FREQUENT_GHOSTS].length > 0)
+    {
+        miss->forgetGhost = lists[BM_LIST_FREQUENT_GHOSTS].tail;
+    }
+}
+
+/**
+ * Method to adapt ARC to a page that is not in the pool once frame is taken for it, see planArcMiss. The page enters
+ * the frequent list when it was a ghost, and the page the frame held is remembered in the ghost list of its own list
+ * unless the recent list fills the pool.
+ */
+static void arcMiss(BM_BufferPool *const bm, BM_PageFrame *frame, PageNumber pageNum)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    BM_ArcMiss miss;
+    planArcMiss(bm, pageNum, &miss);
+    bool fromRecent = (bpInfo->listEntries[frame->frameNumber].list == BM_LIST_RECENT);
+    frame->entryList = (miss.ghostList >= 0) ? BM_LIST_FREQUENT : BM_LIST_RECENT;
+    frame->ghostList = (fromRecent && miss.forgetVictim) ? -1 : (fromRecent ? BM_LIST_RECENT_GHOSTS : BM_LIST_FREQUENT_GHOSTS);
+    bpInfo->recentTarget = miss.recentTarget;
+    if (miss.forgetGhost >= 0)
+    {
+        forgetPage(bpInfo, miss.forgetGhost);
+    }
+    if (miss.ghost >= 0)
+    {
+        forgetPage(bpInfo, miss.ghost);
+    }
+}
+
+/**
+ * Method to pick the ARC victim for a miss on pageNum, with the lists as the miss is about to adapt them. The recent
+ * list gives up its least recently used page while it is longer than its target, or as long as it when the requested
+ * page was found in the frequent ghosts. Otherwise the frequent list does. If every frame of the chosen list is
+ * pinned the other list is used.
+ */
+static BM_PageFrame *arcPickVictim(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    BM_ArcMiss miss;
+    planArcMiss(bm, pageNum, &miss);
+    int recent = bpInfo->lists[BM_LIST_RECENT].length;
+    bool fromRecent = miss.forgetVictim || (recent > 0 && (recent > miss.recentTarget ||
+                                                           (miss.ghostList == BM_LIST_FREQUENT_GHOSTS && recent == miss.recentTarget)));
+    BM_PageFrame *victim = listVictim(bpInfo, fromRecent ? BM_LIST_RECENT : BM_LIST_FREQUENT);
+    if (victim == NULL)
+    {
+        victim = listVictim(bpInfo, fromRecent ? BM_LIST_FREQUENT : BM_LIST_RECENT);
+    }
+    return victim;
+}
+
+/**
+ * Method to remember the page of an ARC or 2Q victim in the ghost list chosen on the miss that replaced it
+ */
+static void listsEvict(BM_BufferPool *const bm, BM_PageFrame *frame, PageNumber evicted)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    listRemove(bpInfo, frame->frameNumber);
+    if (frame->ghostList >= 0)
+    {
+        rememberPage(bpInfo, evicted, frame->ghostList);
+    }
+}
+
+/**
+ * Method to put a page entering the pool at the head of the list chosen on its miss, the recent list or, when it was
+ * remembered as a ghost, the frequent list
+ */
+static void listsLoad(BM_BufferPool *const bm, BM_PageFrame *frame)
+{
+    listPush(bm->mgmtData, frame->entryList, frame->frameNumber);
+}
+
+/**
+ * Method to set up 2Q with recentPages frames for the recent queue (Kin) and ghostPages remembered pages (Kout)
+ */
+static RC twoQInit(BM_BufferPool *const bm, void *stratData, const BM_PoolOptions *options)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    if (options != NULL && (options->recentPages < 0 || options->ghostPages < 0))
+    {
+        return RC_INVALID_PARAMETER;
+    }
+    initReplacementLists(bpInfo, bm->numPages, (options != NULL && options->ghostPages > 0) ? options->ghostPages : (bm->numPages + 1) / 2);
+    bpInfo->recentTarget = (options != NULL && options->recentPages > 0) ? options->recentPages : (bm->numPages + 3) / 4;
+    return RC_OK;
+}
+
+/**
+ * Method to make a pinned hot page the most recently used one. Hits in the recent queue do not promote the page,
+ * references right after loading it are often correlated.
+ */
+static void twoQHit(BM_BufferPool *const bm, BM_PageFrame *frame)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    if (bpInfo->listEntries[frame->frameNumber].list == BM_LIST_FREQUENT)
+    {
+        listRemove(bpInfo, frame->frameNumber);
+        listPush(bpInfo, BM_LIST_FREQUENT, frame->frameNumber);
+    }
+}
+
+/**
+ * Method to look a page that is not in the pool up in the ghost queue once frame is taken for it. Only a page found
+ * there enters the hot list. The page the frame held is remembered in the ghost queue if it leaves the recent queue
+ * and forgotten if it leaves the hot list.
+ */
+static void twoQMiss(BM_BufferPool *const bm, BM_PageFrame *frame, PageNumber pageNum)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    int ghost = findGhost(bpInfo, pageNum);
+    frame->entryList = (ghost >= 0) ? BM_LIST_FREQUENT : BM_LIST_RECENT;
+    frame->ghostList = (bpInfo->listEntries[frame->frameNumber].list == BM_LIST_RECENT) ? BM_LIST_RECENT_GHOSTS : -1;
+    if (ghost >= 0)
+    {
+        forgetPage(bpInfo, ghost);
+    }
+}
+
+/**
+ * Method to pick the 2Q victim. Once the recent queue holds more than recentTarget frames its oldest page leaves,
+ * otherwise the least recently used hot page does. The ghost queue is bounded by its entries, Kout of them, and
+ * rememberPage forgets its oldest ghost when all are in use.
+ */
+static BM_PageFrame *twoQPickVictim(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    BM_PageFrame *victim = NULL;
+    if (bpInfo->lists[BM_LIST_RECENT].length > bpInfo->recentTarget)
+    {
+        victim = listVictim(bpInfo, BM_LIST_RECENT);
+    }
+    if (victim == NULL)
+    {
+        victim = listVictim(bpInfo, BM_LIST_FREQUENT);
+    }
+    if (victim == NULL) // every hot page is pinned
+    {
+        victim = listVictim(bpInfo, BM_LIST_RECENT);
+    }
+    return victim;
+}
+
+static const BM_ReplacementPolicy fifoPolicy = {.strategy = RS_FIFO, .name = "FIFO", .pickVictim = fifoPickVictim};
+static const BM_ReplacementPolicy lruPolicy = {.strategy = RS_LRU, .name = "LRU", .init = lruInit, .shutdown = listsShutdown, .onHit = lruTouch,
+                                               .pickVictim = lruPickVictim, .onEvict = lruEvict, .onLoad = lruTouch};
+static const BM_ReplacementPolicy clockPolicy = {.strategy = RS_CLOCK, .name = "CLOCK", .onHit = clockReference, .pickVictim = clockPickVictim,
+                                                 .onLoad = clockReference};
+static const BM_ReplacementPolicy lfuPolicy = {.strategy = RS_LFU, .name = "LFU", .init = lfuInit, .shutdown = lfuShutdown, .onHit = lfuHit,
+                                               .pickVictim = lfuPickVictim, .onEvict = lfuEvict, .onLoad = lfuLoad};
+static const BM_ReplacementPolicy lrukPolicy = {.strategy = RS_LRU_K, .name = "LRU-K", .init = lrukInit, .shutdown = lrukShutdown, .onHit = lrukHit,
+                                                .pickVictim = lrukPickVictim, .onEvict = lrukEvict, .onLoad = lrukLoad};
+static const BM_ReplacementPolicy arcPolicy = {.strategy = RS_ARC, .name = "ARC", .init = arcInit, .shutdown = listsShutdown, .onHit = arcHit,
+                                               .onMiss = arcMiss, .pickVictim = arcPickVictim, .onEvict = listsEvict, .onLoad = listsLoad};
+static const BM_ReplacementPolicy twoQPolicy = {.strategy = RS_2Q, .name = "2Q", .init = twoQInit, .shutdown = listsShutdown, .onHit = twoQHit,
+                                                .onMiss = twoQMiss, .pickVictim = twoQPickVictim, .onEvict = listsEvict, .onLoad = listsLoad};
+
+static const BM_ReplacementPolicy *policies[BM_MAX_POLICIES] = {&fifoPolicy, &lruPolicy, &clockPolicy, &lfuPolicy, &lrukPolicy, &arcPolicy, &twoQPolicy};
+
+/**
+ * Method to make a replacement policy available to buffer pools. The strategy id must be unused.
+ */
+RC registerReplacementPolicy(const BM_ReplacementPolicy *policy)
+{
+    if (policy == NULL || policy->strategy < 0 || policy->strategy >= BM_MAX_POLICIES || policies[policy->strategy] != NULL ||
+        policy->pickVictim == NULL)
+    {
+        printError(RC_INVALID_PARAMETER);
+        return RC_INVALID_PARAMETER;
+    }
+    policies[policy->strategy] = policy;
+    return RC_OK;
+}
+
+/**
+ * Method to look up the replacement policy registered for a strategy. Returns NULL for unknown strategies.
+ */
+const BM_ReplacementPolicy *findReplacementPolicy(int strategy)
+{
+    if (strategy < 0 || strategy >= BM_MAX_POLICIES)
+    {
+        return NULL;
+    }
+    return policies[strategy];
+}
+
+/*Replacement Policy Functions - END*/
+
+/*Buffer Pool Functions - BEGIN*/
+
+/**
+ * Method to initialize buffermanager page frame
+ */
+static void initBMPageFrame(BM_PageFrame *page, int frameNumber, int numPages, int pageSize, bool mapped)
+{
+    page->data = mapped ? NULL : allocPageBuffer(1, pageSize); // aligned so a pool opened with SM_OPEN_DIRECT reads into frames directly, frames of a mapped pool point into the mapping
+    page->frameNumber = frameNumber;
+    page->pageNumber = -1;
+    page->fixCount = 0;
+    page->isDirty = false;
+    page->loading = false;
+    pthread_rwlock_init(&page->latch, NULL);
+    page->referenced = false;
+    page->timeStamp = 0;
+    page->history = NULL;
+    page->lastReference = 0;
+    page->bucket = NULL;
+    page->previousInBucket = NULL;
+    page->nextInBucket = NULL;
+    page->previousFrame = (frameNumber == 0) ? NULL : &page[-1];
+    page->nextFrame = (frameNumber == numPages - 1) ? NULL : &page[1];
+}
+
+/**
+ * Method to get partition i of a pool, a pool that is not partitioned is its own single partition
+ */
+static BM_BufferPool *partitionAt(BM_BufferPool *const bm, int i)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    return (bpInfo->partitions == NULL) ? bm : &bpInfo->partitions[i];
+}
+
+/**
+ * Method to count the partitions of a pool
+ */
+static int partitionCount(BM_BufferPool *const bm)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    return (bpInfo->partitions == NULL) ? 1 : bpInfo->numPartitions;
+}
+
+/**
+ * Method to find the partition page pageNum belongs to. The hash differs from the one of the page tables, so the pages
+ * of a partition still spread over all the slots of its table.
+ */
+static BM_BufferPool *partitionOf(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    if (bpInfo->partitions == NULL)
+    {
+        return bm;
+    }
+    unsigned int hash = (unsigned int)pageNum * 0x85EBCA6Bu;
+    return &bpInfo->partitions[((hash ^ (hash >> 13)) >> 8) % (unsigned int)bpInfo->numPartitions];
+}
+
+/**
+ * Method to free the frames and the bookkeeping set up by initFrames, without writing anything
+ */
+static void releaseFrames(BM_BufferPool *const bm)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    if (bpInfo->bufferPool == NULL) // its initFrames failed
+    {
+        return;
+    }
+    for (int i = 0; i < bm->numPages; i++)
+    {
+        BM_PageFrame *page = &(bpInfo->bufferPool[i]); // initializing page pointer to point to ith address of buffer pool
+        if (!bpInfo->mapped)                           // frames of a mapped pool do not own their data
+        {
+            free(bpInfo->bufferPool[i].data); // frees up dynamically allocated memory pointer to by the data of ith element of bufferpool
+        }
+        pthread_rwlock_destroy(&page->latch);
+        page->previousFrame = NULL;                    // sets previous frame to null
+        page->nextFrame = NULL;                        // sets next frame to null
+    }
+
+    free(bpInfo->bufferPool); // frees up the entire dynamically allocated memory for the bufferpool array
+    bpInfo->bufferPool = NULL;
+    freePageTable(&bpInfo->pageTable);
+    freePageTable(&bpInfo->incomingTable);
+    while (bpInfo->numSpare > 0)
+    {
+        free(bpInfo->spareData[--bpInfo->numSpare]);
+    }
+    free(bpInfo->spareData);
+    free(bpInfo->emptyFrames);
+    free(bpInfo->skippedFrames);
+    pthread_mutex_destroy(&bpInfo->tableLatch);
+    pthread_cond_destroy(&bpInfo->pageLoaded);
+}
+
+/**
+ * Method to set up the frames, the page table, the latches and the replacement policy of a pool or of a partition,
+ * io is the pool doing its I/O. On failure nothing is left allocated.
+ */
+static RC initFrames(BM_BufferPool *const bm, BM_PoolInfo *io, void *stratData, const BM_PoolOptions *options)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    int numPages = bm->numPages;
+    BM_PageFrame *bufferPool = (BM_PageFrame *)malloc(numPages * sizeof(BM_PageFrame)); // dynamically allocate memory to pageframe and returns pointer to allocated memory
+
+    for (int i = 0; i < numPages; i++) // iterates through the number of frames in bufferpool
+    {
+        initBMPageFrame(&bufferPool[i], i, numPages, bm->pageSize, io->mapped); // initializes buffer manager page frame
+    }
+    bufferPool[numPages - 1].nextFrame = &bufferPool[0];     // the frames form a ring the hand goes round
+    bufferPool[0].previousFrame = &bufferPool[numPages - 1];
+
+    bpInfo->bufferPool = bufferPool;          // sets bufferpool of bufferpoolinfo to the address of bufferpool
+    bpInfo->io = io;
+    bpInfo->mapped = io->mapped;
+    bpInfo->policy = findReplacementPolicy(bm->strategy);
+    bpInfo->hand = &bufferPool[0];            // frames are loaded in order starting at the first one
+    bpInfo->emptyFrames = (int *)malloc(numPages * sizeof(int));
+    bpInfo->numEmpty = 0;
+    bpInfo->skippedFrames = (int *)malloc(numPages * sizeof(int));
+    pthread_mutex_init(&bpInfo->tableLatch, NULL);
+    pthread_cond_init(&bpInfo->pageLoaded, NULL);
+    initPageTable(&bpInfo->pageTable, numPages);
+    initPageTable(&bpInfo->incomingTable, numPages);
+    bpInfo->spareData = (char **)malloc(numPages * sizeof(char *));
+    bpInfo->numSpare = 0;
+    bpInfo->framesCount = 0;                  // frame count is initialized to zero
+
+    RC rc = RC_OK;
+    if (bpInfo->policy->init != NULL && (rc = bpInfo->policy->init(bm, stratData, options)) != RC_OK)
+    {
+        releaseFrames(bm);
+    }
+    return rc;
+}
+
+/**
+ * Method to free the state the replacement policies of the partitions of a pool keep
+ */
+static void shutdownPolicies(BM_BufferPool *const bm)
+{
+    for (int i = 0; i < partitionCount(bm); i++)
+    {
+        BM_BufferPool *partition = partitionAt(bm, i);
+        BM_PoolInfo *bpInfo = partition->mgmtData;
+        if (bpInfo->bufferPool != NULL && bpInfo->policy->shutdown != NULL)
+        {
+            bpInfo->policy->shutdown(partition);
+        }
+    }
+}
+
+/**
+ * Method to free the partitions and the bookkeeping of a buffer pool and close its page file, without writing anything
+ */
+static RC releasePool(BM_BufferPool *const bm)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    for (int i = 0; i < partitionCount(bm); i++)
+    {
+        releaseFrames(partitionAt(bm, i));
+    }
+    if (bpInfo->partitions != NULL)
+    {
+        for (int i = 0; i < bpInfo->numPartitions; i++)
+        {
+            free(bpInfo->partitions[i].mgmtData);
+        }
+        free(bpInfo->partitions);
+    }
+    pthread_rwlock_destroy(&bpInfo->ioLatch);
+    pthread_cond_destroy(&bpInfo->ioDone);
+    pthread_mutex_destroy(&bpInfo->pollLatch);
+    pthread_mutex_destroy(&bpInfo->startLatch);
+    pthread_mutex_destroy(&bpInfo->flushLatch);
+
+    RC rc = closePageFile(&bpInfo->fileHandle); // closes the page file kept open by the buffer pool
+    free(bpInfo);
+    bm->mgmtData = NULL;
+    return rc;
+}
+
+/**
+ * Method to take the I/O latch of a pool for a storage manager call on its page file. Reads and writes of existing
+ * pages share it and run concurrently, growing the file takes it exclusively. So does every call on a compressed
+ * file, whose writes move pages in its page map.
+ */
+static void latchIO(BM_PoolInfo *io, bool exclusive)
+{
+    if (exclusive || io->compressed)
+    {
+        pthread_rwlock_wrlock(&io->ioLatch);
+    }
+    else
+    {
+        pthread_rwlock_rdlock(&io->ioLatch);
+    }
+}
+
+/**
+ * An asynchronous read or write of the pool, whichever thread polls the page file hands it its result
+ */
+typedef struct BM_PendingIO
+{
+    RC rc;     // error the request fails with until its completion sets it
+    bool done;
+} BM_PendingIO;
+
+#define BM_POLLED_COMPLETIONS 16 // completions taken from the page file by one poll of awaitIO
+
+/**
+ * Method to wait for an asynchronous read or write of the pool submitted with pending as its user data. The page file
+ * is polled by one thread at a time, which hands every completion it collects to the request it belongs to, so the
+ * loader and pins replacing dirty pages can have requests in flight together.
+ */
+static void awaitIO(BM_PoolInfo *io, BM_PendingIO *pending)
+{
+    SM_IOCompletion completions[BM_POLLED_COMPLETIONS];
+    pthread_mutex_lock(&io->pollLatch);
+    while (!pending->done)
+    {
+        if (io->polling)
+        {
+            pthread_cond_wait(&io->ioDone, &io->pollLatch);
+            continue;
+        }
+        io->polling = true;
+        pthread_mutex_unlock(&io->pollLatch);
+        int n = pollCompletions(&io->fileHandle, completions, BM_POLLED_COMPLETIONS, 1);
+        pthread_mutex_lock(&io->pollLatch);
+        for (int i = 0; i < n; i++)
+        {
+            BM_PendingIO *owner = completions[i].userData;
+            owner->rc = completions[i].rc;
+            owner->done = true;
+        }
+        pending->done |= (n == 0); // nothing is in flight, the request was lost and keeps its error
+        io->polling = false;
+        pthread_cond_broadcast(&io->ioDone);
+    }
+    pthread_mutex_unlock(&io->pollLatch);
+}
+
+/**
+ * Method to order page frames by their page number
+ */
+static int compareFramePageNumber(const void *a, const void *b)
+{
+    const BM_PageFrame *frameA = *(BM_PageFrame *const *)a;
+    const BM_PageFrame *frameB = *(BM_PageFrame *const *)b;
+    return (frameA->pageNumber > frameB->pageNumber) - (frameA->pageNumber < frameB->pageNumber);
+}
+
+/**
+ * Method to take up to limit dirty unpinned frames of a pool or partition for writing, starting at the hand so the
+ * next victims of FIFO and CLOCK come first. The frames are latched shared, so they are not replaced meanwhile, and
+ * marked clean, so a page marked dirty again while it is written stays dirty. A frame latched exclusively is left out.
+ * Called with the table latch held, returns the number of frames taken.
+ */
+static int takeDirtyFrames(BM_BufferPool *const bm, BM_PageFrame **frames, int limit)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    int start = bpInfo->hand->frameNumber;
+    int taken = 0;
+    for (int i = 0; i < bm->numPages && taken < limit; i++)
+    {
+        BM_PageFrame *page = &(bpInfo->bufferPool[(start + i) % bm->numPages]);
+        if (page->isDirty && !isPinned(page) && pthread_rwlock_tryrdlock(&page->latch) == 0) // if the page is marked as dirty and the pages are not pinnes i.e fix count is 0
+        {
+            page->isDirty = false;
+            frames[taken++] = page;
+        }
+    }
+    return taken;
+}
+
+/**
+ * Method to write the frames taken by takeDirtyFrames and release their latches. Dirty pages with adjacent page
+ * numbers are written together with one vectored write, whatever partitions hold them. After a failed write every
+ * page is dirty again.
+ */
+static RC writeFrames(BM_BufferPool *const bm, BM_PageFrame **frames, int numFrames)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    SM_PageHandle *runData = (SM_PageHandle *)malloc((numFrames + 1) * sizeof(SM_PageHandle)); // data of the run of adjacent pages being written
+    qsort(frames, numFrames, sizeof(BM_PageFrame *), compareFramePageNumber);
+
+    RC rc = RC_OK;
+    for (int start = 0; start < numFrames && rc == RC_OK;)
+    {
+        int end = start + 1; // extends the run while the page numbers are adjacent
+        while (end < numFrames && frames[end]->pageNumber == frames[end - 1]->pageNumber + 1)
+        {
+            end++;
+        }
+        for (int i = start; i < end; i++)
+        {
+            runData[i - start] = frames[i]->data;
+        }
+
+        latchIO(bpInfo, false);
+        rc = writeBlocks(frames[start]->pageNumber, end - start, &bpInfo->fileHandle, runData); // write the run to disk at its absolute position
+        pthread_rwlock_unlock(&bpInfo->ioLatch);
+        if (rc == RC_OK)
+        {
+            __atomic_add_fetch(&bpInfo->writeNumber, end - start, __ATOMIC_RELAXED); // increase the count of the writeNumber of buffer pool info to keep track of write operations to disk
+        }
+        start = end;
+    }
+
+    for (int p = 0; rc != RC_OK && p < partitionCount(bm); p++) // the next flush writes them all again
+    {
+        BM_BufferPool *partition = partitionAt(bm, p);
+        BM_PoolInfo *partInfo = partition->mgmtData;
+        pthread_mutex_lock(&partInfo->tableLatch);
+        for (int i = 0; i < numFrames; i++)
+        {
+            if (frames[i] >= partInfo->bufferPool && frames[i] < partInfo->bufferPool + partition->numPages)
+            {
+                frames[i]->isDirty = true;
+            }
+        }
+        pthread_mutex_unlock(&partInfo->tableLatch);
+    }
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        pthread_rwlock_unlock(&frames[i]->latch);
+    }
+    free(runData);
+    return rc; // returns the response of the last write
+}
 
 /**
- * Contains information about a buffer manager page frame
+ * Background writer of a pool. Each round it writes dirty unpinned pages ahead of their replacement, so pinPage
+ * finds clean victims and does not wait for a write back of its own.
  */
-typedef struct BM_PageFrame
+typedef struct BM_Writer
 {
-    char *data;
-    int frameNumber;
-    int pageNumber;
-    int fixCount;
-    bool isDirty;
-    int timeStamp;
-    struct BM_PageFrame *previousFrame;
-    struct BM_PageFrame *nextFrame;
-} BM_PageFrame;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wakeUp; // signalled when pinPage had to write back a victim, or when the writer has to stop
+    BM_BufferPool pool;    // the pool written, a copy of the handle it was opened with
+    int cleanPercent;
+    int intervalMs;
+    int maxPages;
+    int budget;                  // pages left to write in the current interval, -1 for no limit
+    struct timespec intervalEnd; // on the monotonic clock
+    int wakeRequested;
+    int stopping;
+} BM_Writer;
 
 /**
- * Contains bufferpool information
+ * Method to start a new interval of the background writer, with the full number of pages to write
  */
-typedef struct BM_PoolInfo
+static void startInterval(BM_Writer *writer)
 {
-    BM_PageFrame *bufferPool;
-    BM_PageFrame *head;
-    BM_PageFrame *tail;
-    BM_PageFrame *begin;
-    int readNumber;
-    int writeNumber;
-    int framesCount;
-} BM_PoolInfo;
+    clock_gettime(CLOCK_MONOTONIC, &writer->intervalEnd);
+    writer->intervalEnd.tv_sec += writer->intervalMs / 1000;
+    writer->intervalEnd.tv_nsec += (long)(writer->intervalMs % 1000) * 1000000L;
+    if (writer->intervalEnd.tv_nsec >= 1000000000L)
+    {
+        writer->intervalEnd.tv_sec++;
+        writer->intervalEnd.tv_nsec -= 1000000000L;
+    }
+    writer->budget = (writer->maxPages > 0) ? writer->maxPages : -1;
+}
 
-long globalTime = 0;
+/**
+ * Method to run a round of the background writer. In every partition it writes as many dirty unpinned pages as are
+ * needed to keep cleanPercent of the unpinned frames clean, within the pages left to it in the current interval.
+ */
+static void cleanPartitions(BM_Writer *writer, BM_PageFrame **frames)
+{
+    BM_BufferPool *bm = &writer->pool;
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    pthread_mutex_lock(&bpInfo->flushLatch);
+    for (int p = 0; p < partitionCount(bm) && writer->budget != 0; p++)
+    {
+        BM_BufferPool *partition = partitionAt(bm, p);
+        BM_PoolInfo *partInfo = partition->mgmtData;
+        int unpinned = 0; // frames a miss may take, empty ones included
+        int dirty = 0;
 
-/*Buffer Pool Functions - BEGIN*/
+        pthread_mutex_lock(&partInfo->tableLatch);
+        for (int i = 0; i < partition->numPages; i++)
+        {
+            BM_PageFrame *frame = &partInfo->bufferPool[i];
+            if (!isPinned(frame))
+            {
+                unpinned++;
+                dirty += frame->isDirty;
+            }
+        }
+        int missing = (unpinned * writer->cleanPercent + 99) / 100 - (unpinned - dirty); // clean frames short of the target
+        if (writer->budget > 0 && missing > writer->budget)
+        {
+            missing = writer->budget;
+        }
+        int taken = (missing > 0) ? takeDirtyFrames(partition, frames, missing) : 0;
+        pthread_mutex_unlock(&partInfo->tableLatch);
+
+        if (taken > 0)
+        {
+            if (writeFrames(bm, frames, taken) != RC_OK) // the pages stay dirty for a later round
+            {
+                LOG_WARN("Background writer of %s could not write %d pages", bm->pageFile, taken);
+            }
+            writer->budget -= (writer->budget > 0) ? taken : 0;
+        }
+    }
+    pthread_mutex_unlock(&bpInfo->flushLatch);
+}
 
 /**
- * Method to initialize buffermanager page frame
+ * Method run by the background writer thread. A round runs at the end of every interval and whenever pinPage wakes
+ * the writer, until the pool is shut down.
  */
-static void initBMPageFrame(BM_PageFrame *page, int frameNumber, int numPages)
+static void *writeDirtyPages(void *arg)
 {
-    page->data = (char *)malloc(PAGE_SIZE * sizeof(char));
-    page->frameNumber = frameNumber;
-    page->pageNumber = -1;
-    page->fixCount = 0;
-    page->isDirty = false;
-    page->timeStamp = 0;
-    page->previousFrame = (frameNumber == 0) ? NULL : &page[-1];
-    page->nextFrame = (frameNumber == numPages - 1) ? NULL : &page[1];
+    BM_Writer *writer = arg;
+    BM_PageFrame **frames = (BM_PageFrame **)malloc(writer->pool.numPages * sizeof(BM_PageFrame *));
+
+    pthread_mutex_lock(&writer->lock);
+    startInterval(writer);
+    while (!writer->stopping)
+    {
+        int timedOut = 0;
+        while (!writer->stopping && !writer->wakeRequested && !timedOut)
+        {
+            timedOut = pthread_cond_timedwait(&writer->wakeUp, &writer->lock, &writer->intervalEnd) != 0;
+        }
+        if (writer->stopping)
+        {
+            break;
+        }
+        writer->wakeRequested = 0;
+        if (timedOut)
+        {
+            startInterval(writer);
+        }
+        pthread_mutex_unlock(&writer->lock);
+        cleanPartitions(writer, frames);
+        pthread_mutex_lock(&writer->lock);
+    }
+    pthread_mutex_unlock(&writer->lock);
+
+    free(frames);
+    return NULL;
+}
+
+/**
+ * Method to start the background writer of a pool
+ */
+static RC startWriter(BM_BufferPool *const bm, const BM_PoolOptions *options)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    BM_Writer *writer = (BM_Writer *)calloc(1, sizeof(BM_Writer));
+    writer->pool = *bm;
+    writer->cleanPercent = options->cleanPercent;
+    writer->intervalMs = (options->writerIntervalMs > 0) ? options->writerIntervalMs : BM_WRITER_DEFAULT_INTERVAL_MS;
+    writer->maxPages = options->writerMaxPages;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC); // the interval must not follow changes of the wall clock
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->wakeUp, &attr);
+    pthread_condattr_destroy(&attr);
+
+    bpInfo->writer = writer;
+    if (pthread_create(&writer->thread, NULL, writeDirtyPages, writer) != 0)
+    {
+        pthread_cond_destroy(&writer->wakeUp);
+        pthread_mutex_destroy(&writer->lock);
+        free(writer);
+        bpInfo->writer = NULL;
+        return RC_WRITE_FAILED;
+    }
+    return RC_OK;
+}
+
+/**
+ * Method to stop the background writer of a pool, the pages it has not written yet stay dirty
+ */
+static void stopWriter(BM_PoolInfo *bpInfo)
+{
+    BM_Writer *writer = bpInfo->writer;
+    if (writer == NULL)
+    {
+        return;
+    }
+    pthread_mutex_lock(&writer->lock);
+    writer->stopping = 1;
+    pthread_cond_signal(&writer->wakeUp);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+
+    pthread_cond_destroy(&writer->wakeUp);
+    pthread_mutex_destroy(&writer->lock);
+    free(writer);
+    bpInfo->writer = NULL;
+}
+
+/**
+ * Method to wake the background writer of a pool, if it has one, ahead of its interval
+ */
+static void wakeWriter(BM_PoolInfo *bpInfo)
+{
+    BM_Writer *writer = bpInfo->writer;
+    if (writer == NULL)
+    {
+        return;
+    }
+    pthread_mutex_lock(&writer->lock);
+    writer->wakeRequested = 1;
+    pthread_cond_signal(&writer->wakeUp);
+    pthread_mutex_unlock(&writer->lock);
+}
+
+/**
+ * Background loader of a pool. It reads the pages queued by the read ahead of pinPage and by prefetchPages into free
+ * or clean frames and leaves them unpinned, so their pins find them in the pool.
+ */
+typedef struct BM_Prefetcher
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t queued; // signalled when pages are queued, or when the loader has to stop
+    BM_BufferPool pool;    // the pool loaded into, a copy of the handle it was opened with
+    PageNumber *queue;     // ring of the pages to load, pages queued while it is full are not loaded
+    int queueSize;
+    int batchSize;                // pages taken out of the queue together at most, half the frames so pins still find frames
+    PageNumber *batch;            // pages taken out of the queue together, the arrays up to completions hold batchSize entries
+    BM_PageFrame **frames;        // frames claimed for the pages of a batch
+    RC *results;                  // results of submitting their reads
+    BM_PendingIO *pending;        // results of the reads submitted
+    long head;                // pages taken out by the loader
+    long tail;                // pages queued
+    int maxWindow;            // 0 when the pool reads nothing ahead and only loads the pages of prefetchPages
+    int window;               // pages read ahead next time
+    PageNumber lastPage;      // page pinned last, NO_PAGE before the first pin
+    PageNumber readAheadMark; // a pin of the scan from this page on queues the next pages
+    PageNumber readAheadEnd;  // first page of the scan not queued yet
+    int stopping;
+} BM_Prefetcher;
+
+static void prefetchBatch(BM_Prefetcher *prefetcher, int numPages);
+
+/**
+ * Method run by the background loader thread, it loads the pages queued meanwhile in batches until the pool is shut down
+ */
+static void *loadQueuedPages(void *arg)
+{
+    BM_Prefetcher *prefetcher = arg;
+    pthread_mutex_lock(&prefetcher->lock);
+    while (!prefetcher->stopping)
+    {
+        if (prefetcher->head == prefetcher->tail)
+        {
+            pthread_cond_wait(&prefetcher->queued, &prefetcher->lock);
+            continue;
+        }
+        int numPages = 0;
+        while (prefetcher->head < prefetcher->tail && numPages < prefetcher->batchSize)
+        {
+            prefetcher->batch[numPages++] = prefetcher->queue[prefetcher->head++ % prefetcher->queueSize];
+        }
+        pthread_mutex_unlock(&prefetcher->lock);
+        prefetchBatch(prefetcher, numPages);
+        pthread_mutex_lock(&prefetcher->lock);
+    }
+    pthread_mutex_unlock(&prefetcher->lock);
+    return NULL;
+}
+
+/**
+ * Method to queue a page for the background loader, it is dropped when the queue is full. Called with its lock held.
+ */
+static void queuePage(BM_Prefetcher *prefetcher, PageNumber pageNum)
+{
+    if (prefetcher->tail - prefetcher->head < prefetcher->queueSize)
+    {
+        prefetcher->queue[prefetcher->tail++ % prefetcher->queueSize] = pageNum;
+    }
+}
+
+/**
+ * Method to release a background loader that is not running
+ */
+static void freePrefetcher(BM_Prefetcher *prefetcher)
+{
+    pthread_cond_destroy(&prefetcher->queued);
+    pthread_mutex_destroy(&prefetcher->lock);
+    free(prefetcher->queue);
+    free(prefetcher->batch);
+    free(prefetcher->frames);
+    free(prefetcher->results);
+    free(prefetcher->pending);
+    free(prefetcher);
+}
+
+/**
+ * Method to start the background loader of a pool. Up to two windows are read ahead of a scan, so the window is capped
+ * at a quarter of the frames and a scan does not replace the pages it read ahead before it gets to them.
+ */
+static RC startPrefetcher(BM_BufferPool *const bm, int readAheadPages)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    BM_Prefetcher *prefetcher = (BM_Prefetcher *)calloc(1, sizeof(BM_Prefetcher));
+    prefetcher->pool = *bm;
+    prefetcher->queueSize = 2 * bm->numPages;
+    prefetcher->queue = (PageNumber *)malloc(prefetcher->queueSize * sizeof(PageNumber));
+    prefetcher->batchSize = (bm->numPages > 1) ? bm->numPages / 2 : 1;
+    prefetcher->batch = (PageNumber *)malloc(prefetcher->batchSize * sizeof(PageNumber));
+    prefetcher->frames = (BM_PageFrame **)malloc(prefetcher->batchSize * sizeof(BM_PageFrame *));
+    prefetcher->results = (RC *)malloc(prefetcher->batchSize * sizeof(RC));
+    prefetcher->pending = (BM_PendingIO *)malloc(prefetcher->batchSize * sizeof(BM_PendingIO));
+    prefetcher->maxWindow = (readAheadPages < bm->numPages / 4) ? readAheadPages : bm->numPages / 4;
+    prefetcher->maxWindow = (prefetcher->maxWindow > 0 || readAheadPages == 0) ? prefetcher->maxWindow : 1;
+    prefetcher->window = (BM_READ_AHEAD_INITIAL_WINDOW < prefetcher->maxWindow) ? BM_READ_AHEAD_INITIAL_WINDOW : prefetcher->maxWindow;
+    prefetcher->lastPage = NO_PAGE;
+    pthread_mutex_init(&prefetcher->lock, NULL);
+    pthread_cond_init(&prefetcher->queued, NULL);
+
+    if (pthread_create(&prefetcher->thread, NULL, loadQueuedPages, prefetcher) != 0)
+    {
+        freePrefetcher(prefetcher);
+        return RC_WRITE_FAILED;
+    }
+    __atomic_store_n(&bpInfo->prefetcher, prefetcher, __ATOMIC_RELEASE); // pinPage looks for it without a latch
+    return RC_OK;
+}
+
+/**
+ * Method to stop the background loader of a pool, the pages still queued are not loaded
+ */
+static void stopPrefetcher(BM_PoolInfo *bpInfo)
+{
+    BM_Prefetcher *prefetcher = bpInfo->prefetcher;
+    if (prefetcher == NULL)
+    {
+        return;
+    }
+    pthread_mutex_lock(&prefetcher->lock);
+    prefetcher->stopping = 1;
+    pthread_cond_signal(&prefetcher->queued);
+    pthread_mutex_unlock(&prefetcher->lock);
+    pthread_join(prefetcher->thread, NULL);
+    freePrefetcher(prefetcher);
+    bpInfo->prefetcher = NULL;
+}
+
+/**
+ * Method to follow the pins of a pool for sequential scans. Once a page is pinned right after the one before it, the
+ * next window pages are queued for the background loader, and the window after them when the scan reaches the first
+ * of them. The window doubles with each batch while the scan goes on, and halves when a pin leaves the scan or misses
+ * on a page read ahead, which was then replaced or not loaded in time.
+ */
+static void readAhead(BM_BufferPool *const bm, const PageNumber pageNum, bool missed)
+{
+    BM_Prefetcher *prefetcher = __atomic_load_n(&((BM_PoolInfo *)bm->mgmtData)->prefetcher, __ATOMIC_ACQUIRE);
+    if (prefetcher == NULL || prefetcher->maxWindow == 0)
+    {
+        return;
+    }
+    pthread_mutex_lock(&prefetcher->lock);
+    if (pageNum == prefetcher->lastPage) // pinning a page again, like inserts into the last page, does not end a scan
+    {
+        pthread_mutex_unlock(&prefetcher->lock);
+        return;
+    }
+    bool sequential = (prefetcher->lastPage != NO_PAGE && pageNum == prefetcher->lastPage + 1);
+    if ((!sequential && prefetcher->lastPage != NO_PAGE) || (missed && pageNum < prefetcher->readAheadEnd))
+    {
+        prefetcher->window = (prefetcher->window > 1) ? prefetcher->window / 2 : 1;
+    }
+    if (!sequential) // the next pin may start a scan
+    {
+        prefetcher->readAheadMark = pageNum + 1;
+        prefetcher->readAheadEnd = pageNum + 1;
+    }
+    else if (pageNum >= prefetcher->readAheadMark)
+    {
+        PageNumber start = (prefetcher->readAheadEnd > pageNum) ? prefetcher->readAheadEnd : pageNum + 1;
+        for (PageNumber next = start; next < start + prefetcher->window; next++)
+        {
+            queuePage(prefetcher, next);
+        }
+        pthread_cond_signal(&prefetcher->queued);
+        prefetcher->readAheadMark = start; // the next batch is queued when the scan gets to this one
+        prefetcher->readAheadEnd = start + prefetcher->window;
+        prefetcher->window = (2 * prefetcher->window < prefetcher->maxWindow) ? 2 * prefetcher->window : prefetcher->maxWindow;
+    }
+    prefetcher->lastPage = pageNum;
+    pthread_mutex_unlock(&prefetcher->lock);
 }
 
 /**
@@ -59,33 +1785,105 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
                   const int numPages, ReplacementStrategy strategy,
                   void *stratData)
 {
-    bm->pageFile = (char *)pageFileName;                              // sets page file name to buffer pool
-    bm->numPages = numPages;                                          // sets number of frames to the buffer pool
-    bm->strategy = strategy;                                          // sets the strategy used to the buffer pool
-    BM_PoolInfo *bpInfo = (BM_PoolInfo *)malloc(sizeof(BM_PoolInfo)); // dynamically allocate memory to bufferpoolinfo and returns pointer to allocated memory
-
-    BM_PageFrame *bufferPool = (BM_PageFrame *)malloc(numPages * sizeof(BM_PageFrame)); // dynamically allocate memory to pageframe and returns pointer to allocated memory
+    return initBufferPoolWithOptions(bm, pageFileName, numPages, strategy, stratData, NULL);
+}
 
-    for (int i = 0; i < numPages; i++) // iterates through the number of frames in bufferpool
+/**
+ * Method to create a new buffer pool like initBufferPool with the optional settings given, options may be NULL.
+ * stratData is handed to the init hook of the replacement policy of the strategy. A pool with options->partitions
+ * above 1 splits its frames into that many partitions, each with its own page table, replacement state and table
+ * latch, and sends every page to the partition its page number hashes to. The partitions share the page file.
+ */
+RC initBufferPoolWithOptions(BM_BufferPool *const bm, const char *const pageFileName,
+                             const int numPages, ReplacementStrategy strategy,
+                             void *stratData, const BM_PoolOptions *options)
+{
+    int openFlags = (options != NULL) ? options->openFlags : 0;
+    int partitions = (options != NULL && options->partitions > 1) ? options->partitions : 0;
+    int cleanPercent = (options != NULL) ? options->cleanPercent : 0;
+    int readAheadPages = (options != NULL) ? options->readAheadPages : 0;
+    if (findReplacementPolicy(strategy) == NULL || numPages < 1 || numPages < partitions || cleanPercent < 0 || cleanPercent > 100 ||
+        readAheadPages < 0)
     {
-        initBMPageFrame(&bufferPool[i], i, numPages); // initializes buffer manager page frame
+        bm->mgmtData = NULL;
+        return RC_INVALID_PARAMETER;
+    }
+    bm->pageFile = (char *)pageFileName;                                 // sets page file name to buffer pool
+    bm->numPages = numPages;                                             // sets number of frames to the buffer pool
+    bm->strategy = strategy;                                             // sets the strategy used to the buffer pool
+    BM_PoolInfo *bpInfo = (BM_PoolInfo *)calloc(1, sizeof(BM_PoolInfo)); // state of policies not in use stays zeroed
+
+    // the page file stays open for the lifetime of the buffer pool
+    RC rc = openPageFileWithFlags(bm->pageFile, &bpInfo->fileHandle, openFlags);
+    if (rc == RC_OK && options != NULL && options->syncPolicy.mode != SM_SYNC_NONE)
+    {
+        rc = setSyncPolicy(&bpInfo->fileHandle, &options->syncPolicy);
+        if (rc != RC_OK)
+        {
+            closePageFile(&bpInfo->fileHandle);
+        }
+    }
+    if (rc != RC_OK)
+    {
+        free(bpInfo);
+        bm->mgmtData = NULL;
+        return rc;
     }
 
-    bpInfo->head = &bufferPool[0];              // setting head of buffer pool info to the address of the first element of the pageframe array
-    bpInfo->tail = &bufferPool[numPages - 1];   // setting tail of buffer pool info to the address of the last element of the pageframe array
-    bpInfo->begin = &bufferPool[0];             // setting begin of buffer pool info to the address of the first element of the pageframe array
-    bpInfo->tail->nextFrame = bpInfo->head;     // sets nextframe member of tail to the value head of buffer pool info
-    bpInfo->head->previousFrame = bpInfo->tail; // sets previous frame member of head to the value tail of buffer pool info
-
-    bpInfo->bufferPool = bufferPool;          // sets bufferpool of bufferpoolinfo to the address of bufferpool
-    bpInfo->head = &bufferPool[0];            // setting head of buffer pool info to the address of the first element of the pageframe array
-    bpInfo->tail = &bufferPool[numPages - 1]; // setting tail of buffer pool info to the address of the last element of the pageframe array
+    bm->pageSize = bpInfo->fileHandle.pageSize; // frames are sized to the pages of the file
+    bpInfo->io = bpInfo;
+    pthread_rwlock_init(&bpInfo->ioLatch, NULL);
+    pthread_mutex_init(&bpInfo->pollLatch, NULL);
+    pthread_cond_init(&bpInfo->ioDone, NULL);
+    pthread_mutex_init(&bpInfo->startLatch, NULL);
+    pthread_mutex_init(&bpInfo->flushLatch, NULL);
     bpInfo->readNumber = 0;                   // number of pages read from the disk is initialized to zero
     bpInfo->writeNumber = 0;                  // number of pages written to the disk is initialized to zero
-    bpInfo->framesCount = 0;                  // frame count is initialized to zero
-
+    bpInfo->mapped = (openFlags & SM_OPEN_MAPPED) != 0;
+    bpInfo->compressed = ((SM_FileInfo *)bpInfo->fileHandle.mgmtInfo)->codec != NULL;
     bm->mgmtData = bpInfo; // buffer pool info is assigned to mgmt data for bookkeeping
-    globalTime = 0;        // initialize global time to 0
+
+    if (partitions == 0)
+    {
+        rc = initFrames(bm, bpInfo, stratData, options);
+    }
+    else
+    {
+        bpInfo->partitions = (BM_BufferPool *)calloc(partitions, sizeof(BM_BufferPool));
+        for (int i = 0; i < partitions && rc == RC_OK; i++)
+        {
+            BM_BufferPool *partition = &bpInfo->partitions[i];
+            partition->pageFile = bm->pageFile;
+            partition->numPages = numPages / partitions + (i < numPages % partitions); // the frames left over go to the first partitions
+            partition->strategy = strategy;
+            partition->pageSize = bm->pageSize;
+            partition->mgmtData = calloc(1, sizeof(BM_PoolInfo));
+            rc = initFrames(partition, bpInfo, stratData, options);
+            if (rc != RC_OK)
+            {
+                free(partition->mgmtData);
+                break;
+            }
+            bpInfo->numPartitions++;
+        }
+    }
+    if (rc == RC_OK && cleanPercent > 0)
+    {
+        rc = startWriter(bm, options);
+    }
+    if (rc == RC_OK && readAheadPages > 0)
+    {
+        rc = startPrefetcher(bm, readAheadPages);
+    }
+    if (rc != RC_OK)
+    {
+        stopWriter(bpInfo);
+        shutdownPolicies(bm);
+        releasePool(bm);
+        return rc;
+    }
+    LOG_INFO("Buffer pool of %d frames in %d partitions opened on %s with %s replacement", numPages, partitionCount(bm),
+             bm->pageFile, findReplacementPolicy(strategy)->name);
     return RC_OK;          // returns successful response
 }
 
@@ -95,393 +1893,686 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
 RC shutdownBufferPool(BM_BufferPool *const bm)
 {
     RC rc;
+    if (bm == NULL || bm->mgmtData == NULL) // the pool is not open
+    {
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
     // initializing the pointer variable buffPoolInfo to point to the memory location of mgmtData of bm.
     BM_PoolInfo *bpInfo = bm->mgmtData;
     // Force flush all dirty pages to disk
     rc = forceFlushPool(bm);
-    // if the response is not successful return the error code
+    // if the response is not successful return the error code, the pool stays open with its background threads
     if (rc != RC_OK)
     {
-        return rc;
+        return rc;
+    }
+    stopPrefetcher(bpInfo); // the threads only read pages and write dirty ones, nothing is left dirty by them
+    stopWriter(bpInfo);
+
+    shutdownPolicies(bm);
+    LOG_INFO("Buffer pool on %s closed after %d reads and %d writes", bm->pageFile, bpInfo->readNumber, bpInfo->writeNumber);
+    return releasePool(bm); // returns the response of closing the page file
+}
+
+/**
+ * Method causes all dirty pages (with fix count 0) from the buffer pool to be written to disk.
+ * Dirty pages with adjacent page numbers are written together with one vectored write, whatever partitions hold them.
+ * The frames are latched shared while they are written, so they are not replaced meanwhile, and a frame latched
+ * exclusively is left for a later flush.
+ */
+RC forceFlushPool(BM_BufferPool *const bm)
+{
+    RC rc;
+    if (bm == NULL || bm->mgmtData == NULL) // the pool is not open
+    {
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    // initializing the pointer variable buffPoolInfo to point to the memory location of mgmtData of bm.
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+
+    BM_PageFrame **dirtyFrames = (BM_PageFrame **)malloc(bm->numPages * sizeof(BM_PageFrame *)); // frames to write, sorted by page number
+    int numDirty = 0;
+
+    pthread_mutex_lock(&bpInfo->flushLatch);
+    for (int p = 0; p < partitionCount(bm); p++)
+    {
+        BM_BufferPool *partition = partitionAt(bm, p);
+        BM_PoolInfo *partInfo = partition->mgmtData;
+        pthread_mutex_lock(&partInfo->tableLatch);
+        numDirty += takeDirtyFrames(partition, dirtyFrames + numDirty, partition->numPages);
+        pthread_mutex_unlock(&partInfo->tableLatch);
+    }
+    rc = writeFrames(bm, dirtyFrames, numDirty);
+    pthread_mutex_unlock(&bpInfo->flushLatch);
+
+    free(dirtyFrames);
+    return rc; // returns the response of the last write
+}
+
+/*Buffer Pool Functions - END*/
+
+/*Page Management Functions - BEGIN*/
+
+/**
+ * Method to write back the dirty page of a frame that is about to be replaced and read page pageNum into spare
+ * meanwhile. The write and the read are submitted together to the asynchronous engine of the page file and waited for
+ * together, the read only if the page is in the file already. The frame keeps its page until the write is done, so a
+ * failed write loses nothing. A mapped pool has no spare and writes the page in place through the mapping. Returns the
+ * result of the write, read tells whether spare holds the page.
+ */
+static RC writeBackFrame(BM_PoolInfo *bpInfo, BM_PageFrame *frame, const PageNumber pageNum, char *spare, bool *read)
+{
+    SM_FileHandle *fh = &bpInfo->fileHandle;
+    BM_PendingIO written = {RC_WRITE_FAILED, false};
+    BM_PendingIO readIn = {RC_READ_NON_EXISTING_PAGE, false};
+    latchIO(bpInfo, false);
+    bool submitted = (spare != NULL && submitWriteBlock(frame->pageNumber, fh, frame->data, &written) == RC_OK);
+    bool overlapped = (submitted && pageNum < fh->totalNumPages && submitReadBlock(pageNum, fh, spare, &readIn) == RC_OK);
+    RC rc = submitted ? RC_OK : writeBlock(frame->pageNumber, fh, frame->data);
+    pthread_rwlock_unlock(&bpInfo->ioLatch);
+    if (submitted)
+    {
+        awaitIO(bpInfo, &written);
+        rc = written.rc;
+    }
+    if (overlapped)
+    {
+        awaitIO(bpInfo, &readIn);
+    }
+    *read = (overlapped && readIn.rc == RC_OK);
+    if (rc == RC_OK)
+    {
+        __atomic_add_fetch(&bpInfo->writeNumber, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&bpInfo->dirtyVictims, 1, __ATOMIC_RELAXED);
+    }
+    return rc;
+}
+
+/**
+ * Method to load page pageNum into a frame, a page behind the end of the file grows it first. Frames of a mapped pool
+ * take the page straight from the mapping.
+ */
+static RC readPageIntoFrame(BM_PoolInfo *bpInfo, BM_PageFrame *frame, const PageNumber pageNum)
+{
+    SM_FileHandle *fh = &bpInfo->fileHandle;
+    latchIO(bpInfo, false);
+    if (pageNum >= fh->totalNumPages) // taken again exclusively to grow the file
+    {
+        pthread_rwlock_unlock(&bpInfo->ioLatch);
+        latchIO(bpInfo, true);
+    }
+    RC rc = ensureCapacity((pageNum + 1), fh);
+    if (rc == RC_OK)
+    {
+        rc = bpInfo->mapped ? mapBlock(pageNum, fh, &frame->data) : readBlock(pageNum, fh, frame->data);
+    }
+    pthread_rwlock_unlock(&bpInfo->ioLatch);
+    return rc;
+}
+
+/**
+ * Method to give up a pin of a frame whose page could not be read, the last one returns the frame to the empty frames.
+ * Called with the table latch held.
+ */
+static void dropFailedPin(BM_PoolInfo *bpInfo, BM_PageFrame *frame)
+{
+    if (__atomic_sub_fetch(&frame->fixCount, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        bpInfo->emptyFrames[bpInfo->numEmpty++] = frame->frameNumber;
+    }
+}
+
+/**
+ * Method to ask the policy for a frame to replace and latch it exclusively. A frame latched by someone else, like a
+ * flush writing it, is pinned for the time of the search so the policy names its next choice instead, and so is a
+ * dirty frame when only a clean one will do. Called with the table latch held, returns NULL if no frame is left.
+ */
+static BM_PageFrame *pickUnlatchedVictim(BM_BufferPool *const bm, const PageNumber pageNum, bool cleanOnly)
+{
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    BM_PageFrame *frame;
+    int numSkipped = 0;
+    while ((frame = bpInfo->policy->pickVictim(bm, pageNum)) != NULL &&
+           ((cleanOnly && frame->isDirty) || pthread_rwlock_trywrlock(&frame->latch) != 0))
+    {
+        __atomic_add_fetch(&frame->fixCount, 1, __ATOMIC_ACQ_REL);
+        bpInfo->skippedFrames[numSkipped++] = frame->frameNumber;
+    }
+    while (numSkipped > 0)
+    {
+        __atomic_sub_fetch(&bpInfo->bufferPool[bpInfo->skippedFrames[--numSkipped]].fixCount, 1, __ATOMIC_ACQ_REL);
+    }
+    return frame;
+}
+
+/**
+ * Method to take a spare page buffer of a partition for a page read next to a write back, called with the table latch
+ * held. A partition keeps the buffers it swapped out of its frames, at most one per frame.
+ */
+static char *takeSpareData(BM_BufferPool *const partition)
+{
+    BM_PoolInfo *bpInfo = partition->mgmtData;
+    if (bpInfo->mapped)
+    {
+        return NULL;
+    }
+    return (bpInfo->numSpare > 0) ? bpInfo->spareData[--bpInfo->numSpare] : allocPageBuffer(1, partition->pageSize);
+}
+
+/**
+ * Method to take a frame of a partition for page pageNum, which it does not hold. The page goes into a frame never
+ * used, then into a frame left empty by a failed read, and only then into the frame the replacement policy picks. A
+ * dirty victim is written back after the table latch is left, so pins of other pages go on meanwhile, and the page is
+ * read into a spare buffer at the same time. The victim stays latched and in the page table until its write is done,
+ * and the page stays in incomingTable, so misses on it wait instead of reading it too. Once the write succeeded and
+ * the victim is still unpinned and clean, its data and the spare buffer change places. One pinned or dirtied again
+ * during its write back stays while another one is picked. The hooks of the policy but pickVictim are called once the
+ * frame is taken, so a failed write back leaves no trace in the policy. A page read ahead only takes a free or clean
+ * frame. Called with the table latch held, which is held again on return. Returns the frame in claimed, latched
+ * exclusively, pinned and loading, and read tells whether the page was read into it already.
+ */
+static RC claimFrame(BM_BufferPool *const partition, const PageNumber pageNum, bool readAhead, BM_PageFrame **claimed, bool *read)
+{
+    BM_PoolInfo *bpInfo = partition->mgmtData;
+    BM_PoolInfo *io = bpInfo->io;
+    const BM_ReplacementPolicy *policy = bpInfo->policy;
+    BM_PageFrame *frame;
+
+    *claimed = NULL;
+    *read = false;
+    for (;;)
+    {
+        if (bpInfo->framesCount < partition->numPages) // empty frames are filled first, in order
+        {
+            frame = &bpInfo->bufferPool[bpInfo->framesCount++];
+            pthread_rwlock_trywrlock(&frame->latch); // only frames holding a page are latched by others, so this never fails
+            break;
+        }
+        if (bpInfo->numEmpty > 0)
+        {
+            frame = &bpInfo->bufferPool[bpInfo->emptyFrames[--bpInfo->numEmpty]];
+            pthread_rwlock_trywrlock(&frame->latch);
+            break;
+        }
+        frame = pickUnlatchedVictim(partition, pageNum, readAhead);
+        if (frame == NULL)
+        {
+            if (!readAhead)
+            {
+                LOG_WARN("No frame for page %d, all %d frames of its partition are pinned", pageNum, partition->numPages);
+            }
+            return RC_WRITE_FAILED;
+        }
+        if (!frame->isDirty)
+        {
+            break;
+        }
+
+        frame->isDirty = false; // reset before the write, a page marked dirty again meanwhile stays dirty
+        char *spare = takeSpareData(partition);
+        pageTableInsert(&bpInfo->incomingTable, pageNum, frame->frameNumber);
+        pthread_mutex_unlock(&bpInfo->tableLatch);
+        RC rc = writeBackFrame(io, frame, pageNum, spare, read);
+        if (rc == RC_OK) // the background writer fell behind
+        {
+            wakeWriter(io);
+        }
+        pthread_mutex_lock(&bpInfo->tableLatch);
+        pageTableRemove(&bpInfo->incomingTable, pageNum);
+        pthread_cond_broadcast(&bpInfo->pageLoaded); // misses waiting for the page find it in the frame or read it
+        bool replaced = (rc == RC_OK && !isPinned(frame) && !frame->isDirty);
+        if (replaced && *read)
+        {
+            char *written = frame->data;
+            frame->data = spare;
+            spare = written;
+        }
+        if (spare != NULL)
+        {
+            bpInfo->spareData[bpInfo->numSpare++] = spare;
+        }
+        if (rc != RC_OK) // the dirty page stays
+        {
+            frame->isDirty = true;
+            pthread_rwlock_unlock(&frame->latch);
+            return RC_WRITE_FAILED;
+        }
+        if (replaced)
+        {
+            break;
+        }
+        *read = false;
+        pthread_rwlock_unlock(&frame->latch); // pinned or dirtied during its write back, the victim stays
+    }
+    if (policy->onMiss != NULL) // the frame is taken, nothing fails from here on
+    {
+        policy->onMiss(partition, frame, pageNum);
     }
-
-    // Clear the data, previousFrame and nextFrame pointers in the page frame list
-    for (int i = 0; i < bm->numPages; i++)
+    if (frame->pageNumber != NO_PAGE)
     {
-        BM_PageFrame *page = &(bpInfo->bufferPool[i]); // initializing page pointer to point to ith address of buffer pool
-        free(bpInfo->bufferPool[i].data);              // frees up dynamically allocated memory pointer to by the data of ith element of bufferpool
-        page->previousFrame = NULL;                    // sets previous frame to null
-        page->nextFrame = NULL;                        // sets next frame to null
+        LOG_DEBUG("%s replaces page %d in frame %d with page %d", policy->name, frame->pageNumber, frame->frameNumber, pageNum);
     }
 
-    free(bpInfo->bufferPool); // frees up the entire dynamically allocated memory for the bufferpool array
-    return RC_OK;             // returns successful response
+    PageNumber evicted = frame->pageNumber;
+    assignFrame(bpInfo, frame, pageNum);
+    __atomic_store_n(&frame->fixCount, 1, __ATOMIC_RELEASE);
+    frame->loading = true;
+    if (evicted != NO_PAGE && policy->onEvict != NULL)
+    {
+        policy->onEvict(partition, frame, evicted);
+    }
+    *claimed = frame;
+    return RC_OK;
 }
+
 /**
- * Method causes all dirty pages (with fix count 0) from the buffer pool to be written to disk.
+ * Method to end the load of a frame taken by claimFrame, rc is the result of reading its page. A page that could not
+ * be read leaves the frame empty, a page read ahead waits for its pin unpinned. Called without the table latch.
  */
-RC forceFlushPool(BM_BufferPool *const bm)
+static void finishLoad(BM_BufferPool *const partition, BM_PageFrame *frame, const PageNumber pageNum, bool readAhead, RC rc)
 {
-    SM_FileHandle fHandle;
-    RC rc;
-    // initializing the pointer variable buffPoolInfo to point to the memory location of mgmtData of bm.
-    BM_PoolInfo *bpInfo = bm->mgmtData;
-    // Opens an existing page file, else returns error if file not found
-    rc = openPageFile(bm->pageFile, &fHandle);
-    // if the return code is not successfull, returns the error code
-    if (rc != RC_OK)
+    BM_PoolInfo *bpInfo = partition->mgmtData;
+    const BM_ReplacementPolicy *policy = bpInfo->policy;
+    if (rc == RC_OK)
     {
-        return rc;
+        __atomic_add_fetch(&bpInfo->io->readNumber, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&bpInfo->io->prefetchNumber, readAhead, __ATOMIC_RELAXED);
     }
+    pthread_rwlock_unlock(&frame->latch); // the frame stays pinned and loading until the table latch is taken again
 
-    for (int i = 0; i < bm->numPages; i++) // iterates through the number of frames in buffer pool
+    pthread_mutex_lock(&bpInfo->tableLatch);
+    frame->loading = false;
+    if (rc != RC_OK) // the frame is left empty
     {
-        BM_PageFrame *page = &(bpInfo->bufferPool[i]); // initializing page pointer to point to ith address of buffer pool
-        if (page->isDirty && page->fixCount == 0)      // if the page is marked as dirty and the pages are not pinnes i.e fix count is 0
+        pageTableRemove(&bpInfo->pageTable, pageNum);
+        frame->pageNumber = NO_PAGE;
+        dropFailedPin(bpInfo, frame);
+    }
+    else
+    {
+        if (policy->onLoad != NULL)
         {
-            rc = writeBlock(page->pageNumber, &fHandle, page->data); // write a page to disk at an absolute position
-            // if the response is unsuccessful, close the page file and return error code
-            if (rc != RC_OK)
+            policy->onLoad(partition, frame);
+        }
+        if (readAhead)
+        {
+            __atomic_sub_fetch(&frame->fixCount, 1, __ATOMIC_ACQ_REL);
+            if (policy->onUnpin != NULL)
             {
-                closePageFile(&fHandle);
-                return rc;
+                policy->onUnpin(partition, frame);
             }
-
-            page->isDirty = false; // resets isDirty to false
-
-            bpInfo->writeNumber++; // increase the count of the writeNumber of buffer pool info to keep track of write operations to disk
         }
     }
+    pthread_cond_broadcast(&bpInfo->pageLoaded);
+    pthread_mutex_unlock(&bpInfo->tableLatch);
+}
 
-    rc = closePageFile(&fHandle); // closes the file
+/**
+ * Method to read page pageNum into a frame of a partition that does not hold it, see claimFrame. Unless it was read
+ * next to the write back of a victim, the page is read after the table latch is left. Called with the table latch
+ * held, which it leaves, returns the frame in loaded.
+ */
+static RC loadPage(BM_BufferPool *const partition, const PageNumber pageNum, BM_PageFrame **loaded)
+{
+    BM_PoolInfo *bpInfo = partition->mgmtData;
+    bool read;
+    RC rc = claimFrame(partition, pageNum, false, loaded, &read);
+    pthread_mutex_unlock(&bpInfo->tableLatch);
     if (rc != RC_OK)
     {
-        return rc; // returns error code in case of unsuccessful response
+        return rc;
     }
 
-    return RC_OK; // returns successful response
+    if (!read)
+    {
+        rc = readPageIntoFrame(bpInfo->io, *loaded, pageNum);
+    }
+    finishLoad(partition, *loaded, pageNum, false, rc);
+    return (rc == RC_OK) ? RC_OK : RC_READ_NON_EXISTING_PAGE;
 }
 
-/*Buffer Pool Functions - END*/
-
-/*Page Management Functions - BEGIN*/
-
-RC FIFO(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+/**
+ * Method to read a batch of pages taken from the queue of the background loader into the pool ahead of their pins.
+ * A frame is claimed for each page in the page file and not in the pool yet, then the reads of all of them are
+ * submitted together to the asynchronous engine of the page file, and each frame is released as its read completes.
+ * A page that gets no frame, or is read next to the write back of a victim already, is read by its pin.
+ */
+static void prefetchBatch(BM_Prefetcher *prefetcher, int numPages)
 {
-    SM_FileHandle fh;
-    openPageFile((char *)bm->pageFile, &fh);
-
-    BM_PoolInfo *bpInfo = bm->mgmtData;
-    BM_PageFrame *q = bpInfo->head;
-
-    while (q != bpInfo->head)
+    BM_BufferPool *const bm = &prefetcher->pool;
+    BM_PoolInfo *io = ((BM_PoolInfo *)bm->mgmtData)->io;
+    SM_FileHandle *fh = &io->fileHandle;
+    latchIO(io, false);
+    int totalNumPages = fh->totalNumPages; // reading ahead never extends the page file
+    pthread_rwlock_unlock(&io->ioLatch);
+
+    int claimed = 0;
+    for (int i = 0; i < numPages; i++)
     {
-        if (q->pageNumber == pageNum)
+        PageNumber pageNum = prefetcher->batch[i];
+        BM_BufferPool *const partition = partitionOf(bm, pageNum);
+        BM_PoolInfo *bpInfo = partition->mgmtData;
+        BM_PageFrame *frame;
+        bool read;
+        if (pageNum >= totalNumPages)
         {
-            page->pageNum = pageNum;
-            page->data = q->data;
-
-            q->fixCount++;
-            // closePageFile(&fh);
-            return RC_OK;
+            continue;
         }
-        q = q->nextFrame;
-    }
-
-    if (bpInfo->framesCount >= bm->numPages)
-    {
-        q = bpInfo->tail;
-        while (q != bpInfo->head)
+        pthread_mutex_lock(&bpInfo->tableLatch);
+        if (lookupFrame(bpInfo, pageNum) == NULL && !isIncoming(bpInfo, pageNum) && claimFrame(partition, pageNum, true, &frame, &read) == RC_OK)
         {
-            if (q->fixCount == 0)
-            {
-                if (q->isDirty)
-                {
-                    ensureCapacity(q->pageNumber, &fh);
-                    if (writeBlock(q->pageNumber, &fh, q->data) != RC_OK)
-                    {
-                        // closePageFile(&fh);
-                        return RC_WRITE_FAILED;
-                    }
-                    bpInfo->writeNumber++;
-                }
-
-                q->pageNumber = pageNum;
-                q->fixCount++;
-                bpInfo->tail = q->nextFrame;
-                bpInfo->head = q;
-
-                break;
-            }
-            q = q->nextFrame;
+            prefetcher->frames[claimed++] = frame;
         }
+        pthread_mutex_unlock(&bpInfo->tableLatch);
     }
-    else
+
+    latchIO(io, false);
+    for (int i = 0; i < claimed; i++) // frames of a mapped pool take their page straight from the mapping
     {
-        q = bpInfo->head;
-        q->pageNumber = pageNum;
+        BM_PageFrame *frame = prefetcher->frames[i];
+        prefetcher->pending[i] = (BM_PendingIO){RC_READ_NON_EXISTING_PAGE, false};
+        prefetcher->results[i] = io->mapped ? mapBlock(frame->pageNumber, fh, &frame->data)
+                                            : submitReadBlock(frame->pageNumber, fh, frame->data, &prefetcher->pending[i]);
+    }
+    pthread_rwlock_unlock(&io->ioLatch);
 
-        if (q->nextFrame != bpInfo->head)
+    for (int i = 0; i < claimed; i++) // pages mapped and reads that could not be submitted are done already
+    {
+        BM_PageFrame *frame = prefetcher->frames[i];
+        if (io->mapped || prefetcher->results[i] != RC_OK)
         {
-            bpInfo->head = q->nextFrame;
+            finishLoad(partitionOf(bm, frame->pageNumber), frame, frame->pageNumber, true, prefetcher->results[i]);
         }
-        q->fixCount++;
-        bpInfo->framesCount++;
     }
-
-    ensureCapacity((pageNum + 1), &fh);
-    if (readBlock(pageNum, &fh, q->data) != RC_OK)
+    for (int i = 0; i < claimed && !io->mapped; i++) // the reads submitted, in the order they were submitted
     {
-        // closePageFile(&fh);
-        return RC_OK;
+        BM_PageFrame *frame = prefetcher->frames[i];
+        if (prefetcher->results[i] == RC_OK)
+        {
+            awaitIO(io, &prefetcher->pending[i]);
+            finishLoad(partitionOf(bm, frame->pageNumber), frame, frame->pageNumber, true, prefetcher->pending[i].rc);
+        }
     }
-    bpInfo->readNumber++;
-
-    page->pageNum = pageNum;
-    page->data = q->data;
-    // closePageFile(&fh);
-
-    return RC_OK;
 }
 
-BM_PageFrame *findFrameInBufferPool(BM_PoolInfo *bp_mgmt, const PageNumber pageNum);
-void updatePageAndFrame(BM_PageHandle *const page, BM_PageFrame *frame, const PageNumber pageNum, BM_PoolInfo *bp_mgmt);
-BM_PageFrame *allocateEmptyFrame(BM_PoolInfo *bp_mgmt, const PageNumber pageNum);
-BM_PageFrame *replacePage(BM_BufferPool *const bm, BM_PoolInfo *bp_mgmt, SM_FileHandle *fh, const PageNumber pageNum);
-
-RC LRU(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+/**
+ * Method to pin the page with page number pageNum. A page in the pool is only handed out, once the thread reading it
+ * is done, otherwise loadPage reads it. Pins of a pool reading ahead are followed for sequential scans.
+ */
+RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
 {
-    BM_PoolInfo *bp_mgmt = bm->mgmtData;
-    BM_PageFrame *frame = bp_mgmt->head;
-    SM_FileHandle fh;
-
-    openPageFile((char *)bm->pageFile, &fh);
-
-    // Check if the frame is already in the buffer pool
-    frame = findFrameInBufferPool(bp_mgmt, pageNum);
-    if (frame != NULL)
+    if (bm == NULL || bm->mgmtData == NULL) // the pool is not open
     {
-        updatePageAndFrame(page, frame, pageNum, bp_mgmt);
-        return RC_OK;
+        return RC_FILE_HANDLE_NOT_INIT;
     }
-
-    // If there are empty spaces in the buffer pool, fill those frames first
-    if (bp_mgmt->framesCount < bm->numPages)
+    if (pageNum < 0)
     {
-        frame = allocateEmptyFrame(bp_mgmt, pageNum);
+        return RC_READ_NON_EXISTING_PAGE;
     }
-    else
+    BM_BufferPool *const partition = partitionOf(bm, pageNum);
+    BM_PoolInfo *bpInfo = partition->mgmtData;
+    const BM_ReplacementPolicy *policy = bpInfo->policy;
+
+    pthread_mutex_lock(&bpInfo->tableLatch);
+    BM_PageFrame *frame = findFrame(bpInfo, pageNum);
+    bool missed = (frame == NULL);
+    if (!missed) // the page is already in the pool
     {
-        // Replace pages from the frame using LRU
-        frame = replacePage(bm, bp_mgmt, &fh, pageNum);
-        if (frame == NULL)
+        __atomic_add_fetch(&frame->fixCount, 1, __ATOMIC_ACQ_REL);
+        while (frame->loading) // another thread missed on the page and is still reading it
         {
-            return RC_WRITE_FAILED;
+            pthread_cond_wait(&bpInfo->pageLoaded, &bpInfo->tableLatch);
+        }
+        if (frame->pageNumber != pageNum) // its read failed
+        {
+            dropFailedPin(bpInfo, frame);
+            pthread_mutex_unlock(&bpInfo->tableLatch);
+            return RC_READ_NON_EXISTING_PAGE;
+        }
+        if (policy->onHit != NULL)
+        {
+            policy->onHit(partition, frame);
         }
+        pthread_mutex_unlock(&bpInfo->tableLatch);
     }
-
-    ensureCapacity((pageNum + 1), &fh);
-    if (readBlock(pageNum, &fh, frame->data) != RC_OK)
+    else
     {
-        return RC_READ_NON_EXISTING_PAGE;
+        RC rc = loadPage(partition, pageNum, &frame);
+        if (rc != RC_OK)
+        {
+            return rc;
+        }
     }
-    bp_mgmt->readNumber++;
+    readAhead(bm, pageNum, missed);
 
-    // Update the page frame and its data
     page->pageNum = pageNum;
     page->data = frame->data;
-
     return RC_OK;
 }
 
-BM_PageFrame *findFrameInBufferPool(BM_PoolInfo *bp_mgmt, const PageNumber pageNum)
+/**
+ * Method to unpin the page. The pageNum field of page is used to figure out which page to unpin.
+ */
+RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
 {
-    BM_PageFrame *frame = bp_mgmt->head;
-    do
+    if (bm == NULL || bm->mgmtData == NULL || page == NULL)
     {
-        if (frame->pageNumber == pageNum)
-        {
-            return frame;
-        }
-        frame = frame->nextFrame;
-    } while (frame != bp_mgmt->head);
-    return NULL;
-}
-
-void updatePageAndFrame(BM_PageHandle *const page, BM_PageFrame *frame, const PageNumber pageNum, BM_PoolInfo *bp_mgmt)
-{
-    page->pageNum = pageNum;
-    page->data = frame->data;
-
-    frame->fixCount++;
+        return RC_INVALID_PARAMETER;
+    }
+    BM_BufferPool *const partition = partitionOf(bm, page->pageNum);
+    BM_PoolInfo *bpInfo = partition->mgmtData; // initializing the pointer variable bpInfo to point to the memory location of mgmtData of the partition.
 
-    bp_mgmt->tail = bp_mgmt->head->nextFrame;
-    bp_mgmt->head = frame;
+    pthread_mutex_lock(&bpInfo->tableLatch);
+    BM_PageFrame *pageFrame = lookupFrame(bpInfo, page->pageNum); // the frame holding the page to unpin
+    if (pageFrame == NULL)
+    {
+        pthread_mutex_unlock(&bpInfo->tableLatch);
+        return RC_PAGE_NOT_FOUND;
+    }
+    __atomic_sub_fetch(&pageFrame->fixCount, 1, __ATOMIC_ACQ_REL); // decrements the fixcount
+    if (bpInfo->policy->onUnpin != NULL)
+    {
+        bpInfo->policy->onUnpin(partition, pageFrame);
+    }
+    pthread_mutex_unlock(&bpInfo->tableLatch);
+    return RC_OK;
 }
 
-BM_PageFrame *allocateEmptyFrame(BM_PoolInfo *bp_mgmt, const PageNumber pageNum)
+/**
+ * Method to find the frame of a page for an operation on it and pin it meanwhile, so it keeps the page while the
+ * table latch is not held. Returns NULL if the page is not in the pool.
+ */
+static BM_PageFrame *holdFrame(BM_PoolInfo *bpInfo, PageNumber pageNum)
 {
-    BM_PageFrame *frame = bp_mgmt->head;
-    frame->pageNumber = pageNum;
-
-    if (frame->nextFrame != bp_mgmt->head)
+    pthread_mutex_lock(&bpInfo->tableLatch);
+    BM_PageFrame *frame = lookupFrame(bpInfo, pageNum);
+    if (frame != NULL)
     {
-        bp_mgmt->head = frame->nextFrame;
+        __atomic_add_fetch(&frame->fixCount, 1, __ATOMIC_ACQ_REL);
     }
-
-    frame->fixCount++;
-    bp_mgmt->framesCount++;
+    pthread_mutex_unlock(&bpInfo->tableLatch);
     return frame;
 }
 
-BM_PageFrame *replacePage(BM_BufferPool *const bm, BM_PoolInfo *bp_mgmt, SM_FileHandle *fh, const PageNumber pageNum)
+/**
+ * Method to give up the pin taken by holdFrame. It never drops the last pin of a page pinned through pinPage.
+ */
+static void releaseFrame(BM_PageFrame *frame)
+{
+    __atomic_sub_fetch(&frame->fixCount, 1, __ATOMIC_ACQ_REL);
+}
+
+/**
+ *  Method to mark a page as dirty
+ **/
+RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page)
 {
-    BM_PageFrame *frame = bp_mgmt->tail;
-    do
+    // If bufferpool or page information  is null returns error code
+    if (bm == NULL || bm->mgmtData == NULL || page == NULL)
     {
-        if (frame->fixCount == 0)
-        {
-            if (frame->isDirty)
-            {
-                ensureCapacity(frame->pageNumber, fh);
-                if (writeBlock(frame->pageNumber, fh, frame->data) != RC_OK)
-                {
-                    return NULL;
-                }
-                bp_mgmt->writeNumber++;
-            }
+        return RC_INVALID_PARAMETER;
+    }
 
-            if (bp_mgmt->tail != bp_mgmt->head)
-            {
-                frame->pageNumber = pageNum;
-                frame->fixCount++;
-                bp_mgmt->tail = frame;
-                bp_mgmt->tail = frame->nextFrame;
-                return frame;
-            }
-            else
-            {
-                frame = frame->nextFrame;
-                frame->pageNumber = pageNum;
-                frame->fixCount++;
-                bp_mgmt->tail = frame;
-                bp_mgmt->head = frame;
-                bp_mgmt->tail = frame->previousFrame;
-                return frame;
-            }
-        }
-        frame = frame->nextFrame;
-    } while (frame != bp_mgmt->tail);
+    BM_PoolInfo *bpInfo = partitionOf(bm, page->pageNum)->mgmtData; // initializing the pointer variable bpInfo to point to the memory location of mgmtData of the partition.
 
-    return NULL;
+    pthread_mutex_lock(&bpInfo->tableLatch);
+    BM_PageFrame *pageFrame = lookupFrame(bpInfo, page->pageNum); // the frame holding the page to mark
+    if (pageFrame != NULL)
+    {
+        pageFrame->isDirty = true; // setting isDirty flag to true
+    }
+    pthread_mutex_unlock(&bpInfo->tableLatch);
+
+    return (pageFrame != NULL) ? RC_OK : RC_PAGE_NOT_FOUND;
 }
 
 /**
- * Method to pin the page with page number pageNum.
+ * Method to write the current content of the page back to the page file on disk
  */
-
-RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page)
 {
-
-    switch (bm->strategy)
+    if (bm == NULL || bm->mgmtData == NULL || page == NULL)
     {
-    case RS_FIFO:
-        FIFO(bm, page, pageNum);
-        break;
-
-    case RS_LRU:
-        LRU(bm, page, pageNum);
-        break;
+        return RC_INVALID_PARAMETER;
+    }
+    BM_PoolInfo *bpInfo = partitionOf(bm, page->pageNum)->mgmtData; // initializing the pointer variable bpInfo to point to the memory location of mgmtData of the partition.
+    BM_PageFrame *targetPage = holdFrame(bpInfo, page->pageNum); // the frame holding the page to write
+    if (targetPage == NULL)
+    {
+        return RC_PAGE_NOT_FOUND;
+    }
 
-    case RS_CLOCK:
-        // pinPageFIFO(bm, page, pageNum);
-        break;
+    RC rc;
+    pthread_mutex_lock(&bpInfo->tableLatch);
+    targetPage->isDirty = false; // reset before the write, a page marked dirty again meanwhile stays dirty
+    pthread_mutex_unlock(&bpInfo->tableLatch);
+    latchIO(bpInfo->io, false);
+    rc = writeBlock(page->pageNum, &bpInfo->io->fileHandle, page->data); // write a page to disk at an absolute position
+    pthread_rwlock_unlock(&bpInfo->io->ioLatch);
+    if (rc == RC_OK)
+    {
+        __atomic_add_fetch(&bpInfo->io->writeNumber, 1, __ATOMIC_RELAXED); // increment the write number of bufferpool info
     }
-    return RC_OK;
+    if (rc != RC_OK)
+    {
+        pthread_mutex_lock(&bpInfo->tableLatch);
+        targetPage->isDirty = true;
+        pthread_mutex_unlock(&bpInfo->tableLatch);
+    }
+    releaseFrame(targetPage);
+    return rc; // returns error code if response is unsuccessful
 }
 
 /**
- * Method to unpin the page. The pageNum field of page is used to figure out which page to unpin.
+ * Method to latch a pinned page, shared to read it or exclusive to change it. Threads sharing a pool latch the pages
+ * they use, the latch is waited for and held until unlatchPage. A latched page is never replaced.
  */
-RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
+RC latchPage(BM_BufferPool *const bm, BM_PageHandle *const page, bool exclusive)
 {
-    BM_PoolInfo *bpInfo = bm->mgmtData; // initializing the pointer variable bpInfo to point to the memory location of mgmtData of bm.
-
-    for (int i = 0; i < bm->numPages; i++)
+    if (bm == NULL || bm->mgmtData == NULL || page == NULL)
     {
-        BM_PageFrame *pageFrame = &(bpInfo->bufferPool[i]); // initializing page pointer to point to ith address of buffer pool
-        if (pageFrame->pageNumber == page->pageNum)         // if the page frame page number and the requested page number is same, the decrement the fix count to unpin the page
-        {
-            pageFrame->fixCount--; // decrements the fixcount
-            return RC_OK;          // returns successful response
-        }
+        return RC_INVALID_PARAMETER;
     }
-    return RC_OK;
+    BM_PageFrame *frame = holdFrame(partitionOf(bm, page->pageNum)->mgmtData, page->pageNum);
+    if (frame == NULL)
+    {
+        return RC_PAGE_NOT_FOUND;
+    }
+    int result = exclusive ? pthread_rwlock_wrlock(&frame->latch) : pthread_rwlock_rdlock(&frame->latch);
+    releaseFrame(frame);
+    return (result == 0) ? RC_OK : RC_INVALID_PARAMETER;
 }
 
 /**
- *  Method to mark a page as dirty
- **/
-RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page)
+ * Method to release the latch taken on a page with latchPage
+ */
+RC unlatchPage(BM_BufferPool *const bm, BM_PageHandle *const page)
 {
-    // If bufferpool or page information  is null returns error code
-    if (bm == NULL || page == NULL)
+    if (bm == NULL || bm->mgmtData == NULL || page == NULL)
     {
         return RC_INVALID_PARAMETER;
     }
-
-    BM_PoolInfo *bpInfo = bm->mgmtData; // initializing the pointer variable bpInfo to point to the memory location of mgmtData of bm.
-
-    for (int i = 0; i < bm->numPages; i++)
+    BM_PageFrame *frame = holdFrame(partitionOf(bm, page->pageNum)->mgmtData, page->pageNum);
+    if (frame == NULL)
     {
-        BM_PageFrame *pageFrame = &(bpInfo->bufferPool[i]); // initializing page frame pointer to point to ith address of buffer pool
-        if (pageFrame->pageNumber == page->pageNum)         // if the page frame page number and the requested page number is same, marks the page as dirty
-        {
-            pageFrame->isDirty = true; // setting isDirty flag to true
-            return RC_OK;              // returns successful respone
-        }
+        return RC_PAGE_NOT_FOUND;
     }
+    int result = pthread_rwlock_unlock(&frame->latch);
+    releaseFrame(frame);
+    return (result == 0) ? RC_OK : RC_INVALID_PARAMETER;
+}
 
-    return RC_PAGE_NOT_FOUND;
+/**
+ * Method to order page numbers
+ */
+static int comparePageNumber(const void *a, const void *b)
+{
+    PageNumber pageA = *(const PageNumber *)a;
+    PageNumber pageB = *(const PageNumber *)b;
+    return (pageA > pageB) - (pageA < pageB);
 }
 
 /**
- * Method to write the current content of the page back to the page file on disk
+ * Method to load pages into the pool ahead of their pins, so their reads overlap the work of the caller. The pages
+ * are queued for the background loader in page number order and once each, so its batches submit their reads in file
+ * order. The loader is started on the first call if the pool does not read ahead. Like pages read ahead they only take
+ * free or clean frames and are left unpinned. Pages past the end of the file or already in the pool are skipped, and
+ * pages beyond what the queue holds, twice the frames, are dropped.
  */
-RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page)
+RC prefetchPages(BM_BufferPool *const bm, const PageNumber *pageNums, int n)
 {
-    BM_PoolInfo *bpInfo = bm->mgmtData; // initializing the pointer variable bpInfo to point to the memory location of mgmtData of bm.
-    for (int i = 0; i < bm->numPages; i++)
+    if (bm == NULL || bm->mgmtData == NULL) // the pool is not open
+    {
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    if (n < 0 || (n > 0 && pageNums == NULL))
     {
-        if (((BM_PageFrame *)&bpInfo->bufferPool[i])->pageNumber == page->pageNum) // initializing pointer to point to ith address of buffer pool and checking if the page number matches with the requested page number
+        return RC_INVALID_PARAMETER;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        if (pageNums[i] < 0)
         {
-            BM_PageFrame *targetPage = &(bpInfo->bufferPool[i]); // initializing target page pointer to point to ith address of buffer pool
-            SM_FileHandle fHandle;
-            RC rc;
-            rc = openPageFile(bm->pageFile, &fHandle); // opens an existing file
-            if (rc != RC_OK)
-            {
-                return rc; // returns error code if response is unsuccessful
-            }
-            rc = writeBlock(page->pageNum, &fHandle, page->data); // write a page to disk at an absolute position
-            if (rc != RC_OK)
-            {
-                closePageFile(&fHandle); // closes the file
-                return rc;               // returns error code if response is unsuccessful
-            }
-
-            targetPage->isDirty = false; // target page isDirty flag is set to flase
+            return RC_READ_NON_EXISTING_PAGE;
+        }
+    }
 
-            bpInfo->writeNumber++; // increment the write number of bufferpool info
+    BM_PoolInfo *bpInfo = bm->mgmtData;
+    BM_Prefetcher *prefetcher = __atomic_load_n(&bpInfo->prefetcher, __ATOMIC_ACQUIRE);
+    if (prefetcher == NULL)
+    {
+        RC rc = RC_OK;
+        pthread_mutex_lock(&bpInfo->startLatch); // two first calls start a single loader
+        if (bpInfo->prefetcher == NULL)
+        {
+            rc = startPrefetcher(bm, 0);
+        }
+        pthread_mutex_unlock(&bpInfo->startLatch);
+        if (rc != RC_OK)
+        {
+            return rc;
+        }
+        prefetcher = bpInfo->prefetcher;
+    }
+    if (n == 0)
+    {
+        return RC_OK;
+    }
 
-            rc = closePageFile(&fHandle); // close the page file
-            if (rc != RC_OK)
-            {
-                return rc; // returns error code if response is unsuccessful
-            }
-            return RC_OK;
+    PageNumber *sorted = (PageNumber *)malloc(n * sizeof(PageNumber));
+    memcpy(sorted, pageNums, n * sizeof(PageNumber));
+    qsort(sorted, n, sizeof(PageNumber), comparePageNumber);
+    pthread_mutex_lock(&prefetcher->lock);
+    for (int i = 0; i < n; i++)
+    {
+        if (i == 0 || sorted[i] != sorted[i - 1])
+        {
+            queuePage(prefetcher, sorted[i]);
         }
     }
+    pthread_cond_signal(&prefetcher->queued);
+    pthread_mutex_unlock(&prefetcher->lock);
+    free(sorted);
     return RC_OK;
 }
 
@@ -491,17 +2582,25 @@ RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page)
 
 /**
  * Method returns an array of PageNumbers (of size numPages) where the ith element is the number of the page stored in the ith page frame.
- * An empty page frame is represented using the constant NO PAGE
+ * An empty page frame is represented using the constant NO PAGE. The frames of a partitioned pool are numbered partition by partition.
  */
 PageNumber *getFrameContents(BM_BufferPool *const bm)
 {
     BM_PoolInfo *bpInfo = bm->mgmtData;                        // initializing the pointer variable buffPoolInfo to point to the memory location of mgmtData of bm.
     int *pageNums = (int *)malloc(bm->numPages * sizeof(int)); // dynamically allocationg memory to page nums and returns pointer to allocated memory
+    int n = 0;
 
-    for (int i = 0; i < bm->numPages; i++)
+    for (int p = 0; p < partitionCount(bm); p++) // the frames of the partitions one after the other
     {
-        int pageNum = ((BM_PageFrame *)&bpInfo->bufferPool[i])->pageNumber; // initializing pointer to point to ith address of buffer pool and assigninig its pageNumber to pageNum
-        pageNums[i] = (pageNum == NO_PAGE) ? NO_PAGE : pageNum;             // When the page frame is empty NO_PAGE is returend(-1)
+        BM_BufferPool *partition = partitionAt(bm, p);
+        bpInfo = partition->mgmtData;
+        pthread_mutex_lock(&bpInfo->tableLatch); // the frames do not change pages while they are read
+        for (int i = 0; i < partition->numPages; i++)
+        {
+            int pageNum = ((BM_PageFrame *)&bpInfo->bufferPool[i])->pageNumber; // initializing pointer to point to ith address of buffer pool and assigninig its pageNumber to pageNum
+            pageNums[n++] = (pageNum == NO_PAGE) ? NO_PAGE : pageNum;           // When the page frame is empty NO_PAGE is returend(-1)
+        }
+        pthread_mutex_unlock(&bpInfo->tableLatch);
     }
     return pageNums; // returns array of page numbers of size equal to the number of frames in buffer pool
 }
@@ -514,10 +2613,18 @@ bool *getDirtyFlags(BM_BufferPool *const bm)
 {
     BM_PoolInfo *bpInfo = bm->mgmtData;                        // initializing the pointer variable buffPoolInfo to point to the memory location of mgmtData of bm.
     bool *dFlags = (bool *)malloc(bm->numPages * sizeof(int)); // dynamically allocationg memory to dirty flags and returns pointer to allocated memory
+    int n = 0;
 
-    for (int i = 0; i < bm->numPages; i++)
+    for (int p = 0; p < partitionCount(bm); p++)
     {
-        dFlags[i] = ((BM_PageFrame *)&bpInfo->bufferPool[i])->isDirty; // initializing pointer to point to ith address of buffer pool and assigninig its isDirty to dirtyFlags array
+        BM_BufferPool *partition = partitionAt(bm, p);
+        bpInfo = partition->mgmtData;
+        pthread_mutex_lock(&bpInfo->tableLatch);
+        for (int i = 0; i < partition->numPages; i++)
+        {
+            dFlags[n++] = ((BM_PageFrame *)&bpInfo->bufferPool[i])->isDirty; // initializing pointer to point to ith address of buffer pool and assigninig its isDirty to dirtyFlags array
+        }
+        pthread_mutex_unlock(&bpInfo->tableLatch);
     }
     return dFlags; // returns array of dirty flags of size equal to the number of frames in buffer pool
 }
@@ -530,19 +2637,33 @@ int *getFixCounts(BM_BufferPool *const bm)
 {
     BM_PoolInfo *bpInfo = bm->mgmtData;                       // initializing the pointer variable bpInfo to point to the memory location of mgmtData of bm.
     int *fCounts = (int *)malloc(bm->numPages * sizeof(int)); // dynamically allocationg memory to fix counts flags and returns pointer to allocated memory
-    for (int i = 0; i < bm->numPages; i++)
+    int n = 0;
+    for (int p = 0; p < partitionCount(bm); p++)
     {
-        fCounts[i] = ((BM_PageFrame *)&bpInfo->bufferPool[i])->fixCount; // initializing pointer to point to ith address of buffer pool and assigninig its fixCount to fixCount array
+        BM_BufferPool *partition = partitionAt(bm, p);
+        bpInfo = partition->mgmtData;
+        for (int i = 0; i < partition->numPages; i++)
+        {
+            fCounts[n++] = __atomic_load_n(&bpInfo->bufferPool[i].fixCount, __ATOMIC_ACQUIRE); // assigninig the fixCount of the ith frame to fixCount array
+        }
     }
     return fCounts; // returns array of fixcounts of size equal to the number of frames in buffer pool
 }
 
+/**
+ * Method to read an I/O counter, a background writer or loader may be counting meanwhile
+ */
+static int readIOCounter(int *counter)
+{
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
 /**
  * Method to return the number of pages that have been read from disk since a buffer pool has been initialized.
  */
 int getNumReadIO(BM_BufferPool *const bm)
 {
-    return ((BM_PoolInfo *)bm->mgmtData)->readNumber;
+    return readIOCounter(&((BM_PoolInfo *)bm->mgmtData)->readNumber);
 }
 
 /**
@@ -550,7 +2671,33 @@ int getNumReadIO(BM_BufferPool *const bm)
  */
 int getNumWriteIO(BM_BufferPool *const bm)
 {
-    return ((BM_PoolInfo *)bm->mgmtData)->writeNumber;
+    return readIOCounter(&((BM_PoolInfo *)bm->mgmtData)->writeNumber);
+}
+
+/**
+ * Method to return the number of pages pinPage wrote back itself because the frame it took held a dirty page.
+ * A background writer keeps this low by cleaning frames ahead of their replacement.
+ */
+int getNumDirtyVictims(BM_BufferPool *const bm)
+{
+    return readIOCounter(&((BM_PoolInfo *)bm->mgmtData)->dirtyVictims);
+}
+
+/**
+ * Method to return the number of pages of getNumReadIO the background loader read ahead of their pins
+ */
+int getNumPrefetchIO(BM_BufferPool *const bm)
+{
+    return readIOCounter(&((BM_PoolInfo *)bm->mgmtData)->prefetchNumber);
+}
+
+/**
+ * Method to return the I/O statistics of the page file of the buffer pool, the storage manager level
+ * counterpart of getNumReadIO and getNumWriteIO with syscall counts and latency histograms
+ */
+RC getPoolFileStats(BM_BufferPool *const bm, SM_FileStats *stats)
+{
+    return getFileStats(&((BM_PoolInfo *)bm->mgmtData)->fileHandle, stats);
 }
 
 /*Statistics Functions - END*/
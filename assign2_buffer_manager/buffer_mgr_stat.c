@@ -6,6 +6,7 @@
 
 // local functions
 static void printStrat (BM_BufferPool *const bm);
+static char *sprintPageBytes (BM_PageHandle *const page, int pageSize);
 
 // external functions
 void 
@@ -51,55 +52,60 @@ sprintPoolContent (BM_BufferPool *const bm)
 }
 
 
-void
-printPageContent (BM_PageHandle *const page)
+// dump pageSize bytes of a page, 8 bytes per group and 64 per line
+static char *
+sprintPageBytes (BM_PageHandle *const page, int pageSize)
 {
 	int i;
+	char *message;
+	int pos = 0;
+
+	message = (char *) malloc(30 + (2 * pageSize) + (pageSize / 8) + (pageSize / 64) + 1);
+	pos += sprintf(message + pos, "[Page %i]\n", page->pageNum);
+
+	for (i = 1; i <= pageSize; i++)
+		pos += sprintf(message + pos, "%02X%s%s", (unsigned char) page->data[i - 1], (i % 8) ? "" : " ", (i % 64) ? "" : "\n");
 
-	printf("[Page %i]\n", page->pageNum);
+	return message;
+}
+
+void
+printPageContent (BM_PageHandle *const page)
+{
+	char *message = sprintPageBytes(page, PAGE_SIZE);
 
-	for (i = 1; i <= PAGE_SIZE; i++)
-		printf("%02X%s%s", page->data[i], (i % 8) ? "" : " ", (i % 64) ? "" : "\n");
+	printf("%s", message);
+	free(message);
 }
 
 char *
 sprintPageContent (BM_PageHandle *const page)
 {
-	int i;
-	char *message;
-	int pos = 0;
+	return sprintPageBytes(page, PAGE_SIZE);
+}
 
-	message = (char *) malloc(30 + (2 * PAGE_SIZE) + (PAGE_SIZE % 64) + (PAGE_SIZE % 8));
-	pos += sprintf(message + pos, "[Page %i]\n", page->pageNum);
+void
+printPoolPageContent (BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+	char *message = sprintPageBytes(page, bm->pageSize);
 
-	for (i = 1; i <= PAGE_SIZE; i++)
-		pos += sprintf(message + pos, "%02X%s%s", page->data[i], (i % 8) ? "" : " ", (i % 64) ? "" : "\n");
+	printf("%s", message);
+	free(message);
+}
 
-	return message;
+char *
+sprintPoolPageContent (BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+	return sprintPageBytes(page, bm->pageSize);
 }
 
 void
 printStrat (BM_BufferPool *const bm)
 {
-	switch (bm->strategy)
-	{
-	case RS_FIFO:
-		printf("FIFO");
-		break;
-	case RS_LRU:
-		printf("LRU");
-		break;
-	case RS_CLOCK:
-		printf("CLOCK");
-		break;
-	case RS_LFU:
-		printf("LFU");
-		break;
-	case RS_LRU_K:
-		printf("LRU-K");
-		break;
-	default:
+	const BM_ReplacementPolicy *policy = findReplacementPolicy(bm->strategy);
+
+	if (policy != NULL)
+		printf("%s", policy->name);
+	else
 		printf("%i", bm->strategy);
-		break;
-	}
 }
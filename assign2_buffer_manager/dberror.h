@@ -14,6 +14,10 @@ typedef int RC;
 #define RC_FILE_HANDLE_NOT_INIT 2
 #define RC_WRITE_FAILED 3
 #define RC_READ_NON_EXISTING_PAGE 4
+#define RC_MAP_FAILED 6
+#define RC_NO_FREE_PAGE_MAP 7
+#define RC_PAGE_CORRUPT 8
+#define RC_UNKNOWN_CODEC 9
 
 #define RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE 200
 #define RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN 201
@@ -0,0 +1,210 @@
+#include "log_mgr.h"
+#include "dberror.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define LOG_BATCH_SIZE 64 // messages the writer thread takes out of the ring at once
+
+volatile int logLevel = LOG_LEVEL_INFO;
+
+static const char *levelNames[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR"};
+
+/**
+ * Ring of formatted messages between the threads logging and the writer thread of the asynchronous sink.
+ * Producers only copy their message into the next slot, the writer thread does the stdio calls.
+ */
+typedef struct LOG_Ring
+{
+    pthread_t thread;
+    pthread_cond_t available; // signalled when the ring gets a message while the writer waits, or when it has to stop
+    FILE *out;
+    char (*slots)[LOG_MESSAGE_SIZE];
+    int size;
+    long long head;    // messages taken out by the writer
+    long long tail;    // messages put in by producers
+    long long dropped; // messages lost because the ring was full
+    int waiting;       // the writer sleeps on available
+    int stopping;
+} LOG_Ring;
+
+static pthread_mutex_t ringLock = PTHREAD_MUTEX_INITIALIZER; // guards the ring pointer and the counters in the ring
+static LOG_Ring *ring = NULL;
+static long long droppedTotal = 0; // messages dropped by rings already stopped
+
+/* writer thread - Begin */
+
+/**
+ * Method run by the writer thread, takes batches of messages out of the ring and writes them until the sink is stopped
+ * and the ring is empty.
+ **/
+static void *writeMessages(void *arg)
+{
+    LOG_Ring *r = (LOG_Ring *)arg;
+    char (*batch)[LOG_MESSAGE_SIZE] = malloc(LOG_BATCH_SIZE * LOG_MESSAGE_SIZE);
+
+    pthread_mutex_lock(&ringLock);
+    for (;;)
+    {
+        while (r->head == r->tail && !r->stopping)
+        {
+            r->waiting = 1;
+            pthread_cond_wait(&r->available, &ringLock);
+            r->waiting = 0;
+        }
+        if (r->head == r->tail) // stopping and nothing left
+        {
+            break;
+        }
+        int count = 0;
+        for (; r->head < r->tail && count < LOG_BATCH_SIZE; r->head++, count++)
+        {
+            memcpy(batch[count], r->slots[r->head % r->size], LOG_MESSAGE_SIZE);
+        }
+        pthread_mutex_unlock(&ringLock); // producers keep logging while the batch is written
+        for (int i = 0; i < count; i++)
+        {
+            fputs(batch[i], r->out);
+        }
+        fflush(r->out);
+        pthread_mutex_lock(&ringLock);
+    }
+    pthread_mutex_unlock(&ringLock);
+
+    free(batch);
+    return NULL;
+}
+
+/* writer thread - End */
+
+/* logging - Begin */
+
+/**
+ * Method to set the lowest level of the messages written. Messages below LOG_COMPILE_LEVEL are gone whatever the level.
+ **/
+void setLogLevel(int level)
+{
+    logLevel = level;
+}
+
+/**
+ * Method to format a message with its level and source position and to hand it to the sink. Called through the LOG_* macros.
+ **/
+void logMessage(int level, const char *file, int line, const char *format, ...)
+{
+    char message[LOG_MESSAGE_SIZE];
+    const char *base = strrchr(file, '/');
+    int length = snprintf(message, sizeof(message), "[%s] %s:%d ", levelNames[(level < LOG_LEVEL_OFF) ? level : LOG_LEVEL_ERROR],
+                          (base != NULL) ? base + 1 : file, line);
+    if (length < 0 || length >= (int)sizeof(message) - 1)
+    {
+        length = sizeof(message) - 2;
+    }
+    va_list args;
+    va_start(args, format);
+    int formatted = vsnprintf(message + length, sizeof(message) - 1 - length, format, args);
+    va_end(args);
+    length = (formatted < 0 || length + formatted >= (int)sizeof(message) - 1) ? (int)sizeof(message) - 2 : length + formatted;
+    message[length] = '\n'; // a cut message still ends its line
+    message[length + 1] = '\0';
+
+    pthread_mutex_lock(&ringLock);
+    LOG_Ring *r = ring;
+    if (r == NULL) // no asynchronous sink, written right away
+    {
+        pthread_mutex_unlock(&ringLock);
+        fputs(message, stderr);
+        return;
+    }
+    if (r->tail - r->head == r->size) // the hot path never waits for the writer
+    {
+        r->dropped++;
+    }
+    else
+    {
+        memcpy(r->slots[r->tail % r->size], message, length + 2);
+        r->tail++;
+        if (r->waiting)
+        {
+            pthread_cond_signal(&r->available);
+        }
+    }
+    pthread_mutex_unlock(&ringLock);
+}
+
+/* logging - End */
+
+/* sinks - Begin */
+
+/**
+ * Method to send the messages from now on through a ring of ringSize messages to a writer thread writing them to out,
+ * 0 asks for LOG_DEFAULT_RING_SIZE. Messages arriving while the ring is full are dropped and counted.
+ **/
+RC startAsyncLogging(FILE *out, int ringSize)
+{
+    if (out == NULL || ringSize < 0)
+    {
+        printError(RC_INVALID_PARAMETER);
+        return RC_INVALID_PARAMETER;
+    }
+    LOG_Ring *r = (LOG_Ring *)calloc(1, sizeof(LOG_Ring));
+    r->out = out;
+    r->size = (ringSize > 0) ? ringSize : LOG_DEFAULT_RING_SIZE;
+    r->slots = malloc((size_t)r->size * LOG_MESSAGE_SIZE);
+    pthread_cond_init(&r->available, NULL);
+
+    pthread_mutex_lock(&ringLock);
+    if (ring != NULL || r->slots == NULL || pthread_create(&r->thread, NULL, writeMessages, r) != 0) // one sink at a time
+    {
+        pthread_mutex_unlock(&ringLock);
+        pthread_cond_destroy(&r->available);
+        free(r->slots);
+        free(r);
+        printError(RC_INVALID_PARAMETER);
+        return RC_INVALID_PARAMETER;
+    }
+    ring = r;
+    pthread_mutex_unlock(&ringLock);
+    return RC_OK;
+}
+
+/**
+ * Method to stop the asynchronous sink after the messages in its ring are written, later messages go to stderr again.
+ **/
+RC stopAsyncLogging(void)
+{
+    pthread_mutex_lock(&ringLock);
+    LOG_Ring *r = ring;
+    if (r == NULL)
+    {
+        pthread_mutex_unlock(&ringLock);
+        return RC_OK;
+    }
+    ring = NULL; // new messages no longer enter the ring
+    r->stopping = 1;
+    pthread_cond_signal(&r->available);
+    pthread_mutex_unlock(&ringLock);
+
+    pthread_join(r->thread, NULL);
+    pthread_mutex_lock(&ringLock);
+    droppedTotal += r->dropped;
+    pthread_mutex_unlock(&ringLock);
+    pthread_cond_destroy(&r->available);
+    free(r->slots);
+    free(r);
+    return RC_OK;
+}
+
+/**
+ * Method to retrieve the number of messages dropped because the ring of the asynchronous sink was full.
+ **/
+long long getDroppedLogMessages(void)
+{
+    pthread_mutex_lock(&ringLock);
+    long long dropped = droppedTotal + ((ring != NULL) ? ring->dropped : 0);
+    pthread_mutex_unlock(&ringLock);
+    return dropped;
+}
+
+/* sinks - End */
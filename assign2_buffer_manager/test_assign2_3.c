@@ -0,0 +1,1090 @@
+#include "storage_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+#include "test_helper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+// var to store the current test's name
+char *testName;
+
+// check whether two the content of a buffer pool is the same as an expected content
+// (given in the format produced by sprintPoolContent)
+#define ASSERT_EQUALS_POOL(expected,bm,message)			        \
+  do {									\
+    char *real;								\
+    char *_exp = (char *) (expected);                                   \
+    real = sprintPoolContent(bm);					\
+    if (strcmp((_exp),real) != 0)					\
+      {									\
+	printf("[%s-%s-L%i-%s] FAILED: expected <%s> but was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+	free(real);							\
+	exit(1);							\
+      }									\
+    printf("[%s-%s-L%i-%s] OK: expected <%s> and was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+    free(real);								\
+  } while(0)
+
+#define TESTPF "testbuffer3.bin"
+
+// test and helper methods
+static void createDummyPages(BM_BufferPool *bm, int num);
+static bool waitForPage (BM_BufferPool *bm, PageNumber pageNum);
+static void testPageTable (void);
+static void testCLOCK (void);
+static void testLRU_K (void);
+static void testLFU (void);
+static void testARC (void);
+static void test2Q (void);
+static void testCustomPolicy (void);
+static void testConcurrentPins (void);
+static void testPartitionedPool (void);
+static void testBackgroundWriter (void);
+static void testReadAhead (void);
+static void testPrefetchPages (void);
+static void testLargePageDump (void);
+
+// main method
+int
+main (void)
+{
+  initStorageManager();
+  testName = "";
+
+  testPageTable();
+  testCLOCK();
+  testLRU_K();
+  testLFU();
+  testARC();
+  test2Q();
+  testCustomPolicy();
+  testConcurrentPins();
+  testPartitionedPool();
+  testBackgroundWriter();
+  testReadAhead();
+  testPrefetchPages();
+  testLargePageDump();
+
+  return 0;
+}
+
+// create n pages with content "Page X"
+void
+createDummyPages(BM_BufferPool *bm, int num)
+{
+  int i;
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+
+  CHECK(initBufferPool(bm, TESTPF, 3, RS_FIFO, NULL));
+
+  for (i = 0; i < num; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(h->data, "%s-%i", "Page", h->pageNum);
+      CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm,h));
+    }
+
+  CHECK(shutdownBufferPool(bm));
+
+  free(h);
+}
+
+// pin pages of a large pool in a scattered order, every lookup has to find the frame holding the page
+void
+testPageTable (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  char expected[64];
+  PageNumber *frameContents;
+  int *seen = calloc(500, sizeof(int));
+  int i, j, reads;
+
+  testName = "Testing the page table of a large pool";
+
+  CHECK(createPageFile(TESTPF));
+  createDummyPages(bm, 500);
+  CHECK(initBufferPool(bm, TESTPF, 64, RS_FIFO, NULL));
+
+  // pages come and go, so entries are removed from the middle of probe sequences
+  for (i = 0; i < 5000; i++)
+    {
+      CHECK(pinPage(bm, h, (i * 7919) % 500));
+      sprintf(expected, "%s-%i", "Page", (i * 7919) % 500);
+      ASSERT_EQUALS_STRING(expected, h->data, "page found in its frame");
+      CHECK(unpinPage(bm, h));
+    }
+
+  // every page in the pool is in exactly one frame and pinning it again is a hit
+  frameContents = getFrameContents(bm);
+  reads = getNumReadIO(bm);
+  for (i = 0; i < 64; i++)
+    {
+      ASSERT_TRUE((frameContents[i] != NO_PAGE && seen[frameContents[i]]++ == 0), "page held by a single frame");
+      CHECK(pinPage(bm, h, frameContents[i]));
+      CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_INT(reads, getNumReadIO(bm), "pages in the pool are not read again");
+
+  // pages that left the pool cannot be marked
+  for (j = 0; j < 500 && seen[j]; j++);
+  h->pageNum = j;
+  ASSERT_ERROR(markDirty(bm, h), "page not in the pool");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile(TESTPF));
+
+  free(frameContents);
+  free(seen);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test the CLOCK page replacement strategy
+void
+testCLOCK (void)
+{
+  // expected results
+  const char *poolContents[] = {
+    // fill the pool, every page gets its reference bit
+    "[0 0],[-1 0],[-1 0]",
+    "[0 0],[1 0],[-1 0]",
+    "[0 0],[1 0],[2 0]",
+    // the first round clears all bits, the frame of page 0 is taken on the second
+    "[3 0],[1 0],[2 0]",
+    // a hit sets the bit of page 1 again, so page 2 is replaced before it
+    "[3 0],[1 0],[2 0]",
+    "[3 0],[1 0],[4 0]",
+    "[3 0],[5 0],[4 0]",
+    "[3 0],[5 0],[4 0]",
+    "[3 0],[5 0],[6 0]"
+  };
+  const int requests[] = {0,1,2,3,1,4,5,3,6};
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+
+  testName = "Testing CLOCK page replacement";
+
+  CHECK(createPageFile(TESTPF));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPool(bm, TESTPF, 3, RS_CLOCK, NULL));
+
+  for (i = 0; i < 9; i++)
+    {
+      CHECK(pinPage(bm, h, requests[i]));
+      CHECK(unpinPage(bm, h));
+      ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+    }
+
+  // the hand passes over a pinned frame
+  CHECK(pinPage(bm, h, 5));
+  ASSERT_EQUALS_POOL("[3 0],[5 1],[6 0]", bm, "pool content after pin page");
+  CHECK(pinPage(bm, h, 7));
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_POOL("[7 0],[5 1],[6 0]", bm, "pinned page kept");
+  CHECK(pinPage(bm, h, 8));
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_POOL("[7 0],[5 1],[8 0]", bm, "pinned page kept");
+  h->pageNum = 5;
+  CHECK(unpinPage(bm, h));
+
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(9, getNumReadIO(bm), "check number of read I/Os");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile(TESTPF));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test the LRU-K page replacement strategy with K = 2, the retained history of evicted pages and the correlated period
+void
+testLRU_K (void)
+{
+  // expected results
+  const char *poolContents[] = {
+    "[0 0],[-1 0],[-1 0]",
+    "[0 0],[1 0],[-1 0]",
+    "[0 0],[1 0],[2 0]",
+    // pages 0 and 1 get their second reference
+    "[0 0],[1 0],[2 0]",
+    "[0 0],[1 0],[2 0]",
+    // pages seen once go first, LRU would have replaced page 0
+    "[0 0],[1 0],[3 0]",
+    "[0 0],[1 0],[4 0]",
+    // page 2 comes back with its retained reference, so page 0 has the oldest second reference
+    "[0 0],[1 0],[2 0]",
+    "[5 0],[1 0],[2 0]"
+  };
+  const int requests[] = {0,1,2,0,1,3,4,2,5};
+  // a burst of pins of page 2 is a single reference within the correlated period
+  const int burst[] = {0,1,2,2,2,0,1,3};
+  int i;
+  int k = 2;
+  BM_PoolOptions options;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+
+  testName = "Testing LRU-K page replacement";
+
+  CHECK(createPageFile(TESTPF));
+  createDummyPages(bm, 100);
+
+  i = 0;
+  ASSERT_ERROR(initBufferPool(bm, TESTPF, 3, RS_LRU_K, &i), "K has to be at least 1");
+
+  CHECK(initBufferPool(bm, TESTPF, 3, RS_LRU_K, &k));
+  for (i = 0; i < 9; i++)
+    {
+      CHECK(pinPage(bm, h, requests[i]));
+      CHECK(unpinPage(bm, h));
+      ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+    }
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(7, getNumReadIO(bm), "check number of read I/Os");
+  CHECK(shutdownBufferPool(bm));
+
+  // without a correlated period the burst gives page 2 the most recent second reference
+  CHECK(initBufferPool(bm, TESTPF, 3, RS_LRU_K, &k));
+  for (i = 0; i < 8; i++)
+    {
+      CHECK(pinPage(bm, h, burst[i]));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_POOL("[3 0],[1 0],[2 0]", bm, "burst counted as references");
+  CHECK(shutdownBufferPool(bm));
+
+  memset(&options, 0, sizeof(options));
+  options.correlatedPeriod = 2;
+  CHECK(initBufferPoolWithOptions(bm, TESTPF, 3, RS_LRU_K, &k, &options));
+  for (i = 0; i < 8; i++)
+    {
+      CHECK(pinPage(bm, h, burst[i]));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_POOL("[0 0],[1 0],[3 0]", bm, "burst counted as one reference");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile(TESTPF));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test the LFU page replacement strategy and the aging of its reference counts
+void
+testLFU (void)
+{
+  // expected results
+  const char *poolContents[] = {
+    "[0 0],[-1 0],[-1 0]",
+    "[0 0],[1 0],[-1 0]",
+    "[0 0],[1 0],[2 0]",
+    // page 0 is referenced three times, page 1 twice
+    "[0 0],[1 0],[2 0]",
+    "[0 0],[1 0],[2 0]",
+    "[0 0],[1 0],[2 0]",
+    // pages referenced once go first
+    "[0 0],[1 0],[3 0]",
+    "[0 0],[1 0],[4 0]",
+    // page 4 reaches two references after page 1, so page 1 goes first
+    "[0 0],[1 0],[4 0]",
+    "[0 0],[5 0],[4 0]"
+  };
+  const int requests[] = {0,1,2,0,0,1,3,4,4,5};
+  // page 0 is hot at the start only
+  const int shift[] = {0,0,0,1,2,2,3};
+  int i;
+  BM_PoolOptions options;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+
+  testName = "Testing LFU page replacement";
+
+  CHECK(createPageFile(TESTPF));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPool(bm, TESTPF, 3, RS_LFU, NULL));
+
+  for (i = 0; i < 10; i++)
+    {
+      CHECK(pinPage(bm, h, requests[i]));
+      CHECK(unpinPage(bm, h));
+      ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+    }
+
+  // the pinned page 5 has the lowest count but stays
+  CHECK(pinPage(bm, h, 5));
+  CHECK(pinPage(bm, h, 6));
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_POOL("[0 0],[5 1],[6 0]", bm, "pinned page kept");
+  h->pageNum = 5;
+  CHECK(unpinPage(bm, h));
+
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(7, getNumReadIO(bm), "check number of read I/Os");
+  CHECK(shutdownBufferPool(bm));
+
+  // without aging page 0 keeps its frame
+  CHECK(initBufferPool(bm, TESTPF, 2, RS_LFU, NULL));
+  for (i = 0; i < 7; i++)
+    {
+      CHECK(pinPage(bm, h, shift[i]));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_POOL("[0 0],[3 0]", bm, "old hot page kept");
+  CHECK(shutdownBufferPool(bm));
+
+  // halving the counts after four pins lets page 2 overtake it
+  memset(&options, 0, sizeof(options));
+  options.agingPeriod = 4;
+  CHECK(initBufferPoolWithOptions(bm, TESTPF, 2, RS_LFU, NULL, &options));
+  for (i = 0; i < 7; i++)
+    {
+      CHECK(pinPage(bm, h, shift[i]));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_POOL("[3 0],[2 0]", bm, "old hot page aged out");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile(TESTPF));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test the ARC page replacement strategy and that a scan does not evict the frequently used pages
+void
+testARC (void)
+{
+  // expected results
+  const char *poolContents[] = {
+    "[0 0],[-1 0],[-1 0]",
+    "[0 0],[1 0],[-1 0]",
+    "[0 0],[1 0],[2 0]",
+    // page 0 becomes frequent
+    "[0 0],[1 0],[2 0]",
+    // the recent list gives up page 1, which is remembered
+    "[0 0],[3 0],[2 0]",
+    // page 1 comes back as a frequent page and the recent list is allowed to grow
+    "[0 0],[3 0],[1 0]",
+    "[4 0],[3 0],[1 0]",
+    // page 0 comes back from the frequent ghosts and the recent list has to shrink again
+    "[4 0],[0 0],[1 0]"
+  };
+  const int requests[] = {0,1,2,0,3,1,4,0};
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+
+  testName = "Testing ARC page replacement";
+
+  CHECK(createPageFile(TESTPF));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPool(bm, TESTPF, 3, RS_ARC, NULL));
+
+  for (i = 0; i < 8; i++)
+    {
+      CHECK(pinPage(bm, h, requests[i]));
+      CHECK(unpinPage(bm, h));
+      ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+    }
+
+  // a scan only cycles through the recent list
+  for (i = 10; i < 20; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_POOL("[19 0],[0 0],[1 0]", bm, "frequent pages survive the scan");
+
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(17, getNumReadIO(bm), "check number of read I/Os");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile(TESTPF));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test the 2Q page replacement strategy with one frame for the recent queue and two remembered pages
+void
+test2Q (void)
+{
+  // expected results
+  const char *poolContents[] = {
+    "[0 0],[-1 0],[-1 0],[-1 0]",
+    "[0 0],[1 0],[-1 0],[-1 0]",
+    "[0 0],[1 0],[2 0],[-1 0]",
+    "[0 0],[1 0],[2 0],[3 0]",
+    // a hit in the recent queue does not make page 0 hot
+    "[0 0],[1 0],[2 0],[3 0]",
+    "[4 0],[1 0],[2 0],[3 0]",
+    // page 0 is remembered, so it comes back as a hot page
+    "[4 0],[0 0],[2 0],[3 0]",
+    "[4 0],[0 0],[5 0],[3 0]",
+    "[4 0],[0 0],[5 0],[6 0]",
+    // page 1 was forgotten, the scan goes round the recent queue only
+    "[1 0],[0 0],[5 0],[6 0]",
+    "[1 0],[0 0],[7 0],[6 0]",
+    "[1 0],[0 0],[7 0],[8 0]",
+    "[9 0],[0 0],[7 0],[8 0]"
+  };
+  const int requests[] = {0,1,2,3,0,4,0,5,6,1,7,8,9};
+  const PageNumber prefetched[] = {1, 30};
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+
+  testName = "Testing 2Q page replacement";
+
+  CHECK(createPageFile(TESTPF));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPool(bm, TESTPF, 4, RS_2Q, NULL));
+
+  for (i = 0; i < 13; i++)
+    {
+      CHECK(pinPage(bm, h, requests[i]));
+      CHECK(unpinPage(bm, h));
+      ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+    }
+
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(12, getNumReadIO(bm), "check number of read I/Os");
+
+  // pages prefetched together enter the queue of their own miss, remembered page 1 the hot list
+  CHECK(prefetchPages(bm, prefetched, 2));
+  for (i = 0; i < 2; i++)
+    ASSERT_TRUE(waitForPage(bm, prefetched[i]), "page prefetched");
+  for (i = 40; i < 44; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_POOL("[42 0],[0 0],[1 0],[43 0]", bm, "hot pages survive the scan");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile(TESTPF));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// MRU policy registered by the test, it replaces the frame unpinned last
+#define RS_TEST_MRU 10
+
+static RC
+mruInit (BM_BufferPool *const bm, void *stratData, const BM_PoolOptions *options)
+{
+  BM_PoolInfo *bpInfo = (BM_PoolInfo *) bm->mgmtData;
+  bpInfo->policyData = calloc(1, sizeof(BM_PageFrame *));
+  return RC_OK;
+}
+
+static void
+mruShutdown (BM_BufferPool *const bm)
+{
+  free(((BM_PoolInfo *) bm->mgmtData)->policyData);
+}
+
+static void
+mruUnpin (BM_BufferPool *const bm, BM_PageFrame *frame)
+{
+  if (frame->fixCount == 0)
+    *(BM_PageFrame **) ((BM_PoolInfo *) bm->mgmtData)->policyData = frame;
+}
+
+static BM_PageFrame *
+mruPickVictim (BM_BufferPool *const bm, PageNumber pageNum)
+{
+  BM_PageFrame *frame = *(BM_PageFrame **) ((BM_PoolInfo *) bm->mgmtData)->policyData;
+  return (frame != NULL && frame->fixCount == 0) ? frame : NULL;
+}
+
+static const BM_ReplacementPolicy mruPolicy = {
+  .strategy = RS_TEST_MRU,
+  .name = "MRU",
+  .init = mruInit,
+  .shutdown = mruShutdown,
+  .pickVictim = mruPickVictim,
+  .onUnpin = mruUnpin
+};
+
+// test a replacement policy plugged in through registerReplacementPolicy
+void
+testCustomPolicy (void)
+{
+  // expected results
+  const char *poolContents[] = {
+    "[0 0],[-1 0],[-1 0]",
+    "[0 0],[1 0],[-1 0]",
+    "[0 0],[1 0],[2 0]",
+    "[0 0],[1 0],[3 0]",
+    "[0 0],[1 0],[4 0]",
+    "[0 0],[1 0],[4 0]",
+    "[5 0],[1 0],[4 0]"
+  };
+  const int requests[] = {0,1,2,3,4,0,5};
+  const int resident[] = {5,1,4};
+  BM_ReplacementPolicy other = mruPolicy;
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+
+  testName = "Testing a registered replacement policy";
+
+  CHECK(registerReplacementPolicy(&mruPolicy));
+  ASSERT_TRUE(findReplacementPolicy(RS_TEST_MRU) == &mruPolicy, "registered policy is found");
+  ASSERT_ERROR(registerReplacementPolicy(&mruPolicy), "id of the policy is taken now");
+  other.strategy = RS_LRU;
+  ASSERT_ERROR(registerReplacementPolicy(&other), "built in policies cannot be replaced");
+  other.strategy = BM_MAX_POLICIES;
+  ASSERT_ERROR(registerReplacementPolicy(&other), "id out of range");
+
+  CHECK(createPageFile(TESTPF));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPool(bm, TESTPF, 3, RS_TEST_MRU, NULL));
+
+  for (i = 0; i < 7; i++)
+    {
+      CHECK(pinPage(bm, h, requests[i]));
+      CHECK(unpinPage(bm, h));
+      ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+    }
+
+  // with every frame pinned the policy has no victim
+  BM_PageHandle *pinned = calloc(3, sizeof(BM_PageHandle));
+  for (i = 0; i < 3; i++)
+    CHECK(pinPage(bm, &pinned[i], resident[i]));
+  ASSERT_ERROR(pinPage(bm, h, 6), "all frames are pinned");
+  for (i = 0; i < 3; i++)
+    CHECK(unpinPage(bm, &pinned[i]));
+
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(6, getNumReadIO(bm), "check number of read I/Os");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile(TESTPF));
+  free(pinned);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+#define CONCURRENT_THREADS 4
+#define CONCURRENT_PAGES 40
+#define CONCURRENT_PINS 2000
+
+// state of a thread of testConcurrentPins
+typedef struct ConcurrentWorker {
+  BM_BufferPool *bm;
+  unsigned int seed;
+  int writes;
+  int errors;
+} ConcurrentWorker;
+
+// pin random pages, check them under a shared latch and count writes to them under an exclusive one
+static void *
+concurrentWorker (void *arg)
+{
+  ConcurrentWorker *w = (ConcurrentWorker *) arg;
+  BM_PageHandle h;
+  char prefix[32];
+  int i;
+
+  for (i = 0; i < CONCURRENT_PINS; i++)
+    {
+      int pageNum = rand_r(&w->seed) % CONCURRENT_PAGES;
+      bool write = (rand_r(&w->seed) % 4 == 0);
+      RC rc;
+      int length;
+
+      while ((rc = pinPage(w->bm, &h, pageNum)) == RC_WRITE_FAILED) // every frame pinned or latched by a flush
+        sched_yield();
+      if (rc != RC_OK || latchPage(w->bm, &h, write) != RC_OK)
+        {
+          w->errors++;
+          continue;
+        }
+
+      length = sprintf(prefix, "%s-%i", "Page", pageNum);
+      if (strncmp(h.data, prefix, length) != 0 || (h.data[length] != '\0' && h.data[length] != ' '))
+        w->errors++;
+      if (write)
+        {
+          int count = 0;
+          sscanf(h.data + length, "%i", &count);
+          sprintf(h.data, "%s %i", prefix, count + 1);
+          w->errors += (markDirty(w->bm, &h) != RC_OK);
+          w->writes++;
+        }
+
+      w->errors += (unlatchPage(w->bm, &h) != RC_OK);
+      if (i % 200 == 0)
+        w->errors += (forceFlushPool(w->bm) != RC_OK);
+      w->errors += (unpinPage(w->bm, &h) != RC_OK);
+    }
+  return NULL;
+}
+
+// pin the pages of one pool from several threads with every strategy, no write may get lost
+void
+testConcurrentPins (void)
+{
+  const ReplacementStrategy strategies[] = {RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LRU_K, RS_ARC, RS_2Q};
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options;
+  int s, i;
+
+  testName = "Testing concurrent pins of one pool";
+
+  // every strategy with a single partition, then with four, a background writer and read ahead
+  for (s = 0; s < 14; s++)
+    {
+      ConcurrentWorker workers[CONCURRENT_THREADS];
+      pthread_t threads[CONCURRENT_THREADS];
+      int writes = 0, errors = 0, counted = 0;
+      int *fixCounts;
+
+      CHECK(createPageFile(TESTPF));
+      createDummyPages(bm, CONCURRENT_PAGES);
+      memset(&options, 0, sizeof(options));
+      options.partitions = (s < 7) ? 1 : 4;
+      options.cleanPercent = (s < 7) ? 0 : 50;
+      options.writerIntervalMs = 1;
+      options.readAheadPages = (s < 7) ? 0 : 2;
+      CHECK(initBufferPoolWithOptions(bm, TESTPF, 8, strategies[s % 7], NULL, &options));
+
+      for (i = 0; i < CONCURRENT_THREADS; i++)
+        {
+          workers[i] = (ConcurrentWorker) {bm, (unsigned int) (s * CONCURRENT_THREADS + i + 1), 0, 0};
+          pthread_create(&threads[i], NULL, concurrentWorker, &workers[i]);
+        }
+      for (i = 0; i < CONCURRENT_THREADS; i++)
+        {
+          pthread_join(threads[i], NULL);
+          writes += workers[i].writes;
+          errors += workers[i].errors;
+        }
+      ASSERT_EQUALS_INT(0, errors, "pages found and intact in every thread");
+
+      fixCounts = getFixCounts(bm);
+      for (i = 0; i < 8; i++)
+        ASSERT_EQUALS_INT(0, fixCounts[i], "every pin was released");
+      free(fixCounts);
+      CHECK(shutdownBufferPool(bm));
+
+      // the counts written to the pages add up to the writes made
+      CHECK(initBufferPool(bm, TESTPF, 3, RS_FIFO, NULL));
+      for (i = 0; i < CONCURRENT_PAGES; i++)
+        {
+          int count = 0;
+          CHECK(pinPage(bm, h, i));
+          sscanf(h->data, "Page-%*i %i", &count);
+          counted += count;
+          CHECK(unpinPage(bm, h));
+        }
+      ASSERT_EQUALS_INT(writes, counted, "no write was lost");
+      CHECK(shutdownBufferPool(bm));
+      CHECK(destroyPageFile(TESTPF));
+    }
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// split a pool into partitions, the statistics still cover the whole pool
+void
+testPartitionedPool (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options;
+  PageNumber *frameContents;
+  bool *dirtyFlags;
+  int *fixCounts;
+  int seen[30] = {0};
+  int i, cached = 0;
+  char expected[32];
+
+  testName = "Testing a partitioned buffer pool";
+
+  CHECK(createPageFile(TESTPF));
+  createDummyPages(bm, 30);
+
+  memset(&options, 0, sizeof(options));
+  options.partitions = 13;
+  ASSERT_ERROR(initBufferPoolWithOptions(bm, TESTPF, 12, RS_LRU, NULL, &options), "more partitions than frames");
+  options.partitions = 3;
+  CHECK(initBufferPoolWithOptions(bm, TESTPF, 12, RS_LRU, NULL, &options));
+
+  for (i = 0; i < 30; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", "Page", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "page read into its partition");
+      if (i % 2 == 0)
+        CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_INT(30, getNumReadIO(bm), "reads of all partitions are counted");
+
+  // a page is held by one frame of one partition, and pinning it again is a hit
+  frameContents = getFrameContents(bm);
+  dirtyFlags = getDirtyFlags(bm);
+  fixCounts = getFixCounts(bm);
+  for (i = 0; i < 12; i++)
+    {
+      ASSERT_EQUALS_INT(0, fixCounts[i], "frames of every partition are unpinned");
+      if (frameContents[i] == NO_PAGE)
+        continue;
+      ASSERT_TRUE(seen[frameContents[i]]++ == 0, "page held by a single frame");
+      ASSERT_TRUE(dirtyFlags[i] == (frameContents[i] % 2 == 0), "dirty flag of the page");
+      CHECK(pinPage(bm, h, frameContents[i]));
+      CHECK(unpinPage(bm, h));
+      cached++;
+    }
+  ASSERT_TRUE(cached > 0, "partitions hold pages");
+  ASSERT_EQUALS_INT(30, getNumReadIO(bm), "pages in a partition are not read again");
+  free(frameContents);
+  free(dirtyFlags);
+  free(fixCounts);
+
+  // pages written back on replacement and by the flush add up to the pages marked dirty
+  CHECK(forceFlushPool(bm));
+  ASSERT_EQUALS_INT(15, getNumWriteIO(bm), "writes of all partitions are counted");
+  dirtyFlags = getDirtyFlags(bm);
+  for (i = 0; i < 12; i++)
+    ASSERT_TRUE(!dirtyFlags[i], "flush covers every partition");
+  free(dirtyFlags);
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile(TESTPF));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// count the dirty frames of a pool
+static int
+countDirty (BM_BufferPool *bm)
+{
+  bool *dirtyFlags = getDirtyFlags(bm);
+  int i, dirty = 0;
+
+  for (i = 0; i < bm->numPages; i++)
+    dirty += dirtyFlags[i];
+  free(dirtyFlags);
+  return dirty;
+}
+
+// wait up to two seconds for the background writer to leave the given number of dirty frames and finish its writes
+static int
+waitForDirty (BM_BufferPool *bm, int dirty, int writes)
+{
+  int i;
+
+  for (i = 0; i < 2000 && (countDirty(bm) != dirty || getNumWriteIO(bm) != writes); i++)
+    usleep(1000);
+  return countDirty(bm);
+}
+
+// dirty the first num pages of the file and unpin them again
+static void
+dirtyPages (BM_BufferPool *bm, BM_PageHandle *h, int num)
+{
+  int i;
+
+  for (i = 0; i < num; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+    }
+}
+
+// a background writer cleans frames ahead of their replacement, within its rate limit
+void
+testBackgroundWriter (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options;
+  int i;
+
+  testName = "Testing the background writer";
+
+  CHECK(createPageFile(TESTPF));
+  createDummyPages(bm, 10);
+
+  memset(&options, 0, sizeof(options));
+  options.cleanPercent = 101;
+  ASSERT_ERROR(initBufferPoolWithOptions(bm, TESTPF, 4, RS_FIFO, NULL, &options), "clean target above 100 percent");
+
+  // all unpinned frames are kept clean, the misses that follow write nothing back themselves
+  options.cleanPercent = 100;
+  options.writerIntervalMs = 1;
+  CHECK(initBufferPoolWithOptions(bm, TESTPF, 4, RS_FIFO, NULL, &options));
+  dirtyPages(bm, h, 4);
+  ASSERT_EQUALS_INT(0, waitForDirty(bm, 0, 4), "writer cleaned every frame");
+  ASSERT_EQUALS_INT(4, getNumWriteIO(bm), "each dirty page written once");
+  for (i = 4; i < 8; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_INT(0, getNumDirtyVictims(bm), "no miss waited for a write back");
+  CHECK(shutdownBufferPool(bm));
+
+  // with a long interval the writer only runs when a miss wakes it, and then writes no more than its limit
+  options.writerIntervalMs = 60000;
+  options.writerMaxPages = 3;
+  CHECK(initBufferPoolWithOptions(bm, TESTPF, 6, RS_FIFO, NULL, &options));
+  dirtyPages(bm, h, 6);
+  ASSERT_EQUALS_INT(6, countDirty(bm), "writer waits for its interval");
+  CHECK(pinPage(bm, h, 6));
+  ASSERT_EQUALS_INT(1, getNumDirtyVictims(bm), "miss wrote back its dirty victim");
+  ASSERT_EQUALS_INT(2, waitForDirty(bm, 2, 4), "writer woken by the miss");
+  usleep(20000);
+  ASSERT_EQUALS_INT(2, countDirty(bm), "writer stays within its limit");
+  ASSERT_EQUALS_INT(4, getNumWriteIO(bm), "victim and three pages of the writer written");
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+
+  // the pages written by the writer hold their data
+  CHECK(initBufferPool(bm, TESTPF, 3, RS_FIFO, NULL));
+  for (i = 0; i < 10; i++)
+    {
+      char expected[32];
+      sprintf(expected, "%s-%i", "Page", i);
+      CHECK(pinPage(bm, h, i));
+      ASSERT_EQUALS_STRING(expected, h->data, "page written intact");
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile(TESTPF));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// wait up to two seconds for a page to get into the pool, returns whether it did
+static bool
+waitForPage (BM_BufferPool *bm, PageNumber pageNum)
+{
+  int i, j;
+
+  for (i = 0; i < 2000; i++)
+    {
+      PageNumber *frameContents = getFrameContents(bm);
+      bool found = false;
+
+      for (j = 0; j < bm->numPages; j++)
+        found |= (frameContents[j] == pageNum);
+      free(frameContents);
+      if (found)
+        return true;
+      usleep(1000);
+    }
+  return false;
+}
+
+// a sequential scan finds its next pages read ahead into the pool, unpinned
+void
+testReadAhead (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options;
+  PageNumber *frameContents;
+  int *fixCounts;
+  char expected[32];
+  int i;
+
+  testName = "Testing read ahead of sequential scans";
+
+  CHECK(createPageFile(TESTPF));
+  createDummyPages(bm, 40);
+
+  memset(&options, 0, sizeof(options));
+  options.readAheadPages = -1;
+  ASSERT_ERROR(initBufferPoolWithOptions(bm, TESTPF, 32, RS_FIFO, NULL, &options), "negative read ahead");
+
+  // the second page of a scan queues the first window
+  options.readAheadPages = 8;
+  CHECK(initBufferPoolWithOptions(bm, TESTPF, 32, RS_FIFO, NULL, &options));
+  for (i = 0; i < 2; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_TRUE(waitForPage(bm, 3), "window read ahead");
+  frameContents = getFrameContents(bm);
+  fixCounts = getFixCounts(bm);
+  for (i = 0; i < 4; i++)
+    {
+      ASSERT_EQUALS_INT(i, frameContents[i], "page read in scan order");
+      ASSERT_EQUALS_INT(0, fixCounts[i], "page read ahead is not pinned");
+    }
+  ASSERT_EQUALS_INT(NO_PAGE, frameContents[4], "no more than the first window");
+  free(frameContents);
+  free(fixCounts);
+
+  // every later page of the scan is in the pool before it is pinned, and nothing past the end of the file is read
+  for (i = 2; i < 40; i++)
+    {
+      ASSERT_TRUE(waitForPage(bm, i), "page read ahead of the scan");
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", "Page", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "page read ahead intact");
+      CHECK(unpinPage(bm, h));
+    }
+  usleep(20000);
+  ASSERT_EQUALS_INT(38, getNumPrefetchIO(bm), "all pages after the first two read ahead");
+  ASSERT_EQUALS_INT(40, getNumReadIO(bm), "each page read once");
+
+  // pins out of order read nothing ahead
+  CHECK(pinPage(bm, h, 5));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 2));
+  CHECK(unpinPage(bm, h));
+  usleep(20000);
+  ASSERT_EQUALS_INT(38, getNumPrefetchIO(bm), "no read ahead without a scan");
+  CHECK(shutdownBufferPool(bm));
+
+  // pages are only read ahead into free or clean frames
+  CHECK(initBufferPoolWithOptions(bm, TESTPF, 4, RS_FIFO, NULL, &options));
+  for (i = 20; i < 40; i += 5)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(pinPage(bm, h, 0));
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 1));
+  usleep(20000);
+  ASSERT_EQUALS_INT(0, getNumPrefetchIO(bm), "dirty frames are not taken");
+  ASSERT_EQUALS_INT(2, getNumWriteIO(bm), "only the victims of the pins written");
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile(TESTPF));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// pages named by the caller are loaded into the pool ahead of their pins, unpinned
+void
+testPrefetchPages (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  const PageNumber pages[] = {15, 3, 9, 3, 100};
+  const PageNumber negative[] = {2, -1};
+  const PageNumber unordered[] = {12, 10, 12, 11, 10};
+  int *fixCounts;
+  char expected[32];
+  int i;
+
+  testName = "Testing prefetching of given pages";
+
+  CHECK(createPageFile(TESTPF));
+  createDummyPages(bm, 20);
+  CHECK(initBufferPool(bm, TESTPF, 8, RS_FIFO, NULL));
+
+  ASSERT_ERROR(prefetchPages(bm, NULL, 2), "no pages given");
+  ASSERT_ERROR(prefetchPages(bm, negative, 2), "negative page number");
+  CHECK(prefetchPages(bm, pages, 0));
+
+  // the pages are loaded once each, page 100 is past the end of the file and skipped
+  CHECK(prefetchPages(bm, pages, 5));
+  for (i = 0; i < 3; i++)
+    ASSERT_TRUE(waitForPage(bm, pages[i]), "page prefetched");
+  usleep(20000);
+  ASSERT_EQUALS_INT(3, getNumPrefetchIO(bm), "each page read once");
+  ASSERT_EQUALS_INT(3, getNumReadIO(bm), "nothing read past the end of the file");
+  fixCounts = getFixCounts(bm);
+  for (i = 0; i < 8; i++)
+    ASSERT_EQUALS_INT(0, fixCounts[i], "prefetched pages are not pinned");
+  free(fixCounts);
+
+  // their pins find them in the pool
+  for (i = 0; i < 3; i++)
+    {
+      CHECK(pinPage(bm, h, pages[i]));
+      sprintf(expected, "%s-%i", "Page", pages[i]);
+      ASSERT_EQUALS_STRING(expected, h->data, "prefetched page intact");
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_INT(3, getNumReadIO(bm), "pins of prefetched pages read nothing");
+
+  // a pool without read ahead does not read ahead of scans once it prefetched
+  for (i = 4; i < 8; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+  usleep(20000);
+  ASSERT_EQUALS_INT(3, getNumPrefetchIO(bm), "no read ahead of the scan");
+
+  // pages given out of order and more than once are each read once
+  CHECK(prefetchPages(bm, unordered, 5));
+  for (i = 10; i < 13; i++)
+    ASSERT_TRUE(waitForPage(bm, i), "page prefetched");
+  usleep(20000);
+  ASSERT_EQUALS_INT(6, getNumPrefetchIO(bm), "each page read once");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile(TESTPF));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// a pool on a file of pages larger than PAGE_SIZE dumps whole pages
+void
+testLargePageDump (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  int pageSize = 4 * PAGE_SIZE;
+  char *dump;
+
+  testName = "Testing dumps of large pages";
+
+  CHECK(createPageFileWithPageSize(TESTPF, pageSize));
+  CHECK(initBufferPool(bm, TESTPF, 2, RS_FIFO, NULL));
+  ASSERT_EQUALS_INT(pageSize, bm->pageSize, "pool takes the page size of the file");
+
+  CHECK(pinPage(bm, h, 0));
+  memset(h->data, 0, pageSize);
+  h->data[pageSize - 1] = (char) 0xAB;
+  dump = sprintPoolPageContent(bm, h);
+  ASSERT_EQUALS_INT(9 + 2 * pageSize + pageSize / 8 + pageSize / 64, (int) strlen(dump), "every byte of the page dumped");
+  ASSERT_EQUALS_STRING("AB \n", dump + strlen(dump) - 4, "last byte of the page dumped");
+  free(dump);
+  CHECK(unpinPage(bm, h));
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile(TESTPF));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
@@ -9,4 +9,8 @@ void printPageContent (BM_PageHandle *const page);
 char *sprintPoolContent (BM_BufferPool *const bm);
 char *sprintPageContent (BM_PageHandle *const page);
 
+// page dumps of the page size of the pool, the ones above dump PAGE_SIZE bytes of a page of any size
+void printPoolPageContent (BM_BufferPool *const bm, BM_PageHandle *const page);
+char *sprintPoolPageContent (BM_BufferPool *const bm, BM_PageHandle *const page);
+
 #endif
@@ -0,0 +1,66 @@
+#ifndef LOG_MGR_H
+#define LOG_MGR_H
+
+#include "dberror.h"
+#include <stdio.h>
+
+/* log levels, a message is written when its level is at least the runtime level set with setLogLevel */
+#define LOG_LEVEL_TRACE 0 // every page read and every buffer pool lookup
+#define LOG_LEVEL_DEBUG 1 // replacement decisions and other per operation details
+#define LOG_LEVEL_INFO 2  // opening and closing of files, pools and tables
+#define LOG_LEVEL_WARN 3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF 5
+
+/* messages below this level are removed by the preprocessor, their arguments are not even evaluated.
+ * Build with -DLOG_COMPILE_LEVEL=LOG_LEVEL_TRACE to get the per page messages back */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_MESSAGE_SIZE 256        // longer messages are cut, including the level and source prefix
+#define LOG_DEFAULT_RING_SIZE 4096  // messages the ring of the asynchronous sink holds
+
+#define LOG_AT(level, ...) \
+	do { if ((level) >= logLevel) logMessage((level), __FILE__, __LINE__, __VA_ARGS__); } while (0)
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(...) LOG_AT(LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+/* runtime level, read without a lock on every message that survived compilation */
+extern volatile int logLevel;
+
+/* logging */
+extern void setLogLevel (int level);
+extern void logMessage (int level, const char *file, int line, const char *format, ...)
+	__attribute__((format(printf, 4, 5)));
+
+/* sinks, messages go straight to stderr unless the asynchronous sink is running */
+extern RC startAsyncLogging (FILE *out, int ringSize);
+extern RC stopAsyncLogging (void);
+extern long long getDroppedLogMessages (void);
+
+#endif
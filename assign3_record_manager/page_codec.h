@@ -0,0 +1,29 @@
+#ifndef PAGE_CODEC_H
+#define PAGE_CODEC_H
+
+#include "dberror.h"
+
+/* codec ids stored in the header of a compressed page file */
+#define SM_CODEC_NONE 0 // pages are stored as they are
+#define SM_CODEC_LZ 1   // built in LZ77 codec, fast and good at the repetitive text of serialized records
+#define SM_MAX_CODECS 16
+
+/**
+ * A page compression codec. Codecs other than the built in ones are registered with registerPageCodec
+ * before a page file using them is created or opened.
+ */
+typedef struct SM_PageCodec
+{
+	int id;           // stored in the page file header, 1 to SM_MAX_CODECS - 1
+	const char *name;
+	// compresses srcLength bytes into dst, returns the compressed length or -1 when it does not fit into dstCapacity bytes
+	int (*compress) (const char *src, int srcLength, char *dst, int dstCapacity);
+	// decompresses srcLength bytes into dst, returns the number of bytes produced or -1 for malformed input
+	int (*decompress) (const char *src, int srcLength, char *dst, int dstCapacity);
+} SM_PageCodec;
+
+/* codec registry */
+extern RC registerPageCodec (const SM_PageCodec *codec);
+extern const SM_PageCodec *findPageCodec (int id);
+
+#endif
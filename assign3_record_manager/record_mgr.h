@@ -4,6 +4,7 @@
 #include "dberror.h"
 #include "expr.h"
 #include "tables.h"
+#include "storage_mgr.h"
 
 // Bookkeeping for scans
 typedef struct RM_ScanHandle
@@ -32,6 +33,17 @@ typedef struct RecordNode {
 	struct RecordNode *next;
 }RecordNode;
 
+#define RM_DEFAULT_READ_AHEAD_PAGES 16 // the buffer pool of a table holds 100 frames
+
+// Settings for initRecordManager, passed as its mgmtData. NULL keeps the defaults
+typedef struct RM_Options {
+	int pageSize; // page size of the tables created from now on, 0 for PAGE_SIZE
+	SM_SyncPolicy syncPolicy; // durability of the tables opened from now on, SM_SYNC_NONE by default
+	int segmentPages; // tables created from now on are split into segment files of this many pages, 0 for a single file
+	int codec; // codec compressing the pages of the tables created from now on, SM_CODEC_NONE by default
+	int readAheadPages; // most pages scans of the tables opened from now on read ahead, 0 for RM_DEFAULT_READ_AHEAD_PAGES, -1 for none
+} RM_Options;
+
 
 // table and manager
 extern RC initRecordManager (void *mgmtData);
@@ -2,6 +2,8 @@
 #define STORAGE_MGR_H
 
 #include "dberror.h"
+#include <sys/types.h>
+#include <pthread.h>
 
 /************************************************************
  *                    handle data structures                *
@@ -10,18 +12,188 @@ typedef struct SM_FileHandle {
 	char *fileName;
 	int totalNumPages;
 	int curPagePos;
+	int pageSize; // size of the pages of the file, read from its header
 	void *mgmtInfo;
 } SM_FileHandle;
 
 typedef char* SM_PageHandle;
 
+/* page file header, written by createPageFile in front of the first page */
+#define SM_FILE_HEADER_SIZE 4096
+#define SM_MIN_PAGE_SIZE 4096  // page sizes are powers of two in this range, so pages stay aligned for direct I/O
+#define SM_MAX_PAGE_SIZE 65536
+
+/* a segmented page file is split into files of segmentPages pages named fileName, fileName.1, fileName.2, ...
+ * the header and the pages up to the first boundary are in fileName, every page is in exactly one segment */
+
+/* a compressed page file packs its pages into slots of whole sectors behind the header, the page map file
+ * fileName.map tells where the slot of each page is and how long the compressed page is */
+#define SM_SLOT_SECTOR_SIZE 512
+
+/**
+ * Layout of a new page file, given to createPageFileWithOptions. A zeroed structure asks for the defaults.
+ */
+typedef struct SM_CreateOptions
+{
+	int pageSize;     // 0 for PAGE_SIZE
+	int segmentPages; // pages held by each segment file, 0 for a single file
+	int codec;        // SM_CODEC_* id of page_codec.h compressing the pages, SM_CODEC_NONE (0) to store them as they are.
+	                  // A compressed page file is a single file without free page bitmaps
+} SM_CreateOptions;
+
+/* flags for openPageFileWithFlags */
+#define SM_OPEN_MAPPED 0x1 // serve blocks out of a shared mapping of the file, not available for segmented or compressed page files
+#define SM_OPEN_DIRECT 0x2 // bypass the kernel page cache with O_DIRECT, cannot be combined with SM_OPEN_MAPPED, not available for compressed page files
+
+/* alignment of buffers for direct I/O, unaligned buffers are copied through an aligned one */
+#define SM_DIRECT_IO_ALIGNMENT 4096
+
+/* address space reserved for a mapped page file, the mapping grows inside it so block pointers stay valid */
+#define SM_MAP_RESERVE_SIZE ((size_t)1 << 34)
+
+/* default extent policy, the file grows by its own size within these bounds */
+#define SM_DEFAULT_MIN_EXTENT_PAGES 16
+#define SM_DEFAULT_MAX_EXTENT_PAGES 16384
+#define SM_DEFAULT_GROWTH_PERCENT 100
+
+/**
+ * Describes how a page file grows. Each new extent is growthPercent of the space already allocated,
+ * clamped to [minExtentPages, maxExtentPages], and is reserved with a single fallocate call.
+ */
+typedef struct SM_ExtentPolicy
+{
+	int minExtentPages;
+	int maxExtentPages;
+	int growthPercent;
+} SM_ExtentPolicy;
+
+/* asynchronous I/O engine settings */
+#define SM_ASYNC_QUEUE_DEPTH 64 // requests a file can have in flight on the io_uring backend
+#define SM_ASYNC_WORKERS 4      // threads of the worker pool backend
+
+/**
+ * Result of an asynchronous block read or write, returned by pollCompletions
+ */
+typedef struct SM_IOCompletion
+{
+	void *userData; // value passed to submitReadBlock/submitWriteBlock
+	int pageNum;
+	int isWrite;
+	RC rc; // RC_OK or the error readBlock/writeBlock would have returned
+} SM_IOCompletion;
+
+/**
+ * When writes to a page file are made durable
+ */
+typedef enum SM_SyncMode
+{
+	SM_SYNC_NONE = 0,      // the kernel writes pages back when it wants, only syncPageFile waits for the disk
+	SM_SYNC_PER_WRITE = 1, // every write is followed by fdatasync before it returns
+	SM_SYNC_GROUP = 2      // a background thread syncs the writes of a group together
+} SM_SyncMode;
+
+/**
+ * Sync policy of a page file, set with setSyncPolicy. A zeroed policy is SM_SYNC_NONE.
+ */
+typedef struct SM_SyncPolicy
+{
+	SM_SyncMode mode;
+	int groupIntervalMs; // SM_SYNC_GROUP: longest time a write stays unsynced
+	int groupWrites;     // SM_SYNC_GROUP: number of writes that start a sync before the interval ends, 0 for no limit
+} SM_SyncPolicy;
+
+/* access pattern detection, reads of adjacent pages turn on readahead and reads scattered over the file turn it off */
+#define SM_SEQUENTIAL_THRESHOLD 4  // adjacent pages read in a row before a file is treated as scanned sequentially
+#define SM_RANDOM_THRESHOLD 4      // non adjacent reads in a row before a file is treated as accessed randomly
+#define SM_MIN_READAHEAD_PAGES 4   // first readahead window of a sequential scan, each further window doubles
+#define SM_MAX_READAHEAD_PAGES 256
+
+/**
+ * Access pattern of an open page file, passed on to the kernel as its readahead advice
+ */
+typedef enum SM_AccessPattern
+{
+	SM_ACCESS_NORMAL = 0,     // nothing known yet, the kernel uses its default readahead
+	SM_ACCESS_SEQUENTIAL = 1, // pages are read in order, the pages ahead are announced before they are read
+	SM_ACCESS_RANDOM = 2      // pages are read in no order, the kernel does no readahead
+} SM_AccessPattern;
+
+/**
+ * Recent reads of an open page file
+ */
+typedef struct SM_AccessTracker
+{
+	int lastPage;      // last page read, -1 before the first read
+	int sequentialRun; // adjacent pages read in a row up to lastPage
+	int randomRun;     // non adjacent reads in a row
+	SM_AccessPattern pattern;
+	int readaheadEnd;   // pages before this one have been announced to the kernel
+	int readaheadPages; // size of the next readahead window
+	pthread_mutex_t lock; // a read finding it held by a concurrent read leaves the tracker as it is
+} SM_AccessTracker;
+
+/* latency histograms have log2 buckets, bucket i counts calls that took [2^i, 2^(i+1)) nanoseconds */
+#define SM_LATENCY_BUCKETS 32
+
+/**
+ * I/O statistics of an open page file, returned by getFileStats
+ */
+typedef struct SM_FileStats
+{
+	long long reads;        // pages read, by any read call or asynchronous request
+	long long writes;       // pages written
+	long long bytesRead;
+	long long bytesWritten;
+	long long syscalls;     // system calls issued for I/O and file growth
+	long long extends;      // times the file was grown
+	long long syncs;        // fdatasync calls made for the sync policy or syncPageFile
+	long long readaheadHints; // readahead windows announced to the kernel during sequential reads
+	long long readLatency[SM_LATENCY_BUCKETS];  // latencies of readBlock
+	long long writeLatency[SM_LATENCY_BUCKETS]; // latencies of writeBlock
+} SM_FileStats;
+
+/**
+ * Contains information about an open page file. The descriptor is opened once
+ * in openPageFile and kept until closePageFile, all block I/O is positional.
+ */
+typedef struct SM_FileInfo
+{
+	int fd;
+	int flags;
+	int pageSize;
+	off_t dataOffset;  // file offset of the first page, 0 for a file written before page files had a header
+	char *mapBase;     // start of the file mapping, NULL unless opened with SM_OPEN_MAPPED
+	size_t mapLength;  // number of bytes of the file currently mapped
+	size_t mapReserve; // number of bytes of address space reserved for the mapping
+	int allocatedPages; // number of pages reserved on disk and held by the file while it is open, at least totalNumPages
+	int pagesPerMap;    // pages covered by each free page bitmap, 0 for a file without free page bitmaps
+	char **freeMaps;    // free page bitmaps loaded so far, a set bit marks a free page
+	int numFreeMaps;
+	int numFreePages;
+	SM_ExtentPolicy extentPolicy;
+	struct SM_AsyncEngine *asyncEngine; // created by the first asynchronous request
+	SM_FileStats stats;
+	SM_SyncPolicy syncPolicy;
+	struct SM_Syncer *syncer; // background thread of SM_SYNC_GROUP
+	int segmentPages;         // pages held by each segment file, 0 when the page file is a single file
+	struct SM_SegmentTable *segments; // open segment files, NULL when the page file is a single file
+	const struct SM_PageCodec *codec; // compresses the pages, NULL for a page file storing them as they are
+	struct SM_PageMap *pageMap;       // slots of the pages of a compressed page file
+	SM_AccessTracker access;          // access pattern of the reads, see readBlock
+} SM_FileInfo;
+
 /************************************************************
  *                    interface                             *
  ************************************************************/
 /* manipulating page files */
 extern void initStorageManager (void);
 extern RC createPageFile (char *fileName);
+extern RC createPageFileWithPageSize (char *fileName, int pageSize);
+extern RC createSegmentedPageFile (char *fileName, int pageSize, int segmentPages);
+extern RC createPageFileWithOptions (char *fileName, const SM_CreateOptions *options);
 extern RC openPageFile (char *fileName, SM_FileHandle *fHandle);
+extern RC openPageFileWithFlags (char *fileName, SM_FileHandle *fHandle, int flags);
+extern RC openPageFileMapped (char *fileName, SM_FileHandle *fHandle);
 extern RC closePageFile (SM_FileHandle *fHandle);
 extern RC destroyPageFile (char *fileName);
 
@@ -33,11 +205,37 @@ extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC mapBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle *memPage);
+extern RC readBlocks (int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle memPages[]);
+extern SM_AccessPattern getAccessPattern (SM_FileHandle *fHandle);
 
 /* writing blocks to a page file */
 extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC writeBlocks (int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle memPages[]);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
+extern RC setExtentPolicy (SM_FileHandle *fHandle, const SM_ExtentPolicy *policy);
+
+/* allocating and freeing pages */
+extern RC allocatePage (SM_FileHandle *fHandle, int *pageNum);
+extern RC freePage (int pageNum, SM_FileHandle *fHandle, int punchHole);
+
+/* page buffers */
+extern SM_PageHandle allocPageBuffer (int numPages, int pageSize);
+
+/* durability */
+extern RC setSyncPolicy (SM_FileHandle *fHandle, const SM_SyncPolicy *policy);
+extern RC syncPageFile (SM_FileHandle *fHandle);
+
+/* I/O statistics */
+extern RC getFileStats (SM_FileHandle *fHandle, SM_FileStats *stats);
+extern RC resetFileStats (SM_FileHandle *fHandle);
+extern long long getLatencyPercentile (const long long histogram[SM_LATENCY_BUCKETS], double percentile);
+
+/* asynchronous block I/O */
+extern RC submitReadBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage, void *userData);
+extern RC submitWriteBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage, void *userData);
+extern int pollCompletions (SM_FileHandle *fHandle, SM_IOCompletion *completions, int maxCompletions, int minCompletions);
 
 #endif
@@ -7,58 +7,232 @@
 // Include bool DT
 #include "dt.h"
 
+// Include page file handle
+#include "storage_mgr.h"
+
+#include <pthread.h>
+
 // Replacement Strategies
 typedef enum ReplacementStrategy {
 	RS_FIFO = 0,
 	RS_LRU = 1,
 	RS_CLOCK = 2,
 	RS_LFU = 3,
-	RS_LRU_K = 4
+	RS_LRU_K = 4,
+	RS_ARC = 5,
+	RS_2Q = 6
 } ReplacementStrategy;
 
 // Data Types and Structures
 typedef int PageNumber;
 #define NO_PAGE -1
 
+#define BM_LRU_K_DEFAULT_K 1 // K of an RS_LRU_K pool whose stratData is NULL, LRU-1 replaces like LRU
+#define BM_WRITER_DEFAULT_INTERVAL_MS 10 // rounds of the background writer when BM_PoolOptions.writerIntervalMs is 0
+#define BM_READ_AHEAD_INITIAL_WINDOW 2   // pages read ahead once a sequential scan is found, doubled while it goes on
+
 typedef struct BM_BufferPool {
 	char *pageFile;
 	int numPages;
 	ReplacementStrategy strategy;
+	int pageSize; // size of the pages of pageFile, read from its header
 	void *mgmtData; // use this one to store the bookkeeping info your buffer
 	// manager needs for a buffer pool
 } BM_BufferPool;
 
+/**
+ * Optional settings for initBufferPoolWithOptions, a zeroed struct gives the defaults of initBufferPool
+ */
+typedef struct BM_PoolOptions {
+	int openFlags; // SM_OPEN_* flags used to open the page file, SM_OPEN_MAPPED serves frames straight from the mapping,
+	               // SM_OPEN_DIRECT keeps pages cached only in the frames
+	SM_SyncPolicy syncPolicy; // when pages written by the pool become durable, see setSyncPolicy
+	int correlatedPeriod; // RS_LRU_K: pins of a page within this many pins of the pool after its last one
+	                      // count as one reference, 0 makes every pin a reference of its own
+	int retainedPages;    // RS_LRU_K: evicted pages whose history is kept, 0 keeps as many as the pool has frames
+	int agingPeriod;      // RS_LFU: pins after which every reference count is halved, 0 never ages the counts
+	int recentPages;      // RS_2Q: frames kept by pages seen once before their frames are taken, 0 for a quarter of the pool
+	int ghostPages;       // RS_2Q: evicted pages remembered, 0 for half the pool
+	int partitions;       // partitions the frames are split into by a hash of the page number, each with its own page
+	                      // table, replacement state and latch; 0 or 1 for a single one
+	int cleanPercent;     // share of the unpinned frames of each partition a background writer keeps clean by writing
+	                      // dirty pages ahead of their replacement, 0 for no background writer
+	int writerIntervalMs; // background writer: time between its rounds, 0 for BM_WRITER_DEFAULT_INTERVAL_MS
+	int writerMaxPages;   // background writer: pages it writes per interval at most, 0 for no limit
+	int readAheadPages;   // most pages a background loader reads ahead of a sequential scan at once, capped at a
+	                      // quarter of the frames; 0 for no read ahead
+} BM_PoolOptions;
+
 typedef struct BM_PageHandle {
 	PageNumber pageNum;
 	char *data;
 } BM_PageHandle;
 
+/**
+ * LFU: frames with the same reference count, in the order they reached it. The buckets of a pool form a list
+ * ordered by count, so counting a reference and finding a victim do not depend on the number of frames.
+ */
+typedef struct BM_FrequencyBucket
+{
+    int frequency;
+    struct BM_PageFrame *first; // frame that reached the count first, the next victim of the bucket
+    struct BM_PageFrame *last;
+    struct BM_FrequencyBucket *previous; // bucket of the next lower count
+    struct BM_FrequencyBucket *next;
+} BM_FrequencyBucket;
+
 typedef struct BM_PageFrame
 {
     char *data;
     int frameNumber;
     int pageNumber;
-    int fixCount;
+    int fixCount;    // changed with atomic operations, a pin taken for forcePage or latchPage is dropped without the table latch
     bool isDirty;
+    bool loading;    // the page is being read, pins of it wait on pageLoaded of the pool
+    pthread_rwlock_t latch; // shared by readers of the page and exclusive for its writers, see latchPage; held
+                            // exclusively while the frame is filled and shared while it is flushed
+    bool referenced; // CLOCK: used since the hand last passed the frame
     int timeStamp;
+    long *history;      // LRU-K: times of the last K uncorrelated references to the page, most recent first, 0 if unknown
+    long lastReference; // LRU-K: time of the last pin of the page, correlated or not
+    BM_FrequencyBucket *bucket;           // LFU: bucket of the reference count of the page, NULL for an empty frame
+    struct BM_PageFrame *previousInBucket; // LFU: neighbours in the bucket
+    struct BM_PageFrame *nextInBucket;
     struct BM_PageFrame *previousFrame;
     struct BM_PageFrame *nextFrame;
+    int entryList; // ARC, 2Q: list the page being loaded enters, chosen on its miss
+    int ghostList; // ARC, 2Q: ghost list the page the frame held goes to on its eviction, -1 to forget it, chosen on the same miss
 } BM_PageFrame;
 
+/**
+ * Open addressing hash table from the page numbers in a pool to their frames, with linear probing.
+ * It has at least twice as many slots as the pool has frames, so probe sequences stay short.
+ */
+typedef struct BM_PageTable
+{
+    PageNumber *pages; // page of each slot, NO_PAGE for an empty slot
+    int *frames;       // frame number of the page of each slot, or its entry number in the retained LRU-K histories
+    int mask;          // number of slots minus one, the number of slots is a power of two
+} BM_PageTable;
+
+/**
+ * LRU-K history of a page that was evicted, so a page coming back soon is not treated like one never seen
+ */
+typedef struct BM_RetainedHistory
+{
+    PageNumber pageNum; // NO_PAGE for an unused entry
+    long lastReference;
+    long *history;
+} BM_RetainedHistory;
+
+/* lists of ARC and 2Q, most recently used first */
+#define BM_LIST_RECENT 0          // ARC T1, 2Q A1in: pages referenced once since they entered the pool
+#define BM_LIST_FREQUENT 1        // ARC T2, 2Q Am: pages referenced again while in the pool or soon after leaving it
+#define BM_LIST_RECENT_GHOSTS 2   // ARC B1, 2Q A1out: pages evicted from the recent list
+#define BM_LIST_FREQUENT_GHOSTS 3 // ARC B2: pages evicted from the frequent list
+#define BM_LIST_FREE 4            // ghost entries not in use
+#define BM_NUM_LISTS 5
+
+/**
+ * ARC and 2Q: entry of one of the lists, linked through entry numbers. Entry i belongs to frame i, the entries
+ * after the frames remember evicted pages (ghosts).
+ */
+typedef struct BM_ListEntry
+{
+    PageNumber pageNum;
+    int list;     // list holding the entry, -1 for none
+    int previous; // more recently used neighbour, -1 at the head
+    int next;
+} BM_ListEntry;
+
+typedef struct BM_List
+{
+    int head; // -1 for an empty list
+    int tail;
+    int length;
+} BM_List;
+
 /**
  * Contains bufferpool information
  */
 typedef struct BM_PoolInfo
 {
-    BM_PageFrame *bufferPool;
-    BM_PageFrame *head;
-    BM_PageFrame *tail;
-    BM_PageFrame *begin;
+    BM_PageFrame *bufferPool;       // frames of the pool, NULL for a partitioned pool, whose partitions hold them
+    struct BM_PoolInfo *io;         // pool holding the page file: the pool itself, or the partitioned pool of a partition
+    struct BM_BufferPool *partitions; // partitions of a partitioned pool, each with a BM_PoolInfo of its own, NULL if not partitioned
+    int numPartitions;
+    pthread_mutex_t tableLatch; // guards the page table, the pages given to frames and their dirty flags, the empty frames and the state of the policy
+    pthread_cond_t pageLoaded;  // broadcast with the table latch held when a frame is no longer loading
+    pthread_rwlock_t ioLatch;   // shared by page reads and writes on fileHandle, exclusive while the file grows, see latchIO; used through io
+    int *skippedFrames;         // latched frames a victim search passed over
+    const struct BM_ReplacementPolicy *policy; // decides which frame is replaced, see BM_ReplacementPolicy
+    void *policyData;                          // state of a policy registered with registerReplacementPolicy
+    int *emptyFrames;       // frames left empty by a page that could not be read, filled before any frame is replaced
+    int numEmpty;
+    BM_PageFrame *hand;     // next frame FIFO and CLOCK look at for a victim, it goes round the frames in order
+    BM_PageTable pageTable; // finds the frame holding a page, kept up to date whenever a frame gets another page
+    BM_PageTable incomingTable; // pages read while the dirty victim they replace is written back, see claimFrame
+    char **spareData;           // page buffers they are read into, swapped with the data of their frame; one per frame at most
+    int numSpare;
+    SM_FileHandle fileHandle; // this and the fields up to polling are used through io
+    bool mapped;
+    bool compressed; // pages of a compressed file move in its page map, so its I/O is never concurrent
     int readNumber;
     int writeNumber;
+    pthread_mutex_t pollLatch; // guards the results of the asynchronous reads and writes of the pool, see awaitIO
+    pthread_cond_t ioDone;     // broadcast with the poll latch held when a thread is done polling the page file
+    bool polling;              // a thread polls the page file for completions
+    int dirtyVictims;             // pages pinPage had to write back itself
+    pthread_mutex_t flushLatch;   // held by forceFlushPool and by each round of the writer, so a flush ends after the writes of a round
+    struct BM_Writer *writer;     // background writer, NULL when the pool has none
+    int prefetchNumber;           // pages of readNumber read by the background loader
+    struct BM_Prefetcher *prefetcher; // background loader, NULL until the pool reads ahead or prefetches pages
+    pthread_mutex_t startLatch;       // held by prefetchPages while it starts the loader
     int framesCount;
+    int k;                          // LRU-K: references remembered per page
+    long clock;                     // LRU-K: pins of the pool so far, the time the histories are kept in
+    int correlatedPeriod;           // LRU-K: see BM_PoolOptions
+    long *historyData;              // LRU-K: history arrays of the frames and of the retained entries
+    BM_RetainedHistory *retained;   // LRU-K: ring of the histories of evicted pages, the oldest one is overwritten
+    int numRetained;                // LRU-K: entries in the ring
+    int nextRetained;               // LRU-K: entry the next evicted page goes to
+    BM_PageTable retainedTable;     // LRU-K: finds the entry of an evicted page in the ring
+    BM_FrequencyBucket *buckets;      // LFU: one bucket more than frames, enough while a frame moves to a new bucket
+    BM_FrequencyBucket *lowestBucket; // LFU: bucket of the least frequently used frames
+    BM_FrequencyBucket *freeBuckets;  // LFU: buckets not in use, chained through next
+    int agingPeriod;                  // LFU: see BM_PoolOptions
+    int pinsSinceAging;
+    BM_ListEntry *listEntries; // ARC, 2Q: one entry per frame followed by the ghost entries
+    BM_List lists[BM_NUM_LISTS];
+    BM_PageTable ghostTable;   // ARC, 2Q: finds the ghost entry of an evicted page
+    int recentTarget;          // ARC: size the recent list is steered to, adapted on ghost hits; 2Q: Kin
 } BM_PoolInfo;
 
+/**
+ * Replacement policy of a pool. pinPage finds pages, fills empty frames, writes back and reads pages itself and
+ * calls the hooks of the policy around it, so a policy only keeps its bookkeeping and names the victims. Every hook
+ * but pickVictim may be NULL. The built in policies are registered under their ReplacementStrategy, others can be
+ * added under unused ids below BM_MAX_POLICIES and passed to initBufferPool in place of a ReplacementStrategy.
+ * The hooks are called with the table latch of the pool held, so a policy needs no locking of its own.
+ * A page read ahead goes through the same hooks as a pinned one, with onUnpin right after onLoad. Other pages may be
+ * missed and loaded between onMiss and onLoad of a page, so what a policy decides on a miss is kept with the frame.
+ */
+typedef struct BM_ReplacementPolicy
+{
+    int strategy;
+    const char *name;
+    RC (*init)(BM_BufferPool *const bm, void *stratData, const BM_PoolOptions *options); // sets up the state of a new pool
+    void (*shutdown)(BM_BufferPool *const bm);                                         // frees that state
+    void (*onHit)(BM_BufferPool *const bm, BM_PageFrame *frame);                        // a page in the pool was pinned
+    void (*onMiss)(BM_BufferPool *const bm, BM_PageFrame *frame, PageNumber pageNum);   // page pageNum not in the pool was requested and got frame, before onEvict
+    BM_PageFrame *(*pickVictim)(BM_BufferPool *const bm, PageNumber pageNum);           // unpinned frame to replace when none is empty, NULL if all are pinned; called before onMiss of pageNum
+    void (*onEvict)(BM_BufferPool *const bm, BM_PageFrame *frame, PageNumber evicted);  // page evicted left frame, which holds the new page or none
+    void (*onLoad)(BM_BufferPool *const bm, BM_PageFrame *frame);                       // a page was read into frame and pinned
+    void (*onUnpin)(BM_BufferPool *const bm, BM_PageFrame *frame);
+} BM_ReplacementPolicy;
+
+#define BM_MAX_POLICIES 16
+
 // convenience macros
 #define MAKE_POOL()					\
 		((BM_BufferPool *) malloc (sizeof(BM_BufferPool)))
@@ -70,6 +244,9 @@ typedef struct BM_PoolInfo
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
 		const int numPages, ReplacementStrategy strategy,
 		void *stratData);
+RC initBufferPoolWithOptions(BM_BufferPool *const bm, const char *const pageFileName,
+		const int numPages, ReplacementStrategy strategy,
+		void *stratData, const BM_PoolOptions *options);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
 
@@ -79,6 +256,13 @@ RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 		const PageNumber pageNum);
+RC latchPage (BM_BufferPool *const bm, BM_PageHandle *const page, bool exclusive);
+RC unlatchPage (BM_BufferPool *const bm, BM_PageHandle *const page);
+RC prefetchPages (BM_BufferPool *const bm, const PageNumber *pageNums, int n);
+
+// Replacement Policies
+RC registerReplacementPolicy (const BM_ReplacementPolicy *policy);
+const BM_ReplacementPolicy *findReplacementPolicy (int strategy);
 
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
@@ -86,5 +270,8 @@ bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+int getNumDirtyVictims (BM_BufferPool *const bm);
+int getNumPrefetchIO (BM_BufferPool *const bm);
+RC getPoolFileStats (BM_BufferPool *const bm, SM_FileStats *stats);
 
 #endif
@@ -2,6 +2,8 @@
 
 #include "record_mgr.h"
 #include "storage_mgr.h"
+#include "page_codec.h"
+#include "log_mgr.h"
 #include "buffer_mgr.h"
 #include "tables.h"
 #include "rm_serializer.c"
@@ -41,6 +43,11 @@ int tuples = 0;
 int recSize; 
 int maxSlotsPerPage; 
 int maxPageDirsPerPage; 
+int tablePageSize = PAGE_SIZE; // page size of new tables
+int tableSegmentPages = 0;      // segment size of new tables, 0 for a single file
+int tableCodec = SM_CODEC_NONE; // codec of new tables
+SM_SyncPolicy tableSyncPolicy;  // durability of opened tables, zeroed is SM_SYNC_NONE
+int tableReadAheadPages = RM_DEFAULT_READ_AHEAD_PAGES; // read ahead of scans of opened tables, 0 for none
 
 void * parseKeyInfo(Schema *schema, char *keyInfo);
 char * serializePageDirectory(PageDirectory *pd);
@@ -56,7 +63,18 @@ Schema *deserializeSchema(char *schemaData);
  * */
 RC initRecordManager(void *mgmtData)
 {
-   return RC_OK;
+    RM_Options *options = mgmtData;
+    tablePageSize = (options != NULL && options->pageSize > 0) ? options->pageSize : PAGE_SIZE;
+    tableSegmentPages = (options != NULL && options->segmentPages > 0) ? options->segmentPages : 0;
+    tableCodec = (options != NULL) ? options->codec : SM_CODEC_NONE;
+    tableReadAheadPages = (options != NULL && options->readAheadPages != 0) ? options->readAheadPages : RM_DEFAULT_READ_AHEAD_PAGES;
+    tableReadAheadPages = (tableReadAheadPages > 0) ? tableReadAheadPages : 0;
+    memset(&tableSyncPolicy, 0, sizeof(tableSyncPolicy));
+    if (options != NULL)
+    {
+        tableSyncPolicy = options->syncPolicy;
+    }
+    return RC_OK;
 }
 
 /**
@@ -74,22 +92,51 @@ RC createTable(char *name, Schema *schema)
     char *schemaInfo = serializeSchema(schema);
     PageDirectory *pd = createPageDirectoryNode(2);
     char *pdInfo = serializePageDirectory(pd);
-    createPageFile(name);
+    SM_CreateOptions layout = {tablePageSize, tableSegmentPages, tableCodec};
+    RC rc = createPageFileWithOptions(name, &layout);
+    if (rc != RC_OK)
+    {
+        free(schemaInfo);
+        free(pd);
+        free(pdInfo);
+        return rc;
+    }
     openPageFile(name, &fHandle);
-    writeBlock(0, &fHandle, schemaInfo);
+    char *pageData = (char *)calloc(fHandle.pageSize, sizeof(char)); // whole pages are written, the strings are shorter
+    strncpy(pageData, schemaInfo, fHandle.pageSize - 1);
+    writeBlock(0, &fHandle, pageData);
     ensureCapacity(2, &fHandle);
-    writeBlock(1, &fHandle, pdInfo);
+    memset(pageData, 0, fHandle.pageSize);
+    strncpy(pageData, pdInfo, fHandle.pageSize - 1);
+    writeBlock(1, &fHandle, pageData);
     closePageFile(&fHandle);
     tuples = 0;
-    recSize = getRecordSize(schema) + sizeof(int) + sizeof(int) + 2 + 2 + 2 + 3 + 1 + 3 + 1; 
-    maxSlotsPerPage = 100; 
-    maxPageDirsPerPage = PAGE_SIZE / strlen(pdInfo);
+    free(pageData);
     free(schemaInfo);
     free(pd);
     free(pdInfo);
+    LOG_INFO("Created table %s with pages of %d bytes", name, tablePageSize);
     return RC_OK;
 }
 
+/**
+ * Method to derive the page layout of a table from its schema and the page size of its file
+ * */
+static void initPageLayout(Schema *schema, int pageSize)
+{
+    PageDirectory *pd = createPageDirectoryNode(2);
+    char *pdInfo = serializePageDirectory(pd);
+    recSize = getRecordSize(schema) + sizeof(int) + sizeof(int) + 2 + 2 + 2 + 3 + 1 + 3 + 1; 
+    maxSlotsPerPage = 100 * (pageSize / PAGE_SIZE); // 100 slots for every PAGE_SIZE bytes of the page
+    if (maxSlotsPerPage > pageSize / recSize) // the slots have to fit into the page
+    {
+        maxSlotsPerPage = pageSize / recSize;
+    }
+    maxPageDirsPerPage = pageSize / strlen(pdInfo);
+    free(pd);
+    free(pdInfo);
+}
+
 /**
  * Method to open table with the specied name and store the information of schema to rm table data
  * */
@@ -98,12 +145,22 @@ RC openTable(RM_TableData *rel, char *name)
     bm = (BM_BufferPool *)malloc(sizeof(BM_BufferPool));
     page = (BM_PageHandle *)malloc(sizeof(BM_PageHandle));
     
-    initBufferPool(bm, name, 100, RS_LRU, NULL);
+    BM_PoolOptions poolOptions = {0};
+    poolOptions.syncPolicy = tableSyncPolicy;
+    poolOptions.readAheadPages = tableReadAheadPages; // next() walks the pages of the table upward
+    RC rc = initBufferPoolWithOptions(bm, name, 100, RS_LRU, NULL, &poolOptions);
+    if (rc != RC_OK)
+    {
+        free(bm);
+        free(page);
+        return rc;
+    }
     pinPage(bm, page, 0);
     rel->name = name;
 
     Schema *schema = deserializeSchema(page->data);
     rel->schema = schema;
+    initPageLayout(schema, bm->pageSize); // the page size comes from the header of the table file
     unpinPage(bm, page);
     pinPage(bm, page, 1);
 
@@ -136,6 +193,7 @@ RC openTable(RM_TableData *rel, char *name)
 
     unpinPage(bm, page);
 
+    LOG_INFO("Opened table %s", name);
     return RC_OK;
 }
 
@@ -176,10 +234,10 @@ RC closeTable(RM_TableData *rel) {
 
     markDirty(bm, page);
     unpinPage(bm, page);
-    forcePage(bm, page);
     free(page);
 
-    shutdownBufferPool(bm);
+    shutdownBufferPool(bm); // writes the page directories and the records changed since they were last written
+    LOG_INFO("Closed table %s", rel->name);
     freeSchema(rel->schema);
     free(pageDirectoryCache);
 
@@ -199,6 +257,18 @@ int getNumTuples(RM_TableData *rel)
     return tuples;
 }
 
+/**
+ * Method to write a page changed by an insert, update or delete right away if the tables are synced after every write.
+ * Otherwise it stays dirty in the pool until it is replaced or the table is closed.
+ * */
+static void forceChangedPage(BM_PageHandle *changed)
+{
+    if (tableSyncPolicy.mode == SM_SYNC_PER_WRITE)
+    {
+        forcePage(bm, changed);
+    }
+}
+
 // table and manager -End
 
 RC insertRecord (RM_TableData *rel, Record *record)
@@ -238,7 +308,7 @@ Schema *schema = rel->schema;
             free(pdStr);
             markDirty(bm, page);
             unpinPage(bm, page);
-            forcePage(bm, page);
+            forceChangedPage(page);
             free(page);
         }
         
@@ -268,7 +338,7 @@ Schema *schema = rel->schema;
     free(recordStr);
     markDirty(bm, page);
     unpinPage(bm, page);
-    forcePage(bm, page);
+    forceChangedPage(page);
     free(page);
     
     lastPD->count = lastPD->count + 1;
@@ -282,20 +352,21 @@ RC deleteRecord(RM_TableData *rel, RID id) {
     PageDirectoryCache *pageDirectoryCache = rel->mgmtData;
     PageDirectory *p = pageDirectoryCache->front;
 
-    pinPage(bm, page, p->pageNum);
     for (; p != NULL; p = p->next) {
         if (p->pageNum == id.page) {
             Record *record = (Record *)malloc(sizeof(Record));
             getRecord(rel, id, record);
             char *recordStr = serializeRecord(record, rel->schema);
+            pinPage(bm, page, id.page); // getRecord unpinned the page again
             strncpy(page->data + (recSize * id.slot), recordStr, recSize);
+            markDirty(bm, page);
+            unpinPage(bm, page);
+            forceChangedPage(page);
+            free(recordStr);
             freeRecord(record);
             break;
         }
     }
-    markDirty(bm, page);
-    unpinPage(bm, page);
-    forcePage(bm, page);
     return RC_OK;
 }
 
@@ -320,7 +391,7 @@ RC updateRecord(RM_TableData *rel, Record *record)
 
         markDirty(bm, page);
         unpinPage(bm, page);
-        forcePage(bm, page);
+        forceChangedPage(page);
 
         free(recordData);
         free(recordStr);
@@ -343,6 +414,7 @@ RC getRecord(RM_TableData *rel, RID id, Record *record)
         if (id.page == p->rid.page && id.slot == p->rid.slot) {
             record->data = (char *)malloc(strlen(p->data) + 1);
             memcpy(record->data, p->data, strlen(p->data) + 1);
+            unpinPage(bm, page); // the record was copied out of the page
             return RC_OK; 
         }
         p = p->next;